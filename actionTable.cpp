@@ -0,0 +1,105 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Table of the commands the nodes accept, indexed by integer.
+*/
+
+#include "../include/actionTable.h"
+#include <sstream>
+
+ActionTable ActionTable::defaults(double speed, double descend_speed, bool diagonals)
+{
+  // Direction of every ActionId, in order (x, y, z, yaw rate)
+  static const double DIRECTIONS[NUM_ACTIONS][4] = {
+    { 0, 1, 0, 0 },  { 0, -1, 0, 0 }, { 1, 0, 0, 0 },  { -1, 0, 0, 0 }, { 0, 0, 0, 0 },  { 0, 0, 0, 0 },
+    { 1, 1, 0, 0 },  { -1, 1, 0, 0 }, { 1, -1, 0, 0 }, { -1, -1, 0, 0 }, { 0, 0, -1, 0 }, { 0, 0, 1, 0 },
+    { 0, 0, 0, 1 },  { 0, 0, 0, -1 }
+  };
+
+  ActionTable table;
+  for (int a = 0; a < NUM_ACTIONS; a++)
+  {
+    double magnitude = a == ACTION_DESCEND ? descend_speed : speed;
+    if (a >= ACTION_LEFT_FORWARD && a <= ACTION_RIGHT_BACKWARD && diagonals == false)
+    {
+      magnitude = 0.0;
+    }
+    table.add(actionName(a), DIRECTIONS[a], magnitude);
+  }
+  const double none[4] = { 0, 0, 0, 0 };
+  table.add("takeoff", none, 0.0);
+  return table;
+}
+
+int ActionTable::add(const std::string &name, const double direction[4], double magnitude)
+{
+  if (index_.count(name) > 0)
+  {
+    return -1;
+  }
+  ActionEntry entry;
+  entry.name = name;
+  entry.kind = name == "takeoff" ? ACTION_KIND_TAKEOFF : name == "land" ? ACTION_KIND_LAND : ACTION_KIND_MOVE;
+  entry.action = actionFromName(name);
+  for (int i = 0; i < 4; i++)
+  {
+    entry.velocity[i] = direction[i] * magnitude;
+  }
+  index_[name] = entries_.size();
+  entries_.push_back(entry);
+  return entries_.size() - 1;
+}
+
+bool ActionTable::load(const std::vector<std::string> &names, const std::vector<double> &directions,
+                       const std::vector<double> &magnitudes, std::string *error)
+{
+  std::ostringstream reason;
+  if (names.empty())
+  {
+    reason << "no actions";
+  }
+  else if (directions.size() != 4 * names.size())
+  {
+    reason << directions.size() << " directions for " << names.size() << " actions, 4 per action expected";
+  }
+  else if (magnitudes.size() != names.size())
+  {
+    reason << magnitudes.size() << " magnitudes for " << names.size() << " actions";
+  }
+
+  ActionTable table;
+  for (size_t i = 0; i < names.size() && reason.str().empty(); i++)
+  {
+    if (table.add(names[i], &directions[4 * i], magnitudes[i]) < 0)
+    {
+      reason << "action " << names[i] << " given twice";
+    }
+  }
+  if (reason.str().empty() == false)
+  {
+    if (error != NULL)
+    {
+      *error = reason.str();
+    }
+    return false;
+  }
+  *this = table;
+  return true;
+}
+
+int ActionTable::find(const std::string &name) const
+{
+  std::unordered_map<std::string, int>::const_iterator it = index_.find(name);
+  return it != index_.end() ? it->second : -1;
+}
+
+size_t ActionTable::getSize() const
+{
+  return entries_.size();
+}
@@ -0,0 +1,42 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Integer identifiers of the actions of the UAV.
+*/
+
+#include "../include/actions.h"
+
+namespace
+{
+const char *const ACTION_NAMES[NUM_ACTIONS] = { "left",          "right",          "forward",      "backward",
+                                                "stop",          "land",           "left_forward", "left_backward",
+                                                "right_forward", "right_backward", "descend",      "ascend",
+                                                "rotate_left",   "rotate_right" };
+}
+
+const char *actionName(int32_t action)
+{
+  if (action < 0 || action >= NUM_ACTIONS)
+  {
+    return NULL;
+  }
+  return ACTION_NAMES[action];
+}
+
+ActionId actionFromName(const std::string &name)
+{
+  for (int a = 0; a < NUM_ACTIONS; a++)
+  {
+    if (name == ACTION_NAMES[a])
+    {
+      return static_cast<ActionId>(a);
+    }
+  }
+  return ACTION_UNKNOWN;
+}
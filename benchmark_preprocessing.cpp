@@ -0,0 +1,93 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Benchmark of the fused frame preprocessing against the original chain of the image callback
+  (copy of the message, conversion to MONO8, resize by 0.2333, crop of the 84x84 region, copy).
+
+  Usage: benchmark_preprocessing [width height iterations]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <opencv2/imgproc/imgproc.hpp>
+#include "../include/framePreprocessor.h"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+  int width = 640, height = 360, iterations = 2000;
+  if (argc == 4)
+  {
+    width = atoi(argv[1]);
+    height = atoi(argv[2]);
+    iterations = atoi(argv[3]);
+  }
+
+  // Synthetic rgb8 frame: smooth ground texture plus noise
+  std::vector<uint8_t> frame(width * height * 3);
+  srand(0);
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width * 3; x++)
+    {
+      frame[y * width * 3 + x] = (uint8_t)((x / 3 + y) / 4 + rand() % 32);
+    }
+  }
+
+  // Original chain
+  cv::Mat src, grey, out;
+  std::vector<uint8_t> message_copy;
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+  {
+    message_copy = frame;
+    src = cv::Mat(height, width, CV_8UC3, &message_copy[0]);
+    cv::cvtColor(src, grey, cv::COLOR_RGB2GRAY);
+    cv::resize(grey, out, cv::Size(), 0.233333333, 0.233333333);
+    cv::Mat croppedRef(out, cv::Rect(33, 0, 84, 84));
+    croppedRef.copyTo(out);
+  }
+  double original_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iterations;
+
+  // Fused kernel
+  FramePreprocessor preprocessor;
+  cv::Mat fused(84, 84, CV_8UC1);
+  start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+  {
+    preprocessor.process(&frame[0], width, height, width * 3, "rgb8", fused.data);
+  }
+  double fused_us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / iterations;
+
+  // The fused kernel averages areas, compare it with the equivalent OpenCV interpolation
+  cv::Mat area;
+  cv::cvtColor(cv::Mat(height, width, CV_8UC3, &frame[0]), grey, cv::COLOR_RGB2GRAY);
+  cv::resize(grey, area, cv::Size(), 0.233333333, 0.233333333, cv::INTER_AREA);
+  cv::Mat diff;
+  cv::absdiff(cv::Mat(area, cv::Rect(33, 0, 84, 84)), fused, diff);
+  double max_diff;
+  cv::minMaxLoc(diff, NULL, &max_diff);
+
+#if defined(__AVX2__)
+  const char *path = "AVX2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const char *path = "NEON";
+#else
+  const char *path = "scalar";
+#endif
+  cout << "Frame: " << width << "x" << height << " rgb8, " << iterations << " iterations" << endl;
+  cout << "Original chain ..... " << original_us << " us/frame" << endl;
+  cout << "Fused (" << path << ") ..... " << fused_us << " us/frame" << endl;
+  cout << "Speed-up ........... " << original_us / fused_us << "x" << endl;
+  cout << "Max difference from INTER_AREA: " << max_diff << endl;
+  return 0;
+}
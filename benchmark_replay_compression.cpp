@@ -0,0 +1,163 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Benchmark of the frame codecs of FrameReplayBuffer on synthetic landing episodes (smooth ground texture and a
+  marker drifting in the 84x84 frame as the UAV moves): bytes per transition, add and sample throughput.
+
+  Usage: benchmark_replay_compression [transitions batch_size iterations]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../include/frameReplayBuffer.h"
+#include "../include/replayBuffer.h"
+
+using namespace std;
+
+namespace
+{
+const int SIZE = 84;
+const int DEPTH = 4;
+
+/*
+  Frame seen from (x, y), in pixels, over a ground made of large patches of similar grey
+*/
+void renderFrame(double x, double y, uint8_t *frame)
+{
+  for (int r = 0; r < SIZE; r++)
+  {
+    for (int c = 0; c < SIZE; c++)
+    {
+      double gx = c + x, gy = r + y;
+      int patch = (int)(floor(gx / 21.0) * 7 + floor(gy / 17.0) * 3);
+      uint8_t value = 110 + (patch & 3) * 6 + ((int)(gx + gy) & 8) / 8;
+      // Marker: 12x12 black and white square at the origin of the ground
+      if (fabs(gx - 42.0) < 6.0 && fabs(gy - 42.0) < 6.0)
+      {
+        value = ((int)floor(gx / 3.0) + (int)floor(gy / 3.0)) % 2 == 0 ? 20 : 235;
+      }
+      frame[r * SIZE + c] = value;
+    }
+  }
+}
+
+/*
+  Add episodes of 40 steps
+
+  @return the seconds spent in the buffer, rendering excluded
+*/
+double fill(FrameReplayBuffer &buffer, size_t transitions)
+{
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> start(-30.0, 30.0), step(-2.0, 2.0);
+  std::vector<uint8_t> frame(SIZE * SIZE);
+  chrono::steady_clock::duration elapsed(0);
+  size_t added = 0;
+  while (added < transitions)
+  {
+    double x = start(generator), y = start(generator);
+    renderFrame(x, y, &frame[0]);
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    buffer.startEpisode(&frame[0]);
+    elapsed += chrono::steady_clock::now() - begin;
+    for (int t = 0; t < 40 && added < transitions; t++, added++)
+    {
+      x += step(generator);
+      y += step(generator);
+      renderFrame(x, y, &frame[0]);
+      begin = chrono::steady_clock::now();
+      buffer.addStep(t % 14, -0.01f, &frame[0], t == 39);
+      elapsed += chrono::steady_clock::now() - begin;
+    }
+  }
+  return chrono::duration<double>(elapsed).count();
+}
+
+void printRow(const string &name, double bytes, double add_rate, double sample_rate)
+{
+  cout << left << setw(32) << name << right << setw(10) << (size_t)bytes << setw(14);
+  if (add_rate > 0)
+  {
+    cout << (size_t)add_rate;
+  }
+  else
+  {
+    cout << "-";
+  }
+  cout << setw(14) << (size_t)sample_rate << endl;
+}
+
+template <typename Buffer>
+double sampleRate(Buffer &buffer, size_t batch_size, int iterations)
+{
+  const size_t size = buffer.getObservationSize();
+  std::vector<uint8_t> images_t(batch_size * size), images_t1(batch_size * size), dones(batch_size);
+  std::vector<int32_t> actions(batch_size);
+  std::vector<float> rewards(batch_size);
+  chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+  {
+    buffer.sample(batch_size, &images_t[0], &actions[0], &rewards[0], &images_t1[0], &dones[0]);
+  }
+  return batch_size * iterations / chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+}
+
+int main(int argc, char **argv)
+{
+  size_t transitions = 100000, batch_size = 32;
+  int iterations = 2000;
+  if (argc == 4)
+  {
+    transitions = atol(argv[1]);
+    batch_size = atol(argv[2]);
+    iterations = atoi(argv[3]);
+  }
+
+  cout << transitions << " transitions of " << SIZE << "x" << SIZE << "x" << DEPTH << ", batches of " << batch_size
+       << endl;
+  cout << left << setw(32) << "Storage" << right << setw(10) << "bytes/tr." << setw(14) << "add tr./s" << setw(14)
+       << "sample tr./s" << endl;
+
+  // Reference: both stacks stored with every transition
+  {
+    ReplayBuffer buffer(transitions, SIZE, SIZE, DEPTH);
+    std::vector<uint8_t> image(SIZE * SIZE * DEPTH);
+    for (size_t i = 0; i < transitions; i++)
+    {
+      buffer.add(&image[0], 0, 0.0f, &image[0], false);
+    }
+    printRow("stacks", buffer.getByteSize() / transitions, 0, sampleRate(buffer, batch_size, iterations));
+  }
+
+  const char *names[] = { "frames (raw)", "frames (LZ4)", "frames (delta+LZ4)" };
+  const FrameCodec codecs[] = { FRAME_RAW, FRAME_LZ4, FRAME_DELTA_LZ4 };
+  const int threads[] = { 1, 0 };
+  for (int c = 0; c < 3; c++)
+  {
+    for (int t = 0; t < (codecs[c] == FRAME_RAW ? 1 : 2); t++)
+    {
+      // Arena large enough for the capacity and not the arena to limit the buffer
+      const size_t arena_bytes = (transitions + transitions / 8) * SIZE * SIZE / 2;
+      FrameReplayBuffer buffer(transitions, SIZE, SIZE, DEPTH, 0, codecs[c], arena_bytes, threads[t]);
+      double seconds = fill(buffer, transitions);
+      // Frames actually stored plus the bookkeeping of every transition
+      double per_transition = (double)buffer.getFrameBytes() / buffer.getSize() + sizeof(uint64_t) * 2 +
+                              sizeof(int32_t) + sizeof(float) + 1;
+      string name = string(names[c]) + (codecs[c] == FRAME_RAW ? "" : threads[t] == 1 ? ", 1 thread" : ", all cores");
+      printRow(name, per_transition, transitions / seconds, sampleRate(buffer, batch_size, iterations));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,162 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Publication of the UAV's commands as soon as they are received, with a hold watchdog.
+*/
+
+#include "../include/commandDispatcher.h"
+#include <algorithm>
+#include <chrono>
+#include "std_msgs/Empty.h"
+
+CommandDispatcher::CommandDispatcher()
+{
+  rate_ = hold_ = 0.0;
+  holding_ = false;
+  running_ = false;
+  last_latency_ = total_latency_ = max_latency_ = 0.0;
+  dispatched_ = 0;
+}
+
+CommandDispatcher::~CommandDispatcher()
+{
+  shutdown();
+}
+
+void CommandDispatcher::init(const ros::Publisher &cmd_pub, const ros::Publisher &takeoff_pub,
+                             const ros::Publisher &land_pub, double rate, double hold)
+{
+  shutdown();
+  cmd_pub_ = cmd_pub;
+  takeoff_pub_ = takeoff_pub;
+  land_pub_ = land_pub;
+  rate_ = std::max(rate, 0.0);
+  hold_ = std::max(hold, 0.0);
+  holding_ = false;
+  if (rate_ > 0.0 || hold_ > 0.0)
+  {
+    running_ = true;
+    watchdog_ = std::thread(&CommandDispatcher::watchdogLoop, this);
+  }
+}
+
+void CommandDispatcher::shutdown()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    holding_ = false;
+  }
+  cond_.notify_all();
+  if (watchdog_.joinable())
+  {
+    watchdog_.join();
+  }
+}
+
+void CommandDispatcher::account(const ros::WallTime &received)
+{
+  last_latency_ = std::max((ros::WallTime::now() - received).toSec(), 0.0);
+  total_latency_ += last_latency_;
+  max_latency_ = std::max(max_latency_, last_latency_);
+  dispatched_++;
+}
+
+void CommandDispatcher::move(const geometry_msgs::Twist &velocity, const ros::WallTime &received)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  cmd_pub_.publish(velocity);
+  account(received);
+
+  if (running_)
+  {
+    const ros::WallTime now = ros::WallTime::now();
+    active_ = velocity;
+    holding_ = true;
+    next_send_ = now + ros::WallDuration(rate_ > 0.0 ? 1.0 / rate_ : 0.0);
+    hold_until_ = now + ros::WallDuration(hold_);
+    cond_.notify_all();
+  }
+}
+
+void CommandDispatcher::takeoff(const ros::WallTime &received)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  takeoff_pub_.publish(std_msgs::Empty());
+  account(received);
+  holding_ = false;
+}
+
+void CommandDispatcher::land(const ros::WallTime &received)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  land_pub_.publish(std_msgs::Empty());
+  account(received);
+  holding_ = false;
+}
+
+void CommandDispatcher::watchdogLoop()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_)
+  {
+    if (holding_ == false)
+    {
+      cond_.wait(lock);
+      continue;
+    }
+
+    const ros::WallTime now = ros::WallTime::now();
+    if (hold_ > 0.0 && now >= hold_until_)
+    {
+      // No new command within the hold time: stop the UAV
+      holding_ = false;
+      cmd_pub_.publish(geometry_msgs::Twist());
+      continue;
+    }
+    if (rate_ > 0.0 && now >= next_send_)
+    {
+      cmd_pub_.publish(active_);
+      // Late wake-ups do not accumulate into bursts of re-sends: when late, the next one is a period from now
+      const ros::WallDuration period(1.0 / rate_);
+      next_send_ = std::max(next_send_ + period, now + period);
+    }
+
+    ros::WallTime wake = hold_ > 0.0 ? hold_until_ : next_send_;
+    if (rate_ > 0.0)
+    {
+      wake = std::min(wake, next_send_);
+    }
+    cond_.wait_for(lock, std::chrono::nanoseconds(std::max<int64_t>((wake - now).toNSec(), 0)));
+  }
+}
+
+double CommandDispatcher::getLastLatency()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_latency_;
+}
+
+double CommandDispatcher::getMeanLatency()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dispatched_ > 0 ? total_latency_ / dispatched_ : 0.0;
+}
+
+double CommandDispatcher::getMaxLatency()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_latency_;
+}
+
+unsigned long CommandDispatcher::getDispatched()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dispatched_;
+}
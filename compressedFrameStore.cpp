@@ -0,0 +1,158 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  FIFO of LZ4 compressed greyscale frames in a circular arena.
+*/
+
+#include "../include/compressedFrameStore.h"
+#include <algorithm>
+#include <lz4.h>
+#include <string.h>
+
+CompressedFrameStore::CompressedFrameStore(FrameCodec codec, size_t frame_size, size_t frame_capacity,
+                                           size_t arena_bytes)
+{
+  codec_ = codec;
+  frame_size_ = frame_size;
+  frame_capacity_ = std::max<size_t>(frame_capacity, 1);
+
+  // The arena has to hold at least the keyframe chains needed to rebuild a few stacks
+  const size_t bound = LZ4_compressBound(frame_size_);
+  arena_.resize(std::max(arena_bytes, 8 * KEYFRAME_INTERVAL * bound));
+  offsets_.resize(frame_capacity_);
+  lengths_.resize(frame_capacity_);
+  keyframes_.resize(frame_capacity_);
+  staging_.resize(frame_size_);
+  previous_.resize(frame_size_);
+  delta_.resize(frame_size_);
+  compressed_.resize(bound);
+  clear();
+}
+
+CompressedFrameStore::~CompressedFrameStore()
+{
+}
+
+uint8_t *CompressedFrameStore::stage()
+{
+  return &staging_[0];
+}
+
+uint64_t CompressedFrameStore::commit(bool episode_start)
+{
+  const uint64_t frame = frames_written_;
+  const size_t s = frame % frame_capacity_;
+  const uint64_t arena_size = arena_.size();
+  bool keyframe = codec_ != FRAME_DELTA_LZ4 || episode_start || frame == 0 ||
+                  frame - keyframes_[(frame - 1) % frame_capacity_] >= (uint64_t)KEYFRAME_INTERVAL;
+
+  uint64_t offset, first_valid;
+  int length;
+  while (true)
+  {
+    const uint8_t *source = &staging_[0];
+    if (keyframe == false)
+    {
+      for (size_t p = 0; p < frame_size_; p++)
+      {
+        delta_[p] = staging_[p] - previous_[p];
+      }
+      source = &delta_[0];
+    }
+    length = LZ4_compress_default(reinterpret_cast<const char *>(source), &compressed_[0], frame_size_,
+                                  compressed_.size());
+
+    // A frame is never split across the end of the arena
+    offset = arena_head_;
+    if (offset % arena_size + length > arena_size)
+    {
+      offset = (offset / arena_size + 1) * arena_size;
+    }
+    // Once the frame is written the arena holds the bytes [end - arena_size, end)
+    const uint64_t end = offset + length;
+    const uint64_t threshold = end > arena_size ? end - arena_size : 0;
+    first_valid = first_valid_;
+    while (first_valid < frame &&
+           (offsets_[first_valid % frame_capacity_] < threshold || frame - first_valid >= frame_capacity_))
+    {
+      first_valid++;
+    }
+    // A difference is useless if the frames it starts from have been dropped
+    if (keyframe || keyframes_[(frame - 1) % frame_capacity_] >= first_valid)
+    {
+      break;
+    }
+    keyframe = true;
+  }
+
+  memcpy(&arena_[offset % arena_size], &compressed_[0], length);
+  offsets_[s] = offset;
+  lengths_[s] = length;
+  keyframes_[s] = keyframe ? frame : keyframes_[(frame - 1) % frame_capacity_];
+  arena_head_ = offset + length;
+  first_valid_ = first_valid;
+  frames_written_++;
+  staging_.swap(previous_);
+  return first_valid_;
+}
+
+uint64_t CompressedFrameStore::getKeyframe(uint64_t frame) const
+{
+  return keyframes_[frame % frame_capacity_];
+}
+
+const uint8_t *CompressedFrameStore::decode(uint64_t first, uint64_t last, std::vector<uint8_t> &frames) const
+{
+  const uint64_t keyframe = keyframes_[first % frame_capacity_];
+  frames.resize((last - keyframe + 1) * frame_size_);
+  for (uint64_t f = keyframe; f <= last; f++)
+  {
+    const size_t s = f % frame_capacity_;
+    uint8_t *out = &frames[(f - keyframe) * frame_size_];
+    LZ4_decompress_safe(&arena_[offsets_[s] % arena_.size()], reinterpret_cast<char *>(out), lengths_[s],
+                        frame_size_);
+    if (keyframes_[s] != f)
+    {
+      const uint8_t *previous = out - frame_size_;
+      for (size_t p = 0; p < frame_size_; p++)
+      {
+        out[p] += previous[p];
+      }
+    }
+  }
+  return &frames[(first - keyframe) * frame_size_];
+}
+
+void CompressedFrameStore::clear()
+{
+  arena_head_ = 0;
+  frames_written_ = 0;
+  first_valid_ = 0;
+}
+
+uint64_t CompressedFrameStore::getFirstValid() const
+{
+  return first_valid_;
+}
+
+size_t CompressedFrameStore::getStoredBytes() const
+{
+  if (first_valid_ == frames_written_)
+  {
+    return 0;
+  }
+  return arena_head_ - offsets_[first_valid_ % frame_capacity_];
+}
+
+size_t CompressedFrameStore::getByteSize() const
+{
+  return arena_.size() + offsets_.size() * sizeof(uint64_t) + lengths_.size() * sizeof(uint32_t) +
+         keyframes_.size() * sizeof(uint64_t) + staging_.size() + previous_.size() + delta_.size() +
+         compressed_.size();
+}
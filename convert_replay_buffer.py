@@ -0,0 +1,76 @@
+#!/usr/bin/env python
+
+# The MIT License (MIT)
+# Copyright (c) 2017 Riccardo Polvara
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+# INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+# FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+# OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+#
+# Convert the pickled buffers saved by ExperienceReplayBuffer into replay files, which are
+# mapped in milliseconds instead of being unpickled (see include/replayFile.h).
+#   python convert_replay_buffer.py replay_buffer.pickle [replay_buffer.drl]
+# The positions of the UAV are not in the pickles and are stored as unknown (NaN).
+import os
+import sys
+import time
+try:
+    import cpickle as pickle
+except:
+    import pickle
+import numpy as np
+import drl_replay
+from native_replay_buffer import ACTION_ID, STRING_TYPES, FLAG_STRING_ACTIONS, FLAG_NO_CHANNEL_AXIS
+
+
+def convert(pickle_path, replay_file_path, chunk_size=1024):
+    """Write the experiences of a pickled buffer in a replay file, oldest first
+
+    @param pickle_path the buffer saved by ExperienceReplayBuffer.save()
+    @param replay_file_path the replay file to create (replaced if it exists)
+    @param chunk_size the number of experiences of a chunk of the replay file
+    @return the number of experiences converted
+    """
+    with open(pickle_path, 'rb') as f:
+        buffer = pickle.load(f)
+    if len(buffer) == 0:
+        drl_replay.ReplayFileWriter(replay_file_path, truncate=True).close()
+        return 0
+
+    image_shape = np.asarray(buffer[0][0]).shape
+    shape = image_shape if len(image_shape) == 3 else image_shape + (1,)
+    writer = drl_replay.ReplayFileWriter(replay_file_path, shape[0], shape[1], shape[2], chunk_size, truncate=True)
+    user_flags = FLAG_NO_CHANNEL_AXIS if len(image_shape) == 2 else 0
+    for image_t, action_t, reward_t, image_t1, done_t1 in buffer:
+        if isinstance(action_t, STRING_TYPES):
+            user_flags |= FLAG_STRING_ACTIONS
+            action_t = ACTION_ID[action_t]
+        writer.append(image_t, int(action_t), float(reward_t), image_t1, bool(done_t1))
+    writer.user_flags = user_flags
+    writer.close()
+    return len(buffer)
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        print("Usage: convert_replay_buffer.py replay_buffer.pickle [replay_buffer.drl]")
+        return 1
+    pickle_path = sys.argv[1]
+    replay_file_path = sys.argv[2] if len(sys.argv) == 3 else os.path.splitext(pickle_path)[0] + ".drl"
+
+    print("Converting " + pickle_path + " into " + replay_file_path)
+    timer_start = time.time()
+    count = convert(pickle_path, replay_file_path)
+    print("Experiences converted: " + str(count) + " in " + str(time.time() - timer_start) + " seconds")
+
+    timer_start = time.time()
+    replay_file = drl_replay.ReplayFile(replay_file_path)
+    print("Replay file opened in " + str((time.time() - timer_start) * 1000.0) + " ms, size: " + str(len(replay_file)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,128 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Curriculum of the spawn distribution driven by the landing success rate.
+*/
+
+#include "../include/curriculumScheduler.h"
+#include <algorithm>
+
+namespace
+{
+// Altitude band capped at the highest altitude of the stage: it is moved down keeping its width, but not below the
+// lowest altitude of the target distribution
+void capBand(double top, double bottom, double *from, double *to)
+{
+  if (*to <= top)
+  {
+    return;
+  }
+  *from = std::max(std::min(*from, top - (*to - *from)), std::min(bottom, top));
+  *to = top;
+}
+}
+
+CurriculumConfig::CurriculumConfig()
+{
+  stages = 1;
+  window = 50;
+  promote_rate = 0.8;
+  demote_rate = 0.3;
+  start_xy_scale = 0.25;
+  start_z = 0.0;
+}
+
+CurriculumScheduler::CurriculumScheduler(const CurriculumConfig &config, const SpawnConfig &target)
+{
+  config_ = config;
+  config_.stages = std::max(config.stages, 1);
+  config_.window = std::max(config.window, 1);
+  target_ = target;
+  stage_ = 0;
+  outcomes_.assign(config_.window, 0);
+  episodes_ = successes_ = 0;
+}
+
+bool CurriculumScheduler::reportEpisode(bool success)
+{
+  uint8_t &slot = outcomes_[episodes_ % outcomes_.size()];
+  if (episodes_ >= outcomes_.size())
+  {
+    successes_ -= slot;
+  }
+  slot = success;
+  successes_ += slot;
+  episodes_++;
+  if (episodes_ < outcomes_.size())
+  {
+    return false;
+  }
+
+  const double rate = getSuccessRate();
+  int stage = stage_;
+  if (rate >= config_.promote_rate && stage_ + 1 < config_.stages)
+  {
+    stage++;
+  }
+  else if (rate < config_.demote_rate && stage_ > 0)
+  {
+    stage--;
+  }
+  if (stage == stage_)
+  {
+    return false;
+  }
+  // The new stage is judged on its own episodes
+  stage_ = stage;
+  episodes_ = successes_ = 0;
+  return true;
+}
+
+SpawnConfig CurriculumScheduler::getSpawnConfig() const
+{
+  if (config_.stages <= 1)
+  {
+    return target_;
+  }
+  const double progress = (double)stage_ / (config_.stages - 1);
+  SpawnConfig spawn = target_;
+  const double xy_scale = config_.start_xy_scale + (1.0 - config_.start_xy_scale) * progress;
+  spawn.xy_stdev *= xy_scale;
+  spawn.xy_half_size *= xy_scale;
+  if (config_.start_z > 0.0)
+  {
+    const double highest = target_.z_bands == 2 ? std::max(target_.z_to, target_.z_to_2) : target_.z_to;
+    const double lowest = target_.z_bands == 2 ? std::min(target_.z_from, target_.z_from_2) : target_.z_from;
+    const double top = config_.start_z + (highest - config_.start_z) * progress;
+    capBand(top, lowest, &spawn.z_from, &spawn.z_to);
+    capBand(top, lowest, &spawn.z_from_2, &spawn.z_to_2);
+  }
+  return spawn;
+}
+
+int CurriculumScheduler::getStage() const
+{
+  return stage_;
+}
+
+int CurriculumScheduler::getNumStages() const
+{
+  return config_.stages;
+}
+
+double CurriculumScheduler::getSuccessRate() const
+{
+  const size_t episodes = std::min(episodes_, outcomes_.size());
+  return episodes == 0 ? 0.0 : (double)successes_ / episodes;
+}
+
+size_t CurriculumScheduler::getEpisodes() const
+{
+  return episodes_;
+}
@@ -0,0 +1,833 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Maintenance of replay files (see include/replayFile.h): count, merge, split, shuffle, rotate, filter, extract and
+  relabel transitions. The inputs are mapped and streamed a batch at a time, so the memory used does not depend on
+  the size of the files, and every batch is copied by a pool of threads. Pickled buffers have to be converted first
+  with convert_replay_buffer.py.
+
+  Usage: drl_buffer_tool [-j threads] [-c chunk_size] [-s seed] <command> <arguments> (see usage())
+*/
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/actions.h"
+#include "../include/replayBuffer.h"
+#include "../include/replayFile.h"
+#include "../include/rewardEngine.h"
+#include "../include/workerPool.h"
+
+using namespace std;
+
+namespace
+{
+// Transitions copied at a time, it bounds the memory used (two observations each)
+const size_t BATCH_SIZE = 256;
+
+const char *const TRANSFORM_NAMES[] = { "90", "180", "270", "vflip", "vflip90", "vflip180", "vflip270" };
+const int NUM_TRANSFORMS = sizeof(TRANSFORM_NAMES) / sizeof(TRANSFORM_NAMES[0]);
+
+struct Options
+{
+  int threads;
+  uint32_t chunk_size;
+  uint64_t seed;
+};
+
+void usage()
+{
+  cerr << "Usage: drl_buffer_tool [-j threads] [-c chunk_size] [-s seed] <command> <arguments>\n"
+          "  -j threads     copying the transitions (default one per core)\n"
+          "  -c chunk_size  of the files created (default the one of the input)\n"
+          "  -s seed        of shuffle and extract (default 0)\n"
+          "Commands:\n"
+          "  count <in>...                  transitions by reward class (1, -1, other), done and action\n"
+          "  merge <out> <in>...            append the inputs to out, created if missing\n"
+          "  split <in> <size> <out>...     consecutive blocks of size transitions, one per output\n"
+          "  shuffle <in> <out>             random permutation of the transitions\n"
+          "  rotate <in> <out> [<t>...]     the transitions followed by copies with the images transformed,\n"
+          "                                 t in 90 180 270 vflip vflip90 vflip180 vflip270 (default all);\n"
+          "                                 actions are kept and positions become unknown\n"
+          "  filter <in> <out> <cond>...    keep the transitions matching every condition:\n"
+          "                                 action=<name|id> reward=<value> done=<0|1> from=<index> to=<index>,\n"
+          "                                 or drop them with -v before the conditions\n"
+          "  extract <in> <out> <count>     append count transitions drawn at random to out, created if missing\n"
+          "  relabel <file> [<key>=<v>...]  recompute rewards and dones in place from the positions, with\n"
+          "                                 policy=<flight_box|landing_box|landing_altitude|land_action>\n"
+          "                                 landing_half_size= landing_height= flight_half_size= flight_height=\n"
+          "                                 step= success= failure= min_altitude= (default those of the node)\n";
+}
+
+string actionLabel(int32_t action, uint32_t user_flags)
+{
+  if ((user_flags & REPLAY_FLAG_ACTION_IDS) && actionName(action) != NULL)
+  {
+    return actionName(action);
+  }
+  return to_string(action);
+}
+
+bool parseAction(const string &text, int32_t *action)
+{
+  *action = actionFromName(text);
+  if (*action != ACTION_UNKNOWN)
+  {
+    return true;
+  }
+  char *end;
+  *action = strtol(text.c_str(), &end, 10);
+  return text.empty() == false && *end == '\0';
+}
+
+bool parseSize(const string &text, size_t *value)
+{
+  char *end;
+  *value = strtoull(text.c_str(), &end, 10);
+  return text.empty() == false && *end == '\0';
+}
+
+bool sameFile(const string &a, const string &b)
+{
+  struct stat status_a, status_b;
+  return stat(a.c_str(), &status_a) == 0 && stat(b.c_str(), &status_b) == 0 && status_a.st_dev == status_b.st_dev &&
+         status_a.st_ino == status_b.st_ino;
+}
+
+bool openInput(ReplayFile &file, const string &path)
+{
+  if (file.open(path) == false)
+  {
+    cerr << path << ": not a replay file" << endl;
+    return false;
+  }
+  return true;
+}
+
+/*
+  Create an output with the shape and flags of input, or continue it
+
+  @param truncate discards the transitions of an existing output
+*/
+bool openOutput(ReplayFileWriter &writer, const string &path, const ReplayFile &input, const string &input_path,
+                const Options &options, bool truncate)
+{
+  if (sameFile(path, input_path))
+  {
+    cerr << path << ": the output cannot be an input" << endl;
+    return false;
+  }
+  uint32_t chunk_size = options.chunk_size > 0 ? options.chunk_size : input.getChunkSize();
+  if (writer.open(path, input.getHeight(), input.getWidth(), input.getDepth(), chunk_size, truncate) == false)
+  {
+    cerr << path << ": cannot be created or it has not the shape of " << input_path << endl;
+    return false;
+  }
+  if (writer.getSize() == 0)
+  {
+    writer.setUserFlags(input.getUserFlags());
+  }
+  else if (writer.getUserFlags() != input.getUserFlags())
+  {
+    cerr << path << ": the actions or images are not encoded as in " << input_path << endl;
+    return false;
+  }
+  return true;
+}
+
+/*
+  Source pixel of every pixel of a square image for a rotation (counterclockwise, as numpy.rot90) of the image
+  or of its vertical flip
+*/
+vector<uint32_t> transformMap(int transform, int side)
+{
+  const bool flip = transform >= 3;
+  const int turns = flip ? transform - 3 : transform + 1;
+  vector<uint32_t> map(side * side);
+  for (int r = 0; r < side; r++)
+  {
+    for (int c = 0; c < side; c++)
+    {
+      // Pixel of the flipped image rotated to (r, c)
+      int sr = r, sc = c;
+      for (int t = 0; t < turns; t++)
+      {
+        int previous = sr;
+        sr = sc;
+        sc = side - 1 - previous;
+      }
+      map[r * side + c] = (flip ? side - 1 - sr : sr) * side + sc;
+    }
+  }
+  return map;
+}
+
+/*
+  Copies transitions from a replay file to a writer, a batch at a time
+*/
+class Copier
+{
+private:
+  WorkerPool pool_;
+  size_t observation_size_;
+  int depth_;
+  vector<uint8_t> images_t_, images_t1_, dones_;
+  vector<int32_t> actions_;
+  vector<float> rewards_, positions_;
+  vector<vector<uint8_t> > scratch_;
+
+  void transform(const vector<uint32_t> &map, uint8_t *image, vector<uint8_t> &scratch) const
+  {
+    scratch.assign(image, image + observation_size_);
+    for (size_t p = 0; p < map.size(); p++)
+    {
+      for (int d = 0; d < depth_; d++)
+      {
+        image[p * depth_ + d] = scratch[map[p] * depth_ + d];
+      }
+    }
+  }
+
+public:
+  explicit Copier(int threads) : pool_(threads), observation_size_(0), depth_(0), scratch_(pool_.getSize())
+  {
+  }
+
+/*
+  @param indices of the transitions, in increasing order when sequential
+  @param sequential releases the chunks of the input once they are copied
+  @param map transforms the images (NULL to copy them), the positions become unknown
+*/
+  bool copy(const ReplayFile &input, const size_t *indices, size_t count, ReplayFileWriter &output, bool sequential,
+            const vector<uint32_t> *map = NULL)
+  {
+    observation_size_ = input.getObservationSize();
+    depth_ = input.getDepth();
+    images_t_.resize(BATCH_SIZE * observation_size_);
+    images_t1_.resize(BATCH_SIZE * observation_size_);
+    actions_.resize(BATCH_SIZE);
+    rewards_.resize(BATCH_SIZE);
+    dones_.resize(BATCH_SIZE);
+    positions_.resize(3 * BATCH_SIZE);
+
+    const size_t chunk_size = input.getChunkSize();
+    for (size_t first = 0; first < count; first += BATCH_SIZE)
+    {
+      const size_t n = min(BATCH_SIZE, count - first);
+      const size_t *batch = indices + first;
+      if (sequential)
+      {
+        input.prefetchChunks(batch[n - 1] / chunk_size + 1, batch[n - 1] / chunk_size + 2);
+      }
+      pool_.run(n,
+                [&](size_t begin, size_t end, int worker) {
+                  input.gather(batch + begin, end - begin, &images_t_[begin * observation_size_], &actions_[begin],
+                               &rewards_[begin], &images_t1_[begin * observation_size_], &dones_[begin],
+                               &positions_[3 * begin]);
+                  if (map != NULL)
+                  {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                      transform(*map, &images_t_[i * observation_size_], scratch_[worker]);
+                      transform(*map, &images_t1_[i * observation_size_], scratch_[worker]);
+                    }
+                  }
+                },
+                8);
+      if (output.appendBatch(&images_t_[0], &actions_[0], &rewards_[0], &images_t1_[0], &dones_[0],
+                             map != NULL ? NULL : &positions_[0], n) == false)
+      {
+        cerr << "Cannot write the output (disk full?)" << endl;
+        return false;
+      }
+      if (sequential)
+      {
+        input.releaseChunks(batch[0] / chunk_size, batch[n - 1] / chunk_size);
+      }
+    }
+    if (sequential && count > 0)
+    {
+      input.releaseChunks(indices[count - 1] / chunk_size, indices[count - 1] / chunk_size + 1);
+    }
+    return true;
+  }
+
+  WorkerPool &getPool()
+  {
+    return pool_;
+  }
+};
+
+vector<size_t> range(size_t begin, size_t end)
+{
+  vector<size_t> indices(end - begin);
+  iota(indices.begin(), indices.end(), begin);
+  return indices;
+}
+
+int count(const vector<string> &arguments, const Options &options)
+{
+  if (arguments.empty())
+  {
+    usage();
+    return 1;
+  }
+  WorkerPool pool(options.threads);
+  for (size_t f = 0; f < arguments.size(); f++)
+  {
+    ReplayFile input;
+    if (openInput(input, arguments[f]) == false)
+    {
+      return 1;
+    }
+
+    // Only the small columns are read, one chunk per job item
+    struct Counts
+    {
+      size_t positive, negative, neutral, done;
+      map<int32_t, size_t> actions;
+    };
+    vector<Counts> counts(pool.getSize(), Counts{ 0, 0, 0, 0, map<int32_t, size_t>() });
+    pool.run(input.getNumChunks(), [&](size_t begin, size_t end, int worker) {
+      Counts &c = counts[worker];
+      for (size_t chunk = begin; chunk < end; chunk++)
+      {
+        const int32_t *actions = reinterpret_cast<const int32_t *>(input.getChunkColumn(chunk, ReplayFile::ACTIONS));
+        const float *rewards = reinterpret_cast<const float *>(input.getChunkColumn(chunk, ReplayFile::REWARDS));
+        const uint8_t *dones = input.getChunkColumn(chunk, ReplayFile::DONES);
+        const size_t rows = min(input.getChunkSize(), input.getSize() - chunk * input.getChunkSize());
+        for (size_t i = 0; i < rows; i++)
+        {
+          c.positive += rewards[i] == 1.0f;
+          c.negative += rewards[i] == -1.0f;
+          c.done += dones[i] != 0;
+          c.actions[actions[i]]++;
+        }
+      }
+    });
+    for (size_t w = 1; w < counts.size(); w++)
+    {
+      counts[0].positive += counts[w].positive;
+      counts[0].negative += counts[w].negative;
+      counts[0].done += counts[w].done;
+      for (map<int32_t, size_t>::const_iterator it = counts[w].actions.begin(); it != counts[w].actions.end(); ++it)
+      {
+        counts[0].actions[it->first] += it->second;
+      }
+    }
+    const Counts &total = counts[0];
+    cout << arguments[f] << ": " << input.getSize() << " transitions of " << input.getHeight() << "x"
+         << input.getWidth() << "x" << input.getDepth() << endl;
+    cout << "  positive " << total.positive << ", negative " << total.negative << ", neutral "
+         << input.getSize() - total.positive - total.negative << ", done " << total.done << endl;
+    cout << "  actions";
+    for (map<int32_t, size_t>::const_iterator it = total.actions.begin(); it != total.actions.end(); ++it)
+    {
+      cout << " " << actionLabel(it->first, input.getUserFlags()) << " " << it->second;
+    }
+    cout << endl;
+  }
+  return 0;
+}
+
+int merge(const vector<string> &arguments, const Options &options)
+{
+  if (arguments.size() < 2)
+  {
+    usage();
+    return 1;
+  }
+  Copier copier(options.threads);
+  ReplayFileWriter output;
+  for (size_t f = 1; f < arguments.size(); f++)
+  {
+    ReplayFile input;
+    if (openInput(input, arguments[f]) == false ||
+        (output.isOpen() == false && openOutput(output, arguments[0], input, arguments[f], options, false) == false))
+    {
+      return 1;
+    }
+    if (sameFile(arguments[0], arguments[f]) || input.getObservationSize() != output.getObservationSize() ||
+        input.getUserFlags() != output.getUserFlags())
+    {
+      cerr << arguments[f] << ": cannot be appended to " << arguments[0] << endl;
+      return 1;
+    }
+    vector<size_t> indices = range(0, input.getSize());
+    if (copier.copy(input, indices.data(), indices.size(), output, true) == false)
+    {
+      return 1;
+    }
+    cout << arguments[f] << ": " << input.getSize() << " transitions appended" << endl;
+  }
+  cout << arguments[0] << ": " << output.getSize() << " transitions" << endl;
+  return 0;
+}
+
+int split(const vector<string> &arguments, const Options &options)
+{
+  size_t size;
+  if (arguments.size() < 3 || parseSize(arguments[1], &size) == false || size == 0)
+  {
+    usage();
+    return 1;
+  }
+  ReplayFile input;
+  if (openInput(input, arguments[0]) == false)
+  {
+    return 1;
+  }
+  Copier copier(options.threads);
+  size_t first = 0;
+  for (size_t f = 2; f < arguments.size() && first < input.getSize(); f++)
+  {
+    ReplayFileWriter output;
+    if (openOutput(output, arguments[f], input, arguments[0], options, true) == false)
+    {
+      return 1;
+    }
+    vector<size_t> indices = range(first, min(first + size, input.getSize()));
+    if (copier.copy(input, indices.data(), indices.size(), output, true) == false)
+    {
+      return 1;
+    }
+    cout << arguments[f] << ": " << output.getSize() << " transitions" << endl;
+    first += indices.size();
+  }
+  if (first < input.getSize())
+  {
+    cout << input.getSize() - first << " transitions left out, more outputs are needed" << endl;
+  }
+  return 0;
+}
+
+int shuffle(const vector<string> &arguments, const Options &options)
+{
+  if (arguments.size() != 2)
+  {
+    usage();
+    return 1;
+  }
+  ReplayFile input;
+  ReplayFileWriter output;
+  if (openInput(input, arguments[0]) == false ||
+      openOutput(output, arguments[1], input, arguments[0], options, true) == false)
+  {
+    return 1;
+  }
+  vector<size_t> indices = range(0, input.getSize());
+  std::mt19937_64 generator(options.seed);
+  std::shuffle(indices.begin(), indices.end(), generator);
+  Copier copier(options.threads);
+  if (copier.copy(input, indices.data(), indices.size(), output, false) == false)
+  {
+    return 1;
+  }
+  cout << arguments[1] << ": " << output.getSize() << " transitions" << endl;
+  return 0;
+}
+
+int rotate(const vector<string> &arguments, const Options &options)
+{
+  if (arguments.size() < 2)
+  {
+    usage();
+    return 1;
+  }
+  vector<int> transforms;
+  for (size_t a = 2; a < arguments.size(); a++)
+  {
+    const char *const *name = find(TRANSFORM_NAMES, TRANSFORM_NAMES + NUM_TRANSFORMS, arguments[a]);
+    if (name == TRANSFORM_NAMES + NUM_TRANSFORMS)
+    {
+      cerr << arguments[a] << ": unknown transform" << endl;
+      return 1;
+    }
+    transforms.push_back(name - TRANSFORM_NAMES);
+  }
+  if (transforms.empty())
+  {
+    for (int t = 0; t < NUM_TRANSFORMS; t++)
+    {
+      transforms.push_back(t);
+    }
+  }
+
+  ReplayFile input;
+  ReplayFileWriter output;
+  if (openInput(input, arguments[0]) == false ||
+      openOutput(output, arguments[1], input, arguments[0], options, true) == false)
+  {
+    return 1;
+  }
+  if (input.getHeight() != input.getWidth())
+  {
+    cerr << arguments[0] << ": only square images can be rotated" << endl;
+    return 1;
+  }
+  Copier copier(options.threads);
+  vector<size_t> indices = range(0, input.getSize());
+  if (copier.copy(input, indices.data(), indices.size(), output, true) == false)
+  {
+    return 1;
+  }
+  for (size_t t = 0; t < transforms.size(); t++)
+  {
+    vector<uint32_t> map = transformMap(transforms[t], input.getHeight());
+    if (copier.copy(input, indices.data(), indices.size(), output, true, &map) == false)
+    {
+      return 1;
+    }
+  }
+  cout << arguments[1] << ": " << output.getSize() << " transitions" << endl;
+  return 0;
+}
+
+int filter(const vector<string> &arguments, const Options &options)
+{
+  if (arguments.size() < 3)
+  {
+    usage();
+    return 1;
+  }
+  ReplayFile input;
+  ReplayFileWriter output;
+  if (openInput(input, arguments[0]) == false ||
+      openOutput(output, arguments[1], input, arguments[0], options, true) == false)
+  {
+    return 1;
+  }
+
+  bool drop = false, match_action = false, match_reward = false, match_done = false;
+  int32_t action = 0;
+  float reward = 0.0f;
+  size_t done = 0, from = 0, to = input.getSize();
+  for (size_t a = 2; a < arguments.size(); a++)
+  {
+    const string &condition = arguments[a];
+    const size_t equal = condition.find('=');
+    const string key = condition.substr(0, equal), value = equal == string::npos ? "" : condition.substr(equal + 1);
+    char *end;
+    bool valid = true;
+    if (condition == "-v")
+    {
+      drop = true;
+    }
+    else if (key == "action")
+    {
+      match_action = valid = parseAction(value, &action);
+    }
+    else if (key == "reward")
+    {
+      reward = strtof(value.c_str(), &end);
+      match_reward = valid = value.empty() == false && *end == '\0';
+    }
+    else if (key == "done")
+    {
+      match_done = valid = parseSize(value, &done) && done <= 1;
+    }
+    else if (key == "from")
+    {
+      valid = parseSize(value, &from);
+    }
+    else if (key == "to")
+    {
+      valid = parseSize(value, &to);
+    }
+    else
+    {
+      valid = false;
+    }
+    if (valid == false)
+    {
+      cerr << condition << ": invalid condition" << endl;
+      return 1;
+    }
+  }
+  to = min(to, input.getSize());
+
+  // Select on the small columns, chunk by chunk in parallel, then copy the transitions selected in order
+  Copier copier(options.threads);
+  vector<vector<size_t> > selected(input.getNumChunks());
+  copier.getPool().run(input.getNumChunks(), [&](size_t begin, size_t end, int) {
+    for (size_t chunk = begin; chunk < end; chunk++)
+    {
+      const int32_t *actions = reinterpret_cast<const int32_t *>(input.getChunkColumn(chunk, ReplayFile::ACTIONS));
+      const float *rewards = reinterpret_cast<const float *>(input.getChunkColumn(chunk, ReplayFile::REWARDS));
+      const uint8_t *dones = input.getChunkColumn(chunk, ReplayFile::DONES);
+      const size_t base = chunk * input.getChunkSize();
+      const size_t rows = min(input.getChunkSize(), input.getSize() - base);
+      for (size_t i = 0; i < rows; i++)
+      {
+        bool match = base + i >= from && base + i < to && (match_action == false || actions[i] == action) &&
+                     (match_reward == false || rewards[i] == reward) && (match_done == false || dones[i] == done);
+        if (match != drop)
+        {
+          selected[chunk].push_back(base + i);
+        }
+      }
+    }
+  });
+  vector<size_t> indices;
+  for (size_t chunk = 0; chunk < selected.size(); chunk++)
+  {
+    indices.insert(indices.end(), selected[chunk].begin(), selected[chunk].end());
+    vector<size_t>().swap(selected[chunk]);
+  }
+  if (copier.copy(input, indices.data(), indices.size(), output, true) == false)
+  {
+    return 1;
+  }
+  cout << arguments[1] << ": " << output.getSize() << " transitions kept, " << input.getSize() - output.getSize()
+       << " removed" << endl;
+  return 0;
+}
+
+int extract(const vector<string> &arguments, const Options &options)
+{
+  size_t count;
+  if (arguments.size() != 3 || parseSize(arguments[2], &count) == false)
+  {
+    usage();
+    return 1;
+  }
+  ReplayFile input;
+  ReplayFileWriter output;
+  if (openInput(input, arguments[0]) == false ||
+      openOutput(output, arguments[1], input, arguments[0], options, false) == false)
+  {
+    return 1;
+  }
+  if (count > input.getSize())
+  {
+    cerr << arguments[0] << ": only " << input.getSize() << " transitions" << endl;
+    return 1;
+  }
+  vector<size_t> indices(count), scratch;
+  std::mt19937_64 generator(options.seed);
+  sampleDistinct(generator, input.getSize(), count, indices.data(), scratch);
+  // Read the file in order, the transitions drawn keep their relative order
+  sort(indices.begin(), indices.end());
+  Copier copier(options.threads);
+  if (copier.copy(input, indices.data(), indices.size(), output, true) == false)
+  {
+    return 1;
+  }
+  cout << arguments[1] << ": " << output.getSize() << " transitions" << endl;
+  return 0;
+}
+
+int relabel(const vector<string> &arguments, const Options &options)
+{
+  if (arguments.empty())
+  {
+    usage();
+    return 1;
+  }
+  RewardConfig config;
+  for (size_t a = 1; a < arguments.size(); a++)
+  {
+    const string &setting = arguments[a];
+    const size_t equal = setting.find('=');
+    const string key = setting.substr(0, equal), value = equal == string::npos ? "" : setting.substr(equal + 1);
+    char *end;
+    const double number = strtod(value.c_str(), &end);
+    bool valid = value.empty() == false && *end == '\0';
+    if (key == "policy")
+    {
+      valid = parseRewardPolicy(value, &config.policy);
+    }
+    else if (key == "landing_half_size")
+    {
+      config.landing_half_size = number;
+    }
+    else if (key == "landing_height")
+    {
+      config.landing_height = number;
+    }
+    else if (key == "flight_half_size")
+    {
+      config.flight_half_size = number;
+    }
+    else if (key == "flight_height")
+    {
+      config.flight_height = number;
+    }
+    else if (key == "step")
+    {
+      config.step_reward = number;
+    }
+    else if (key == "success")
+    {
+      config.success_reward = number;
+    }
+    else if (key == "failure")
+    {
+      config.failure_reward = number;
+    }
+    else if (key == "min_altitude")
+    {
+      config.min_altitude = number;
+    }
+    else
+    {
+      valid = false;
+    }
+    if (valid == false)
+    {
+      cerr << setting << ": invalid setting" << endl;
+      return 1;
+    }
+  }
+
+  ReplayFile file;
+  if (file.open(arguments[0], 0, true) == false)
+  {
+    cerr << arguments[0] << ": not a writable replay file" << endl;
+    return 1;
+  }
+  if (config.policy == REWARD_LAND_ACTION && (file.getUserFlags() & REPLAY_FLAG_ACTION_IDS) == 0)
+  {
+    cerr << arguments[0] << ": the actions are not stored as ids, " << rewardPolicyName(config.policy)
+         << " cannot be evaluated" << endl;
+    return 1;
+  }
+
+  // One chunk per job item, its columns are rewritten in place
+  const RewardEngine engine(config);
+  WorkerPool pool(options.threads);
+  struct Counts
+  {
+    size_t relabelled, changed;
+    vector<float> rewards;
+    vector<uint8_t> dones;
+  };
+  vector<Counts> counts(pool.getSize(), Counts{ 0, 0, vector<float>(), vector<uint8_t>() });
+  pool.run(file.getNumChunks(), [&](size_t begin, size_t end, int worker) {
+    Counts &c = counts[worker];
+    for (size_t chunk = begin; chunk < end; chunk++)
+    {
+      const float *positions = reinterpret_cast<const float *>(file.getChunkColumn(chunk, ReplayFile::POSITIONS));
+      const int32_t *actions = reinterpret_cast<const int32_t *>(file.getChunkColumn(chunk, ReplayFile::ACTIONS));
+      float *rewards = reinterpret_cast<float *>(file.getMutableChunkColumn(chunk, ReplayFile::REWARDS));
+      uint8_t *dones = file.getMutableChunkColumn(chunk, ReplayFile::DONES);
+      const size_t rows = min(file.getChunkSize(), file.getSize() - chunk * file.getChunkSize());
+      c.rewards.assign(rewards, rewards + rows);
+      c.dones.assign(dones, dones + rows);
+      c.relabelled += engine.relabel(positions, actions, rows, rewards, dones);
+      for (size_t i = 0; i < rows; i++)
+      {
+        c.changed += rewards[i] != c.rewards[i] || dones[i] != c.dones[i];
+      }
+    }
+  });
+  if (file.sync() == false)
+  {
+    cerr << arguments[0] << ": cannot be written" << endl;
+    return 1;
+  }
+  size_t relabelled = 0, changed = 0;
+  for (size_t w = 0; w < counts.size(); w++)
+  {
+    relabelled += counts[w].relabelled;
+    changed += counts[w].changed;
+  }
+  cout << arguments[0] << ": " << relabelled << " transitions relabelled with " << rewardPolicyName(config.policy)
+       << ", " << changed << " changed, " << file.getSize() - relabelled << " kept (position unknown)" << endl;
+  return 0;
+}
+}
+
+int main(int argc, char **argv)
+{
+  Options options = { 0, 0, 0 };
+  int a = 1;
+  for (; a + 1 < argc && argv[a][0] == '-'; a += 2)
+  {
+    const string option = argv[a];
+    if (option == "-j")
+    {
+      options.threads = atoi(argv[a + 1]);
+    }
+    else if (option == "-c")
+    {
+      options.chunk_size = atoi(argv[a + 1]);
+    }
+    else if (option == "-s")
+    {
+      options.seed = strtoull(argv[a + 1], NULL, 10);
+    }
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+  if (a >= argc)
+  {
+    usage();
+    return 1;
+  }
+  const string command = argv[a];
+  const vector<string> arguments(argv + a + 1, argv + argc);
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  int result;
+  if (command == "count")
+  {
+    result = count(arguments, options);
+  }
+  else if (command == "merge")
+  {
+    result = merge(arguments, options);
+  }
+  else if (command == "split")
+  {
+    result = split(arguments, options);
+  }
+  else if (command == "shuffle")
+  {
+    result = shuffle(arguments, options);
+  }
+  else if (command == "rotate")
+  {
+    result = rotate(arguments, options);
+  }
+  else if (command == "filter")
+  {
+    result = filter(arguments, options);
+  }
+  else if (command == "extract")
+  {
+    result = extract(arguments, options);
+  }
+  else if (command == "relabel")
+  {
+    result = relabel(arguments, options);
+  }
+  else
+  {
+    usage();
+    return 1;
+  }
+  if (result == 0)
+  {
+    cerr << command << " done in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s"
+         << endl;
+  }
+  return result;
+}
@@ -12,10 +12,28 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string>
+#include <vector>
 #include <map>
-#include "../include/boundingBox.h"
-#include "../include/utilities.h"
+#include <algorithm>
+#include "../include/actions.h"
+#include "../include/actionTable.h"
+#include "../include/rewardEngine.h"
+#include "../include/landingPads.h"
+#include "../include/spawnSampler.h"
+#include "../include/curriculumScheduler.h"
+#include "../include/resetManager.h"
+#include "../include/commandDispatcher.h"
+#include "../include/gazeboStepper.h"
+#include "../include/modelStateCache.h"
+#include "../include/framePreprocessor.h"
+#include "../include/frameStack.h"
+#include "../include/sharedMemoryChannel.h"
+#include "../include/transitionRecorder.h"
+#include "../include/snapshotBuffer.h"
+#include "../include/latencyHistogram.h"
+#include "../include/traceRecorder.h"
 #include "ardrone_autonomy/Navdata.h"
+#include "diagnostic_msgs/DiagnosticArray.h"
 #include "gazebo_msgs/GetModelState.h"
 #include "gazebo_msgs/ModelState.h"
 #include "gazebo_msgs/SetModelState.h"
@@ -31,26 +49,78 @@
 #include <tf/transform_datatypes.h>
 #include <cv_bridge/cv_bridge.h>
 #include <image_transport/image_transport.h>
+#include <ros/callback_queue.h>
+#include <ros/spinner.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 
 #include "deep_reinforced_landing/GetCameraImage.h"
 #include "deep_reinforced_landing/NewCameraService.h"
 #include "deep_reinforced_landing/GetDoneAndReward.h"
 #include "deep_reinforced_landing/ResetPosition.h"
+#include "deep_reinforced_landing/ResetEnvironment.h"
 #include "deep_reinforced_landing/SendCommand.h"
+#include "deep_reinforced_landing/SendAction.h"
 #include "deep_reinforced_landing/GetRelativePose.h"
-
+#include "deep_reinforced_landing/GetCurriculumStage.h"
+#include "deep_reinforced_landing/Step.h"
+#include "deep_reinforced_landing/GetFrameStack.h"
+#include "deep_reinforced_landing/GetLatencyStats.h"
 
 const int LANDED_STATUS = 2;
 
 using namespace std;
 using namespace cv;
 
+// Outcome of a reward evaluation, published as a whole for the queries
+struct TickSnapshot
+{
+  uint64_t tick;
+  float reward;
+  bool done;
+  bool wrong_altitude;
+  // Position of the UAV wrt the marker
+  double relative[3];
+};
+
+// Stages of the hot path timed by the latency histograms, also the names of their spans in the traces
+enum Stage
+{
+  // Pose of the quadrotor: synchronous GetModelState in lockstep mode, model states cache otherwise
+  STAGE_STATE_FETCH = 0,
+  // Pads and reward boxes around the marker
+  STAGE_MARKER,
+  // Reward evaluation, recording and publication of the outcome
+  STAGE_REWARD,
+  STAGE_IMAGE_CALLBACK,
+  // drl/send_command and drl/send_action handlers
+  STAGE_COMMAND_SERVICE,
+  // drl/step handler, from the request to the response
+  STAGE_STEP_SERVICE,
+  STAGE_RESET,
+  // Lockstep physics iterations and wait for their frame
+  STAGE_PHYSICS,
+  // Work of an iteration of the main loop, without its sleep
+  STAGE_LOOP,
+  NUM_STAGES
+};
+
+const char *const STAGE_NAMES[NUM_STAGES] = { "state_fetch",  "marker", "reward",  "image_callback", "command_service",
+                                              "step_service", "reset",  "physics", "loop" };
+
 // Node class for deep reinforced landing
 class DeepReinforcedLanding
 {
 private:
 
   ros::NodeHandle nh_;
+  // Callbacks are served by one thread per role, so that none of them waits for the others: the camera, the
+  // commands and resets, the state/reward queries. The global queue is left to the model states and the main loop.
+  ros::NodeHandle nh_image_, nh_control_, nh_services_;
+  ros::CallbackQueue image_queue_, control_queue_, services_queue_;
+  std::unique_ptr<ros::AsyncSpinner> image_spinner_, control_spinner_, services_spinner_;
   // Create a subscriber for getting the UAV's latests status
   ros::Subscriber uav_sub_;
   //Subscribe to the bottom camera's topic
@@ -63,23 +133,39 @@ private:
   ros::Publisher reset_model_pub_;
   // Publisher for a greyscale/resized image
   ros::Publisher greyscale_camera_pub_;
+  // Publisher of the latency percentiles and counters (/drl/diagnostics)
+  ros::Publisher diagnostics_pub_;
 
-  // Create a client for getting quadrotor and marker's positions
-  ros::ServiceClient get_state_client_;
+  // Latest poses of quadrotor and marker, kept up to date by /gazebo/model_states
+  ModelStateCache state_cache_;
 
   // Create a service for offering the done and reward
   ros::ServiceServer service_done_reward_;
   // Create a service for getting the quadrotor pose wrt the markers' one
   ros::ServiceServer service_relative_pose_;
+  // Create a service for getting the stage of the spawn curriculum
+  ros::ServiceServer service_curriculum_;
+  // Create a service for getting the latency percentiles of every stage
+  ros::ServiceServer service_latency_;
   // Create a service for offering the full camera's image or only the matrix
   ros::ServiceServer service_camera_;
   ros::ServiceServer service_camera_matrix_;
+  ros::ServiceServer service_camera_stack_;
   //Create a service to invoke control's publisher (cmd_pub_, land_pub_, takeoff_pub_)
   ros::ServiceServer service_send_command_;
+  ros::ServiceServer service_send_action_;
   // Create a service for getting the reset request...
   ros::ServiceServer service_reset_;
-  // ...and then call the service offered by gazebo
-  ros::ServiceClient set_state_client_;
+  // ...and then move the UAV and the grounds through the reset manager
+  ResetManager reset_manager_;
+  // Create a service that resets the episode at once, optionally changing the ground
+  ros::ServiceServer service_reset_environment_;
+  // Create a service that applies a command and returns the outcome in one call.
+  // It is served from its own queue so that it can wait for the main loop.
+  ros::NodeHandle nh_step_;
+  ros::CallbackQueue step_queue_;
+  std::unique_ptr<ros::AsyncSpinner> step_spinner_;
+  ros::ServiceServer service_step_;
   
 
   //--------Callbacks and Services-----
@@ -95,7 +181,7 @@ private:
 
   @param msg is the latest frame acquired by the camera
 */
-//  void getImageCallback(const sensor_msgs::Image &msg);
+  void getImageCallback(const sensor_msgs::ImageConstPtr &msg);
 
 /*
   Get UAV's pose
@@ -123,6 +209,15 @@ private:
 */
   bool getNewCamera(deep_reinforced_landing::NewCameraService::Request &req,
                     deep_reinforced_landing::NewCameraService::Response &res);
+
+/*
+  Get the stacked observation fed to the Q-network
+
+  @param req is an empty message
+  @param res is the height x width x depth block of the frames observed at the last actions plus the latest one
+*/
+  bool getCameraImageStack(deep_reinforced_landing::GetFrameStack::Request &req,
+                           deep_reinforced_landing::GetFrameStack::Response &res);
 /*
   Set new UAV's pose
 
@@ -133,7 +228,16 @@ private:
                      deep_reinforced_landing::ResetPosition::Response &res);
 
 /*
-  Send a new command to the UAV
+  Respawn the UAV and show a ground variant in one batched operation, without waiting for the main loop
+
+  @param req is the index of the ground in /drl_node/grounds, -1 for a random one, -2 to keep the current one
+  @param res contains the ground in view, the new pose of the UAV and the latency of the reset
+*/
+  bool resetEnvironment(deep_reinforced_landing::ResetEnvironment::Request &req,
+                        deep_reinforced_landing::ResetEnvironment::Response &res);
+
+/*
+  Send a new command to the UAV, ignored while the action of a step request is being repeated
 
   @param req is a string representing the command to send to the UAV (left,right, ascend, descend, forward,backward, rotate_left, rotate_right, takeoff, land
   @param res is an empty message
@@ -141,15 +245,104 @@ private:
   bool sendCommand(deep_reinforced_landing::SendCommand::Request &req,
                    deep_reinforced_landing::SendCommand::Response &res);
 
+/*
+  Send a new command to the UAV by its index in the action table
+
+  @param req is the index of the action (/drl_node/action_names)
+  @param res is false if the index is not in the table, the UAV is stopped instead, or if the action of a step
+  request is being repeated, the action is ignored
+*/
+  bool sendAction(deep_reinforced_landing::SendAction::Request &req,
+                  deep_reinforced_landing::SendAction::Response &res);
+
   bool getRelativePose(deep_reinforced_landing::GetRelativePose::Request &req,
                         deep_reinforced_landing::GetRelativePose::Response &res);
 
-  void setActionCommand(std::string action);
+/*
+  Get the stage of the spawn curriculum
+
+  @param req is an empty message
+  @param res contains the stage, the success rate it is judged on and its spawn distribution
+*/
+  bool getCurriculumStage(deep_reinforced_landing::GetCurriculumStage::Request &req,
+                          deep_reinforced_landing::GetCurriculumStage::Response &res);
+
+/*
+  Apply a command, wait for the following reward evaluation and return everything in one response. With an action
+  repeat the command is kept for that many evaluations, until done, and their rewards are summed.
+
+  @param req is the command to send to the UAV (same strings accepted by sendCommand) and its repeat
+  @param res contains reward, done, wrong_altitude, the pose wrt the marker and the 84x84 greyscale frame (the
+  maximum of the last two frames of a repeat)
+*/
+  bool step(deep_reinforced_landing::Step::Request &req,
+            deep_reinforced_landing::Step::Response &res);
+
+/*
+  Get the latency percentiles of every stage and the counters of the hot path
+
+  @param req contains the percentiles wanted and whether the records are discarded afterwards
+  @param res contains, per stage, the number of records, mean, max and percentiles in milliseconds
+*/
+  bool getLatencyStats(deep_reinforced_landing::GetLatencyStats::Request &req,
+                       deep_reinforced_landing::GetLatencyStats::Response &res);
+
+/*
+  Translate an action into velocities and flags read by the main loop
+
+  @param id is the index of the action in the table, any other value stops the UAV
+*/
+  void applyAction(int id);
+
+/*
+  Write the outcome of the last reward evaluation and the frame stack in the shared-memory ring (state_mutex_ held)
+*/
+  void publishObservation();
+
+/*
+  Begin the transition of an action with the observation on which it has been chosen (main loop thread)
+
+  @param action is the action applied, only the actions of actions.h are recorded
+*/
+  void recordAction(ActionId action);
+
+/*
+  End the transition begun by recordAction with the outcome of the reward evaluation (state_mutex_ held)
+*/
+  void recordOutcome();
+
+/*
+  Count the evaluation just made against the action repeat of the step request being applied (state_mutex_ held).
+  When the repeat is over, its frame is pooled and the request is answered.
+
+  @return true if the action is kept for another evaluation
+*/
+  bool repeatAction();
+
+/*
+  Record the latency of a stage which began at start (LatencyHistogram::now()) and, when tracing, its span
+
+  @param arg is shown with the span (the step request, the tick or the frame)
+*/
+  void endStage(Stage stage, int64_t start, uint64_t arg = 0);
+/*
+  Look up the poses of the markers in the model states and move their pads. Until every marker has been seen all
+  of them are looked up, then a single one per call: the pads are static and a tick does not cost more with them.
+*/
+  void updatePads();
+
+/*
+  Apply a reset through the reset manager and begin a new episode
+
+  @param model_state is the new state of the UAV
+  @param ground is the index of the ground, GROUND_RANDOM or GROUND_KEEP
+  @return false if Gazebo did not accept the reset
+*/
+  bool resetEpisode(const gazebo_msgs::ModelState &model_state, int ground);
 
 
   //-------Data-----------
-  // Server for getting UAV's pose and various related variables
-  gazebo_msgs::GetModelState srv_;
+  // UAV's pose and various related variables
   geometry_msgs::Pose quadrotorPose_, markerPose_, quadrotor_to_marker_pose_;
   geometry_msgs::Pose start_pose_;
   geometry_msgs::Twist start_twist_;
@@ -158,33 +351,108 @@ private:
   // Half side for the landing BB and the flight one
   double bb_landing_half_size_, bb_flight_half_size_;
   double bb_landing_height_, bb_flight_height_;
-  BoundingBox bb_landing_, bb_flight_;
+  // Reward and done given the boxes around the marker, policy chosen by /drl_node/reward_policy
+  RewardEngine reward_engine_;
+  // Marker's position used for the current bounding boxes
+  geometry_msgs::Point bb_origin_;
+  bool bb_valid_;
+  // Landing pads of the world (/drl_node/markers), the UAV is referred to the one it is over or the nearest
+  std::vector<std::string> marker_names_;
+  // Pad of every marker, -1 until its pose is known
+  std::vector<int> marker_pads_;
+  LandingPads pads_;
+  size_t next_marker_;
   double respawn_height;
-  std::string xy_gaussian_uniform;
-  double xy_gaussian_mean;
-  double xy_gaussian_stdev;
-  int num_z_uniform;
-  double z_uniform_from, z_uniform_from_2;
-  double z_uniform_to, z_uniform_to_2;
+  // Respawn poses, reproducible from /drl_node/seed
+  SpawnSampler spawn_sampler_;
+  // Spawn distribution widened as the landings succeed (/drl_node/curriculum_*)
+  CurriculumScheduler curriculum_;
+  // The end of the current episode has been given to the curriculum
+  bool episode_reported_;
+
+  // Outcome of the last reward evaluation and latest frame (stamp and pixels), read by the queries without locks
+  SnapshotBuffer<TickSnapshot> tick_snapshot_;
+  SnapshotBuffer<double> frame_snapshot_;
 
   // Reinforcement Learning data
   bool done_;
   float reward_;
   bool reset_;
-  std::string action_;
+  ActionId action_;
+  bool wrong_altitude_;
+  // Velocities of the commands, indexed by the integer of drl/send_action (/drl_node/action_*)
+  ActionTable actions_;
+
+  // Synchronisation between the callback threads and the main loop, it guards all the data of the episode
+  std::mutex state_mutex_;
+  std::condition_variable tick_cond_;
+  // Signalled by the image callback at every new frame
+  std::condition_variable frame_cond_;
+  unsigned long tick_;
+  // Index of the action of the pending step request, -1 if its command is not in the table
+  int step_action_;
+  bool has_step_command_;
+  unsigned long step_requested_id_, step_applied_id_, step_finished_id_;
+  // Action repeat of the step requests: evaluations requested and still to go
+  unsigned int step_repeat_, step_repeat_left_;
+  // Rewards summed and evaluations made since the last action was applied
+  float action_reward_;
+  unsigned int action_evaluations_;
+  // Frame of the previous evaluation of a repeated action, and frame of the answer (the maximum of the last two)
+  cv::Mat step_prev_frame_, step_frame_;
+
+  // Latency of every stage and counters of the hot path, recorded without locks
+  LatencyHistogram latency_[NUM_STAGES];
+  uint64_t loop_overruns_, missed_deadlines_, dropped_frames_;
+  // Counters at the last publication, the diagnostics warn when they grow
+  uint64_t published_overruns_, published_deadlines_, published_drops_;
+  // Sequence of the last camera frame (image thread only)
+  uint32_t last_frame_seq_;
+  bool frame_seq_valid_;
+  double diagnostics_period_;
+  ros::WallTime next_diagnostics_;
+
+  // Lockstep simulation: the world is paused and every step advances the physics by a fixed number of iterations
+  GazeboStepper stepper_;
+  bool lockstep_;
+  int lockstep_iterations_;
+  double lockstep_timeout_;
+  double lockstep_publish_delay_;
+  bool lockstep_pending_;
+  ros::Time last_frame_stamp_;
 
   // Image related variables
-  sensor_msgs::Image image_total_;
-  cv::Mat src_;
+  sensor_msgs::ImageConstPtr image_total_;
   cv::Mat out_;
+  // Frame being processed by the image thread, copied into out_ when ready
+  cv::Mat frame_buffer_;
+  FramePreprocessor preprocessor_;
+  // Frames observed when the last actions were chosen
+  FrameStack frame_stack_;
+  int frame_stack_depth_;
+  // Optional zero-copy publication of every tick's observation to readers on the same host
+  SharedMemoryChannel shared_memory_;
+  std::string shared_memory_name_;
+  int shared_memory_slots_;
+  // Optional recording of the transitions in a replay file, written by a background thread
+  TransitionRecorder recorder_;
+  std::string record_path_;
+  int record_slots_;
+  // Transition of the last action: begun when the action is applied, ended at the following reward evaluation
+  TransitionRecorder::Record *record_;
+  // Optional timeline of the stages of every step, written as Chrome trace events by a background thread
+  TraceRecorder tracer_;
+  std::string trace_path_;
+  int trace_ring_size_;
 
   // UAV's flight control related variables
   geometry_msgs::Twist velocity_cmd_;
   std_msgs::Empty land_takeoff_cmd_;
   bool can_takeoff_, can_land_, can_move_;
-
-  // Offers useful methods
-  Utilities utilities_;
+  // When the command being applied and the one of the pending step request reached the node
+  ros::WallTime command_received_, step_received_;
+  // Publishes the commands as soon as they are applied and holds them (/drl_node/command_rate, command_hold)
+  CommandDispatcher dispatcher_;
 
 protected:
 
@@ -220,25 +488,73 @@ public:
   int getReward();
   void setReward(double reward);
   void setReward();
+/*
+  Apply the command of a pending step request, if any. Must be called by the main loop
+  after setReward() and before the commands are published.
+*/
+  void applyStepCommand();
+
+/*
+  Publish the command applied since the last call, if any. Called right after drl/send_command and by the main loop
+  for the step requests.
+*/
+  void publishCommand();
+
+  bool getLockstep();
+/*
+  Advance the physics after the command of a step request has been published, wait for a frame rendered
+  during those iterations and evaluate the reward. Does nothing if no step request is pending.
+*/
+  void advanceLockstep();
+
+/*
+  Record the duration of an iteration of the main loop
+
+  @param start, end delimit the work of the iteration (LatencyHistogram::now()), without its sleep
+  @param overrun is true if the iteration did not fit in the period of the loop
+*/
+  void recordLoop(int64_t start, int64_t end, bool overrun);
+
+/*
+  Publish the latency percentiles and the counters on /drl/diagnostics, once per /drl_node/diagnostics_period
+*/
+  void publishDiagnostics();
 };
 
 DeepReinforcedLanding::DeepReinforcedLanding()
 {
-  //camera_sub_ = nh_.subscribe("/quadrotor/ardrone/bottom/ardrone/bottom/image_raw", 1, &DeepReinforcedLanding::getImageCallback,this);
+  nh_image_.setCallbackQueue(&image_queue_);
+  nh_control_.setCallbackQueue(&control_queue_);
+  nh_services_.setCallbackQueue(&services_queue_);
+  camera_sub_ = nh_image_.subscribe("/quadrotor/ardrone/bottom/ardrone/bottom/image_raw", 1,
+                                    &DeepReinforcedLanding::getImageCallback, this);
   cmd_pub_ = nh_.advertise<geometry_msgs::Twist>("/quadrotor/cmd_vel", 1);
   land_pub_ = nh_.advertise<std_msgs::Empty>("/quadrotor/ardrone/land",1);
   takeoff_pub_ = nh_.advertise<std_msgs::Empty>("/quadrotor/ardrone/takeoff",1);
   reset_model_pub_ = nh_.advertise<gazebo_msgs::ModelState>("/gazebo/set_model_state", 1);
   greyscale_camera_pub_ = nh_.advertise<sensor_msgs::Image>("/drl/grey_camera", 1);
-
-  get_state_client_ = nh_.serviceClient<gazebo_msgs::GetModelState>("/gazebo/get_model_state");
-  service_done_reward_ = nh_.advertiseService("drl/get_done_reward", &DeepReinforcedLanding::getStatus, this);
-  service_camera_ = nh_.advertiseService("drl/get_camera_image", &DeepReinforcedLanding::getCameraImage, this);
-  service_camera_matrix_ = nh_.advertiseService("drl/get_camera_image_matrix", &DeepReinforcedLanding::getNewCamera, this);
-  service_reset_ = nh_.advertiseService("drl/set_model_state", &DeepReinforcedLanding::setModelState, this);
-  set_state_client_ = nh_.serviceClient<gazebo_msgs::SetModelState>("/gazebo/set_model_state");
-  service_send_command_ = nh_.advertiseService("drl/send_command", &DeepReinforcedLanding::sendCommand, this);
-  service_relative_pose_ = nh_.advertiseService("drl/get_relative_pose", &DeepReinforcedLanding::getRelativePose, this);
+  diagnostics_pub_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("/drl/diagnostics", 1);
+
+  state_cache_.init(nh_);
+  service_done_reward_ = nh_services_.advertiseService("drl/get_done_reward", &DeepReinforcedLanding::getStatus, this);
+  service_camera_ = nh_services_.advertiseService("drl/get_camera_image", &DeepReinforcedLanding::getCameraImage, this);
+  service_camera_matrix_ = nh_services_.advertiseService("drl/get_camera_image_matrix",
+                                                         &DeepReinforcedLanding::getNewCamera, this);
+  service_camera_stack_ = nh_services_.advertiseService("drl/get_camera_image_stack",
+                                                        &DeepReinforcedLanding::getCameraImageStack, this);
+  service_reset_ = nh_control_.advertiseService("drl/set_model_state", &DeepReinforcedLanding::setModelState, this);
+  service_reset_environment_ = nh_control_.advertiseService("drl/reset_environment",
+                                                            &DeepReinforcedLanding::resetEnvironment, this);
+  service_send_command_ = nh_control_.advertiseService("drl/send_command", &DeepReinforcedLanding::sendCommand, this);
+  service_send_action_ = nh_control_.advertiseService("drl/send_action", &DeepReinforcedLanding::sendAction, this);
+  service_relative_pose_ = nh_services_.advertiseService("drl/get_relative_pose",
+                                                         &DeepReinforcedLanding::getRelativePose, this);
+  service_curriculum_ = nh_services_.advertiseService("drl/get_curriculum_stage",
+                                                      &DeepReinforcedLanding::getCurriculumStage, this);
+  service_latency_ = nh_services_.advertiseService("drl/get_latency_stats", &DeepReinforcedLanding::getLatencyStats,
+                                                   this);
+  nh_step_.setCallbackQueue(&step_queue_);
+  service_step_ = nh_step_.advertiseService("drl/step", &DeepReinforcedLanding::step, this);
   
   // Load parameters from param server
   nh_.getParam ("/drl_node/bb_flight_half_size", bb_flight_half_size_ );
@@ -246,14 +562,73 @@ DeepReinforcedLanding::DeepReinforcedLanding()
   nh_.getParam ("/drl_node/bb_landing_half_size", bb_landing_half_size_ );
   nh_.getParam ("/drl_node/bb_landing_height", bb_landing_height_ );
   nh_.getParam ("/drl_node/respawn_height", respawn_height );
+  SpawnConfig spawn_config;
+  std::string xy_gaussian_uniform;
+  int spawn_seed, spawn_batch;
   nh_.getParam ("/drl_node/xy_gaussian_uniform", xy_gaussian_uniform );
-  nh_.getParam ("/drl_node/xy_gaussian_mean", xy_gaussian_mean );
-  nh_.getParam ("/drl_node/xy_gaussian_stdev", xy_gaussian_stdev );
-  nh_.getParam ("/drl_node/num_z_uniform", num_z_uniform );
-  nh_.getParam ("/drl_node/z_uniform_from", z_uniform_from );
-  nh_.getParam ("/drl_node/z_uniform_to", z_uniform_to );
-  nh_.getParam ("/drl_node/z_uniform_from_2", z_uniform_from_2 );
-  nh_.getParam ("/drl_node/z_uniform_to_2", z_uniform_to_2 );
+  nh_.getParam ("/drl_node/xy_gaussian_mean", spawn_config.xy_mean );
+  nh_.getParam ("/drl_node/xy_gaussian_stdev", spawn_config.xy_stdev );
+  nh_.getParam ("/drl_node/num_z_uniform", spawn_config.z_bands );
+  nh_.getParam ("/drl_node/z_uniform_from", spawn_config.z_from );
+  nh_.getParam ("/drl_node/z_uniform_to", spawn_config.z_to );
+  nh_.getParam ("/drl_node/z_uniform_from_2", spawn_config.z_from_2 );
+  nh_.getParam ("/drl_node/z_uniform_to_2", spawn_config.z_to_2 );
+  if (nh_.getParam ("/drl_node/seed", spawn_seed ) == false)
+  {
+    spawn_seed = std::random_device()() & 0x7fffffff;
+  }
+  nh_.param ("/drl_node/spawn_batch", spawn_batch, 0 );
+  CurriculumConfig curriculum_config;
+  nh_.param ("/drl_node/curriculum_stages", curriculum_config.stages, curriculum_config.stages );
+  nh_.param ("/drl_node/curriculum_window", curriculum_config.window, curriculum_config.window );
+  nh_.param ("/drl_node/curriculum_promote_rate", curriculum_config.promote_rate, curriculum_config.promote_rate );
+  nh_.param ("/drl_node/curriculum_demote_rate", curriculum_config.demote_rate, curriculum_config.demote_rate );
+  nh_.param ("/drl_node/curriculum_start_xy_scale", curriculum_config.start_xy_scale,
+             curriculum_config.start_xy_scale );
+  nh_.param ("/drl_node/curriculum_start_z", curriculum_config.start_z, curriculum_config.start_z );
+  nh_.param ("/drl_node/lockstep", lockstep_, false );
+  nh_.param ("/drl_node/lockstep_iterations", lockstep_iterations_, 33 );
+  nh_.param ("/drl_node/lockstep_timeout", lockstep_timeout_, 0.5 );
+  nh_.param ("/drl_node/lockstep_publish_delay", lockstep_publish_delay_, 0.002 );
+  nh_.param ("/drl_node/frame_stack_depth", frame_stack_depth_, 4 );
+  nh_.param ("/drl_node/shared_memory_name", shared_memory_name_, std::string("") );
+  nh_.param ("/drl_node/shared_memory_slots", shared_memory_slots_, 8 );
+  nh_.param ("/drl_node/record_path", record_path_, std::string("") );
+  nh_.param ("/drl_node/record_slots", record_slots_, 256 );
+  nh_.param ("/drl_node/trace_path", trace_path_, std::string("") );
+  nh_.param ("/drl_node/trace_ring_size", trace_ring_size_, 4096 );
+  nh_.param ("/drl_node/markers", marker_names_, std::vector<std::string>(1, "marker2") );
+  std::vector<std::string> grounds;
+  std::string ground_model_path;
+  double ground_park_depth;
+  nh_.param ("/drl_node/grounds", grounds, std::vector<std::string>() );
+  nh_.param ("/drl_node/ground_model_path", ground_model_path, std::string("~/.gazebo/models") );
+  nh_.param ("/drl_node/ground_park_depth", ground_park_depth, 100.0 );
+  double command_rate, command_hold;
+  nh_.param ("/drl_node/command_rate", command_rate, 0.0 );
+  nh_.param ("/drl_node/command_hold", command_hold, 0.0 );
+  nh_.param ("/drl_node/diagnostics_period", diagnostics_period_, 1.0 );
+  // The diagonals have always stopped the UAV in simulation, a table with their velocities enables them
+  actions_ = ActionTable::defaults(0.5, 0.5, false);
+  std::vector<std::string> action_names;
+  std::vector<double> action_directions, action_magnitudes;
+  nh_.param ("/drl_node/action_names", action_names, std::vector<std::string>() );
+  nh_.param ("/drl_node/action_directions", action_directions, std::vector<double>() );
+  nh_.param ("/drl_node/action_magnitudes", action_magnitudes, std::vector<double>() );
+  std::string action_error;
+  if (action_names.empty() == false && actions_.load(action_names, action_directions, action_magnitudes,
+                                                     &action_error) == false)
+  {
+    ROS_ERROR("Invalid action table (%s), the default one is used", action_error.c_str());
+  }
+  RewardConfig reward_config;
+  std::string reward_policy;
+  double step_reward, success_reward, failure_reward;
+  nh_.param ("/drl_node/reward_policy", reward_policy, std::string(rewardPolicyName(reward_config.policy)) );
+  nh_.param ("/drl_node/reward_step", step_reward, (double)reward_config.step_reward );
+  nh_.param ("/drl_node/reward_success", success_reward, (double)reward_config.success_reward );
+  nh_.param ("/drl_node/reward_failure", failure_reward, (double)reward_config.failure_reward );
+  nh_.param ("/drl_node/reward_min_altitude", reward_config.min_altitude, reward_config.min_altitude );
 
   // With a flight BB having 15m per side, we need a minimum height of 20m for perceiving the marker
   //bb_flight_half_size_ = 6.5;
@@ -267,14 +642,93 @@ DeepReinforcedLanding::DeepReinforcedLanding()
   //bb_landing_half_size_ = sqrt(bb_landing_volume / bb_flight_height_) / 2;
   //bb_landing_half_size_ = 1.5; // add math expression
   
+  if (parseRewardPolicy(reward_policy, &reward_config.policy) == false)
+  {
+    ROS_ERROR("Unknown reward policy %s, %s is used", reward_policy.c_str(), rewardPolicyName(reward_config.policy));
+  }
+  reward_config.landing_half_size = bb_landing_half_size_;
+  reward_config.landing_height = bb_landing_height_;
+  reward_config.flight_half_size = bb_flight_half_size_;
+  reward_config.flight_height = bb_flight_height_;
+  reward_config.step_reward = step_reward;
+  reward_config.success_reward = success_reward;
+  reward_config.failure_reward = failure_reward;
+  reward_engine_ = RewardEngine(reward_config);
+  pads_ = LandingPads(reward_config);
+
+  if (xy_gaussian_uniform != "gaussian" && xy_gaussian_uniform != "uniform")
+  {
+    ROS_ERROR("A wrong distribution has been chosen (typo?). [uniform or gaussian]");
+    ros::shutdown();
+  }
+  if (spawn_config.z_bands != 1 && spawn_config.z_bands != 2)
+  {
+    ROS_ERROR("A wrong number has been chosen for the how many uniform distribution to use for the altitude. [1 or 2]");
+    ros::shutdown();
+  }
+  spawn_config.xy_gaussian = xy_gaussian_uniform == "gaussian";
+  spawn_config.xy_half_size = bb_landing_half_size_;
+  curriculum_ = CurriculumScheduler(curriculum_config, spawn_config);
+  spawn_sampler_ = SpawnSampler(curriculum_.getSpawnConfig(), spawn_seed, 0, std::max(spawn_batch, 0));
+  episode_reported_ = false;
+  ROS_INFO("Respawn seed %d (/drl_node/seed)", spawn_seed);
+  marker_pads_.assign(marker_names_.size(), -1);
+  next_marker_ = 0;
 
 
   done_ = false;
   reward_ = 0;
   reset_ = false;
+  action_ = ACTION_UNKNOWN;
+  wrong_altitude_ = false;
   can_takeoff_ = false;
   can_land_ = false;
   can_move_ = false;
+  out_ = cv::Mat::zeros(preprocessor_.getOutSize(), preprocessor_.getOutSize(), CV_8UC1);
+  frame_buffer_ = out_.clone();
+  frame_snapshot_.init(out_.total());
+  step_prev_frame_ = out_.clone();
+  step_frame_ = out_.clone();
+  frame_stack_ = FrameStack(out_.rows, out_.cols, std::max(frame_stack_depth_, 1));
+  if (shared_memory_name_.empty() == false &&
+      shared_memory_.open(shared_memory_name_, out_.rows, out_.cols, frame_stack_.getDepth(), shared_memory_slots_) == false)
+  {
+    ROS_ERROR("Shared memory %s cannot be created, observations are available through the services only",
+              shared_memory_name_.c_str());
+  }
+  record_ = NULL;
+  if (record_path_.empty() == false &&
+      recorder_.open(record_path_, out_.rows, out_.cols, frame_stack_.getDepth(), record_slots_,
+                     REPLAY_FLAG_ACTION_IDS) == false)
+  {
+    ROS_ERROR("Replay file %s cannot be written (or it has another shape), the transitions are not recorded",
+              record_path_.c_str());
+  }
+  if (trace_path_.empty() == false && tracer_.open(trace_path_, std::max(trace_ring_size_, 1)) == false)
+  {
+    ROS_ERROR("Trace file %s cannot be created, the steps are not traced", trace_path_.c_str());
+  }
+
+  tick_ = 0;
+  step_action_ = -1;
+  has_step_command_ = false;
+  step_requested_id_ = step_applied_id_ = step_finished_id_ = 0;
+  step_repeat_ = step_repeat_left_ = 0;
+  action_reward_ = 0;
+  action_evaluations_ = 0;
+  loop_overruns_ = missed_deadlines_ = dropped_frames_ = 0;
+  published_overruns_ = published_deadlines_ = published_drops_ = 0;
+  last_frame_seq_ = 0;
+  frame_seq_valid_ = false;
+  next_diagnostics_ = ros::WallTime::now();
+  lockstep_pending_ = false;
+  bb_valid_ = false;
+
+  if (lockstep_ == true && stepper_.init(nh_) == false)
+  {
+    ROS_ERROR("Lockstep mode requested but the world cannot be stepped");
+    ros::shutdown();
+  }
   
   
   //----------- RESET POSE -----
@@ -291,15 +745,64 @@ DeepReinforcedLanding::DeepReinforcedLanding()
   set_model_state_.request.model_state = model_state;
   //----------------------------
 
-  if (reset_ == true)
+  // In lockstep mode a hold measured in wall time could expire while the physics is stepped, it should stay 0
+  dispatcher_.init(cmd_pub_, takeoff_pub_, land_pub_, command_rate, command_hold);
+
+  // The ground variants are spawned once here, the resets only move them
+  if (reset_manager_.init(nh_, grounds, ground_model_path, ground_park_depth, spawn_seed) == false)
   {
-    set_state_client_.call(set_model_state_);
+    ROS_ERROR("Not all the grounds have been preloaded, only %zu of them are used", reset_manager_.getNumGrounds());
   }
   reset_ = false;
+
+  step_spinner_.reset(new ros::AsyncSpinner(1, &step_queue_));
+  step_spinner_->start();
+  image_spinner_.reset(new ros::AsyncSpinner(1, &image_queue_));
+  image_spinner_->start();
+  control_spinner_.reset(new ros::AsyncSpinner(1, &control_queue_));
+  control_spinner_->start();
+  services_spinner_.reset(new ros::AsyncSpinner(1, &services_queue_));
+  services_spinner_->start();
 }
 
 DeepReinforcedLanding::~DeepReinforcedLanding()
 {
+  step_spinner_->stop();
+  image_spinner_->stop();
+  control_spinner_->stop();
+  services_spinner_->stop();
+  dispatcher_.shutdown();
+  if (dispatcher_.getDispatched() > 0)
+  {
+    ROS_INFO("%lu commands, command to publish latency mean %.3f ms, max %.3f ms", dispatcher_.getDispatched(),
+             dispatcher_.getMeanLatency() * 1e3, dispatcher_.getMaxLatency() * 1e3);
+  }
+  if (reset_manager_.getResets() > 0)
+  {
+    ROS_INFO("%lu resets, latency mean %.2f ms, max %.2f ms", reset_manager_.getResets(),
+             reset_manager_.getMeanLatency() * 1e3, reset_manager_.getMaxLatency() * 1e3);
+  }
+  for (int stage = 0; stage < NUM_STAGES; stage++)
+  {
+    if (latency_[stage].getCount() > 0)
+    {
+      ROS_INFO("%s: %lu records, latency p50 %.3f ms, p99 %.3f ms, max %.3f ms", STAGE_NAMES[stage],
+               (unsigned long)latency_[stage].getCount(), latency_[stage].getPercentile(50) * 1e-6,
+               latency_[stage].getPercentile(99) * 1e-6, latency_[stage].getMax() * 1e-6);
+    }
+  }
+  if (tracer_.isOpen())
+  {
+    tracer_.close();
+    ROS_INFO("%lu events traced in %s, %lu dropped", (unsigned long)tracer_.getWritten(), trace_path_.c_str(),
+             (unsigned long)tracer_.getDropped());
+  }
+  if (recorder_.isOpen())
+  {
+    recorder_.close();
+    ROS_INFO("%lu transitions recorded in %s, %lu dropped", (unsigned long)recorder_.getRecorded(),
+             record_path_.c_str(), (unsigned long)recorder_.getDropped());
+  }
 }
 
 
@@ -307,110 +810,229 @@ DeepReinforcedLanding::~DeepReinforcedLanding()
 bool DeepReinforcedLanding::getStatus(deep_reinforced_landing::GetDoneAndReward::Request &req,
                                       deep_reinforced_landing::GetDoneAndReward::Response &res)
 {
-  res.done = done_;
-  res.reward = reward_;
+  TickSnapshot snapshot;
+  if (tick_snapshot_.read(&snapshot))
+  {
+    res.done = snapshot.done;
+    res.reward = snapshot.reward;
+  }
   return true;
 }
 
 bool DeepReinforcedLanding::getCameraImage(deep_reinforced_landing::GetCameraImage::Request &req,
                                            deep_reinforced_landing::GetCameraImage::Response &res)
 {
-  res.image = image_total_;
+  // The frame is immutable, only the reference is taken under the lock
+  sensor_msgs::ImageConstPtr image;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    image = image_total_;
+  }
+  if (image)
+  {
+    res.image = *image;
+  }
   return true;
 }
 
 bool DeepReinforcedLanding::getNewCamera(deep_reinforced_landing::NewCameraService::Request &req,
                                            deep_reinforced_landing::NewCameraService::Response &res)
 {
-
-  int size = out_.rows * out_.cols;
-  for(int i=0; i < size; i++)
+  // The response stays black until the first frame
+  if (res.image.size() > 0)
   {
-    res.image[i] = out_.at<int>(i);
+    frame_snapshot_.read(NULL, &res.image[0], res.image.size());
   }
   return true;
 }
 
+bool DeepReinforcedLanding::getCameraImageStack(deep_reinforced_landing::GetFrameStack::Request &req,
+                                                deep_reinforced_landing::GetFrameStack::Response &res)
+{
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  res.height = frame_stack_.getHeight();
+  res.width = frame_stack_.getWidth();
+  res.depth = frame_stack_.getDepth();
+  res.image.resize(out_.total() * res.depth);
+  frame_stack_.copyStacked(out_.data, &res.image[0]);
+  return true;
+}
+
 bool DeepReinforcedLanding::setModelState(deep_reinforced_landing::ResetPosition::Request &req,
                                           deep_reinforced_landing::ResetPosition::Response &res)
 {
+  std::lock_guard<std::mutex> lock(state_mutex_);
   reset_ = req.reset;
   return true;
 }
 
+bool DeepReinforcedLanding::resetEnvironment(deep_reinforced_landing::ResetEnvironment::Request &req,
+                                             deep_reinforced_landing::ResetEnvironment::Response &res)
+{
+  gazebo_msgs::SetModelState set_model_state = getModelState();
+  res.success = resetEpisode(set_model_state.request.model_state, req.ground);
+  res.ground = reset_manager_.getGround();
+  res.pose = set_model_state.request.model_state.pose;
+  res.latency = reset_manager_.getLastLatency();
+  res.mean_latency = reset_manager_.getMeanLatency();
+  res.max_latency = reset_manager_.getMaxLatency();
+  return true;
+}
+
 bool DeepReinforcedLanding::sendCommand(deep_reinforced_landing::SendCommand::Request &req, 
                                         deep_reinforced_landing::SendCommand::Response &res)
 {
-  setActionCommand(req.command);
-
-  float velocity = 0.5;
-  if(req.command == "left")
-  {
-    velocity_cmd_.linear.y = velocity;
-    can_move_ = true;
-  }
-  else if(req.command == "right")
-  {
-    velocity_cmd_.linear.y = -velocity;
-    can_move_ = true;
-  }
-  else if(req.command == "forward")
-  {
-    velocity_cmd_.linear.x = velocity;
-    can_move_ = true;
-  }
-  else if(req.command == "backward")
+  const int64_t start = LatencyHistogram::now();
+  tracer_.instant("command_received");
+  const ros::WallTime received = ros::WallTime::now();
   {
-    velocity_cmd_.linear.x = -velocity;
-    can_move_ = true;
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (step_repeat_left_ > 0)
+    {
+      // The action of a drl/step request is being repeated, its rewards would be mixed with those of this one
+      ROS_WARN_THROTTLE(1.0, "Command %s ignored, the action of a step request is being repeated",
+                        req.command.c_str());
+      return true;
+    }
+    command_received_ = received;
+    applyAction(actions_.find(req.command));
   }
-  else if(req.command == "ascend")
+  // Published now rather than at the next pass of the main loop
+  publishCommand();
+  endStage(STAGE_COMMAND_SERVICE, start);
+  return true;
+}
+
+bool DeepReinforcedLanding::sendAction(deep_reinforced_landing::SendAction::Request &req,
+                                       deep_reinforced_landing::SendAction::Response &res)
+{
+  const int64_t start = LatencyHistogram::now();
+  tracer_.instant("command_received");
+  const ros::WallTime received = ros::WallTime::now();
   {
-    velocity_cmd_.linear.z = velocity;
-    can_move_ = true;
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (step_repeat_left_ > 0)
+    {
+      ROS_WARN_THROTTLE(1.0, "Action %d ignored, the action of a step request is being repeated", req.action);
+      res.success = false;
+      return true;
+    }
+    command_received_ = received;
+    applyAction(req.action);
   }
-  else if(req.command == "descend")
+  publishCommand();
+  res.success = actions_.get(req.action) != NULL;
+  endStage(STAGE_COMMAND_SERVICE, start);
+  return true;
+}
+
+bool DeepReinforcedLanding::getRelativePose(deep_reinforced_landing::GetRelativePose::Request &req,
+                                            deep_reinforced_landing::GetRelativePose::Response &res)
+{
+  // NOTE: the relative position is calculated within the mathod for the reward (setReward). Therefore that method need to be 
+  //called before this one in order to have the relative pose of the quadrotor to the marker
+  TickSnapshot snapshot;
+  if (tick_snapshot_.read(&snapshot))
   {
-    velocity_cmd_.linear.z = -velocity;
-    can_move_ = true;
+    res.pose.position.x = snapshot.relative[0];
+    res.pose.position.y = snapshot.relative[1];
+    res.pose.position.z = snapshot.relative[2];
   }
-  else if(req.command == "rotate_left")
+  
+  return true;
+}
+
+bool DeepReinforcedLanding::getCurriculumStage(deep_reinforced_landing::GetCurriculumStage::Request &req,
+                                               deep_reinforced_landing::GetCurriculumStage::Response &res)
+{
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  const SpawnConfig spawn = curriculum_.getSpawnConfig();
+  res.stage = curriculum_.getStage();
+  res.num_stages = curriculum_.getNumStages();
+  res.success_rate = curriculum_.getSuccessRate();
+  res.episodes = curriculum_.getEpisodes();
+  res.xy_stdev = spawn.xy_stdev;
+  res.xy_half_size = spawn.xy_half_size;
+  res.z_from = spawn.z_from;
+  res.z_to = spawn.z_to;
+  res.z_from_2 = spawn.z_from_2;
+  res.z_to_2 = spawn.z_to_2;
+  return true;
+}
+
+bool DeepReinforcedLanding::step(deep_reinforced_landing::Step::Request &req,
+                                 deep_reinforced_landing::Step::Response &res)
+{
+  const int64_t start = LatencyHistogram::now();
+  std::unique_lock<std::mutex> lock(state_mutex_);
+  step_action_ = actions_.find(req.command);
+  step_repeat_ = std::max(req.repeat, 1u);
+  step_received_ = ros::WallTime::now();
+  has_step_command_ = true;
+  unsigned long id = ++step_requested_id_;
+  tracer_.instant("command_received", id);
+
+  // The command is applied by the main loop, the answer is ready at the last reward evaluation of its repeat
+  while (step_finished_id_ != id)
   {
-    velocity_cmd_.angular.z = velocity;
-    can_move_ = true;
+    tick_cond_.wait_for(lock, std::chrono::milliseconds(100));
+    if (!ros::ok())
+    {
+      return false;
+    }
   }
-  else if(req.command == "rotate_right")
+
+  res.reward = action_reward_;
+  res.repeats = action_evaluations_;
+  res.done = done_;
+  res.wrong_altitude = wrong_altitude_;
+  res.pose.position.x = quadrotor_to_marker_pose_.position.x;
+  res.pose.position.y = quadrotor_to_marker_pose_.position.y;
+  res.pose.position.z = quadrotor_to_marker_pose_.position.z;
+  res.height = step_frame_.rows;
+  res.width = step_frame_.cols;
+  if (step_frame_.isContinuous())
   {
-    velocity_cmd_.angular.z = -velocity;
-    can_move_ = true;
+    res.image.assign(step_frame_.data, step_frame_.data + step_frame_.total());
   }
-  else if(req.command == "takeoff")
+  lock.unlock();
+  tracer_.instant("response_sent", id);
+  endStage(STAGE_STEP_SERVICE, start, id);
+  return true;
+}
+
+bool DeepReinforcedLanding::getLatencyStats(deep_reinforced_landing::GetLatencyStats::Request &req,
+                                            deep_reinforced_landing::GetLatencyStats::Response &res)
+{
+  res.percentiles = req.percentiles;
+  if (res.percentiles.empty())
   {
-    can_takeoff_ = true;
+    const double percentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+    res.percentiles.assign(percentiles, percentiles + 4);
   }
-  else if(req.command == "land")
+  for (int stage = 0; stage < NUM_STAGES; stage++)
   {
-    can_land_ = true;
+    const LatencyHistogram &latency = latency_[stage];
+    res.stages.push_back(STAGE_NAMES[stage]);
+    res.counts.push_back(latency.getCount());
+    res.mean.push_back(latency.getMean() * 1e-6);
+    res.max.push_back(latency.getMax() * 1e-6);
+    for (size_t i = 0; i < res.percentiles.size(); i++)
+    {
+      res.values.push_back(latency.getPercentile(res.percentiles[i]) * 1e-6);
+    }
   }
-  else
+  res.loop_overruns = __atomic_load_n(&loop_overruns_, __ATOMIC_RELAXED);
+  res.missed_deadlines = __atomic_load_n(&missed_deadlines_, __ATOMIC_RELAXED);
+  res.dropped_frames = __atomic_load_n(&dropped_frames_, __ATOMIC_RELAXED);
+
+  if (req.reset)
   {
-    velocity_cmd_.linear.x = velocity_cmd_.linear.y = velocity_cmd_.linear.z = 0;
-    velocity_cmd_.angular.x = velocity_cmd_.angular.y = velocity_cmd_.angular.z = 0;
-    can_move_ = true;
+    for (int stage = 0; stage < NUM_STAGES; stage++)
+    {
+      latency_[stage].reset();
+    }
   }
-  
-  return true;
-}
-
-bool DeepReinforcedLanding::getRelativePose(deep_reinforced_landing::GetRelativePose::Request &req,
-                                            deep_reinforced_landing::GetRelativePose::Response &res)
-{
-  // NOTE: the relative position is calculated within the mathod for the reward (setReward). Therefore that method need to be 
-  //called before this one in order to have the relative pose of the quadrotor to the marker
-  res.pose.position.x = quadrotor_to_marker_pose_.position.x;
-  res.pose.position.y = quadrotor_to_marker_pose_.position.y;
-  res.pose.position.z = quadrotor_to_marker_pose_.position.z;
-  
   return true;
 }
 //----------------------------------
@@ -429,103 +1051,75 @@ void DeepReinforcedLanding::setDoneCallback(const ardrone_autonomy::Navdata &msg
     done_ = false;
   }
 }
-/*
-void DeepReinforcedLanding::getImageCallback(const sensor_msgs::Image &msg)
+void DeepReinforcedLanding::getImageCallback(const sensor_msgs::ImageConstPtr &msg)
 {
+  const int64_t start = LatencyHistogram::now();
+  if (msg->width == 0 || msg->height == 0 || msg->data.size() < (size_t)msg->step * msg->height)
+  {
+    ROS_ERROR_THROTTLE(1.0, "Camera frame of %ux%u with %zu bytes ignored", msg->width, msg->height, msg->data.size());
+    return;
+  }
+  // The subscriber keeps only the latest frame, the others are skipped by the sequence of the camera
+  if (frame_seq_valid_ && msg->header.seq > last_frame_seq_ + 1)
+  {
+    __atomic_fetch_add(&dropped_frames_, msg->header.seq - last_frame_seq_ - 1, __ATOMIC_RELAXED);
+  }
+  last_frame_seq_ = msg->header.seq;
+  frame_seq_valid_ = true;
 
-  // Get color image
-  image_total_ = msg;
-
-  // Get greyscale
-  src_ = cv_bridge::toCvCopy(msg, sensor_msgs::image_encodings::MONO8)->image; 
-  // Scale image to 84px x 150px
-  cv::resize(src_, out_, cv::Size(), 0.233333333, 0.233333333);
-  //cout << out_.cols << " " << out_.rows << " " << out_.size << endl;
-  // Setup a rectangle to define a region of interest
-  cv::Rect myROI(33,0,84,84);
-  // Crop the full image to that image contained by the rectangle myROI
-  cv::Mat croppedRef(out_, myROI);
+  // Crop, scale (0.2333 and 84x84 region at x=33) and convert to greyscale in a single pass.
+  // The frame is processed aside, the lock is held only for the copy
+  if (!preprocessor_.process(&msg->data[0], msg->width, msg->height, msg->step, msg->encoding, frame_buffer_.data))
+  {
+    // Unusual encodings are converted by cv_bridge first
+    cv_bridge::CvImageConstPtr mono = cv_bridge::toCvShare(msg, sensor_msgs::image_encodings::MONO8);
+    preprocessor_.process(mono->image.data, mono->image.cols, mono->image.rows, mono->image.step, "mono8",
+                          frame_buffer_.data);
+  }
 
-  // Copy the data in the original output image
-  croppedRef.copyTo(out_);
+  if (greyscale_camera_pub_.getNumSubscribers() > 0)
+  {
+    greyscale_camera_pub_.publish((cv_bridge::CvImage(msg->header,"mono8",frame_buffer_).toImageMsg()));
+  }
+  frame_snapshot_.write(msg->header.stamp.toSec(), frame_buffer_.data);
 
-  greyscale_camera_pub_.publish((cv_bridge::CvImage(msg.header,"mono8",out_).toImageMsg()));
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    // Keep a reference to the color image, no copy is made
+    image_total_ = msg;
+    last_frame_stamp_ = msg->header.stamp;
+    frame_buffer_.copyTo(out_);
+  }
+  frame_cond_.notify_all();
+  endStage(STAGE_IMAGE_CALLBACK, start, msg->header.seq);
 }
-*/
 //---------------------------------
 
 bool DeepReinforcedLanding::getReset()
 {
+  std::lock_guard<std::mutex> lock(state_mutex_);
   return reset_;
 }
 
 void DeepReinforcedLanding::setReset(bool reset)
 {
+  std::lock_guard<std::mutex> lock(state_mutex_);
   reset_ = reset;
 }
 
 gazebo_msgs::SetModelState DeepReinforcedLanding::getModelState()
 {
   gazebo_msgs::SetModelState set_model_state = set_model_state_;
-  float tmp_x, tmp_y, tmp_z;
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::normal_distribution<> gaussian_xy(xy_gaussian_mean, xy_gaussian_stdev);  
-  std::random_device                  rand_dev;
-  std::mt19937                        generator(rand_dev());
-  std::uniform_real_distribution<float>  xy_uniform(-bb_landing_half_size_, bb_landing_half_size_);
-  std::uniform_real_distribution<float>  z_uniform(z_uniform_from, z_uniform_to);
-  std::uniform_real_distribution<float>  z_uniform_2(z_uniform_from_2, z_uniform_to_2);
-  double coin = ((double) rand() / (RAND_MAX));
-  
-  if (xy_gaussian_uniform.compare("gaussian") == 0)
-  {
-    tmp_x = gaussian_xy(gen);
-    set_model_state.request.model_state.pose.position.x = tmp_x;
-    tmp_y = gaussian_xy(gen);
-    set_model_state.request.model_state.pose.position.y = tmp_y;
-  }
-  else if (xy_gaussian_uniform.compare("uniform") == 0)
-  {
-     tmp_x = xy_uniform(generator);
-     tmp_x = xy_uniform(generator);
-  } 
-  else 
-  {
-    ROS_ERROR("A wrong distribution has been chosen (typo?). [uniform or gaussian]");
-    ros::shutdown();
-  }
-  
-  if (num_z_uniform == 1)
-  {
-    tmp_z = z_uniform(generator);
-  }
-  else if (num_z_uniform == 2)
-  {
-    if (coin >= 0.5)
-    {
-      tmp_z = z_uniform(generator);
-    }
-    else
-    {
-      tmp_z = z_uniform_2(generator);
-    }
-  }else 
+  Spawn spawn;
   {
-    ROS_ERROR("A wrong number has been chosen for the how many uniform distribution to use for the altitude. [1 or 2]");
-    ros::shutdown();
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    spawn = spawn_sampler_.next();
   }
-  set_model_state.request.model_state.pose.position.z = tmp_z;
-
-  
-
-  tfScalar roll, pitch, yaw;
-  yaw = (rand() % 360);// - 180; // rand() supports only integer
-  tf::Matrix3x3 m;
-  m.setEulerYPR(yaw,pitch,roll);
-  tf::Quaternion orientation;
-  m.getRotation(orientation);
+  set_model_state.request.model_state.pose.position.x = spawn.x;
+  set_model_state.request.model_state.pose.position.y = spawn.y;
+  set_model_state.request.model_state.pose.position.z = spawn.z;
 
+  tf::Quaternion orientation = tf::createQuaternionFromYaw(spawn.yaw);
   set_model_state.request.model_state.pose.orientation.x = orientation.getX();
   set_model_state.request.model_state.pose.orientation.y = orientation.getY();
   set_model_state.request.model_state.pose.orientation.z = orientation.getZ();
@@ -536,7 +1130,24 @@ gazebo_msgs::SetModelState DeepReinforcedLanding::getModelState()
 
 void DeepReinforcedLanding::setModelState(gazebo_msgs::SetModelState set_model_state)
 {
-  set_state_client_.call(set_model_state);
+  resetEpisode(set_model_state.request.model_state, GROUND_KEEP);
+}
+
+bool DeepReinforcedLanding::resetEpisode(const gazebo_msgs::ModelState &model_state, int ground)
+{
+  // The Gazebo calls are made without the lock, the queries are served meanwhile
+  const int64_t start = LatencyHistogram::now();
+  bool success = reset_manager_.reset(model_state, ground);
+  endStage(STAGE_RESET, start);
+
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  // A new episode begins, its first observation is the first frame repeated
+  frame_stack_.clear();
+  episode_reported_ = false;
+  // An action whose outcome has not been evaluated yet does not belong to the new episode
+  recorder_.cancelRecord();
+  record_ = NULL;
+  return success;
 }
 
 bool DeepReinforcedLanding::getCanMove()
@@ -602,47 +1213,406 @@ void DeepReinforcedLanding::setReward(double reward)
 void DeepReinforcedLanding::setReward()
 {
 
-  srv_.request.model_name = "quadrotor";
-  if (get_state_client_.call(srv_))
+  geometry_msgs::Pose pose;
+  int64_t start = LatencyHistogram::now();
+
+  // In lockstep mode the world has just been stepped and the last model states message may be
+  // still on its way, so the quadrotor's pose is read synchronously
+  if (lockstep_ == true && state_cache_.refresh("quadrotor") == false)
+  {
+    ROS_ERROR("GetModelState service has not been called");
+  }
+  endStage(STAGE_STATE_FETCH, start, tick_ + 1);
+
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  if (state_cache_.getPose("quadrotor", pose))
   {  // NB: quadrotor's altitude can be used to understand if it still flying or landed
-    quadrotorPose_.position.x = srv_.response.pose.position.x;
-    quadrotorPose_.position.y = srv_.response.pose.position.y;
-    quadrotorPose_.position.z = srv_.response.pose.position.z;
+    quadrotorPose_.position.x = pose.position.x;
+    quadrotorPose_.position.y = pose.position.y;
+    quadrotorPose_.position.z = pose.position.z;
   }
   else
   {
-    ROS_ERROR("Service has not been called");
+    ROS_ERROR_THROTTLE(1.0, "Pose of the quadrotor not received yet");
   }
 
-  srv_.request.model_name = "marker2";
-  if (get_state_client_.call(srv_))
+  start = LatencyHistogram::now();
+  updatePads();
+  const int pad = pads_.locate(quadrotorPose_.position.x, quadrotorPose_.position.y, quadrotorPose_.position.z);
+  if (pad >= 0)
   {
-    markerPose_.position.x = srv_.response.pose.position.x;
-    markerPose_.position.y = srv_.response.pose.position.y;
-    markerPose_.position.z = srv_.response.pose.position.z;
-    // Create a bounding box for autonomous landing given the marker's position and a number
-    bb_landing_.setDimension(markerPose_, bb_landing_half_size_, bb_landing_height_);
-    bb_flight_.setDimension(markerPose_, bb_flight_half_size_, bb_flight_height_);
+    pads_.getMarker(pad, &markerPose_.position.x, &markerPose_.position.y, &markerPose_.position.z);
+    // Create a bounding box for autonomous landing given the marker's position and a number.
+    // The markers are usually static, so the boxes are updated only when the UAV changes pad or a marker moves
+    if (bb_valid_ == false || bb_origin_.x != markerPose_.position.x || bb_origin_.y != markerPose_.position.y ||
+        bb_origin_.z != markerPose_.position.z)
+    {
+      reward_engine_.setMarker(markerPose_.position.x, markerPose_.position.y, markerPose_.position.z);
+      bb_origin_ = markerPose_.position;
+      bb_valid_ = true;
+    }
   }
   else
   {
-    ROS_ERROR("Service has not been called");
+    ROS_ERROR_THROTTLE(1.0, "Pose of the markers not received yet");
   }
+  endStage(STAGE_MARKER, start, tick_ + 1);
+  start = LatencyHistogram::now();
 
   //Calculate the quadrotor pose wrt the marker's one
   quadrotor_to_marker_pose_.position.x = quadrotorPose_.position.x - markerPose_.position.x;
   quadrotor_to_marker_pose_.position.y = quadrotorPose_.position.y - markerPose_.position.y;
   quadrotor_to_marker_pose_.position.z = quadrotorPose_.position.z - markerPose_.position.z;
   
-  //setReward(utilities_.assignReward(quadrotorPose_, bb_landing_, bb_flight_, &done_));
-  //setReward(utilities_.assignRewardWithoutFlightBB(quadrotorPose_, bb_landing_, bb_flight_, &done_)); // for simulation_1
-  setReward(utilities_.assignRewardWhenLanding(quadrotorPose_, bb_landing_, bb_flight_, &done_, action_)); // for simulation_2
+  RewardOutcome outcome;
+  reward_engine_.evaluate(quadrotorPose_.position.x, quadrotorPose_.position.y, quadrotorPose_.position.z, action_,
+                          &outcome);
+  setReward(outcome.reward);
+  done_ = outcome.done;
+  wrong_altitude_ = outcome.wrong_altitude;
+  action_reward_ += reward_;
+  action_evaluations_++;
+  // A repeated action is a single transition, which ends with the last of its evaluations
+  if (repeatAction() == false)
+  {
+    recordOutcome();
+  }
+  // The first evaluation with done ends the episode, whatever happens until the reset
+  if (done_ == true && episode_reported_ == false)
+  {
+    episode_reported_ = true;
+    if (curriculum_.reportEpisode(outcome.reward == reward_engine_.getConfig().success_reward))
+    {
+      spawn_sampler_.setConfig(curriculum_.getSpawnConfig());
+      ROS_INFO("Curriculum stage %d of %d", curriculum_.getStage() + 1, curriculum_.getNumStages());
+    }
+  }
+
+  // Wake up the step requests waiting for this evaluation
+  tick_++;
+  TickSnapshot snapshot;
+  snapshot.tick = tick_;
+  snapshot.reward = reward_;
+  snapshot.done = done_;
+  snapshot.wrong_altitude = wrong_altitude_;
+  snapshot.relative[0] = quadrotor_to_marker_pose_.position.x;
+  snapshot.relative[1] = quadrotor_to_marker_pose_.position.y;
+  snapshot.relative[2] = quadrotor_to_marker_pose_.position.z;
+  tick_snapshot_.write(snapshot);
+  publishObservation();
+  tick_cond_.notify_all();
+  endStage(STAGE_REWARD, start, tick_);
+}
+
+bool DeepReinforcedLanding::repeatAction()
+{
+  if (step_repeat_left_ == 0)
+  {
+    return false;
+  }
+  if (--step_repeat_left_ > 0 && done_ == false)
+  {
+    // The UAV keeps the velocity, in lockstep mode the physics is stepped again
+    out_.copyTo(step_prev_frame_);
+    lockstep_pending_ = lockstep_;
+    return true;
+  }
+
+  step_repeat_left_ = 0;
+  // Max-pooling the last two frames removes the flickering of objects drawn in alternate frames
+  if (action_evaluations_ > 1)
+  {
+    cv::max(step_prev_frame_, out_, step_frame_);
+  }
+  else
+  {
+    out_.copyTo(step_frame_);
+  }
+  step_finished_id_ = step_applied_id_;
+  return false;
+}
+
+void DeepReinforcedLanding::endStage(Stage stage, int64_t start, uint64_t arg)
+{
+  const int64_t end = LatencyHistogram::now();
+  latency_[stage].record(end - start);
+  tracer_.span(STAGE_NAMES[stage], start, end, arg);
+}
+
+void DeepReinforcedLanding::updatePads()
+{
+  if (marker_names_.empty())
+  {
+    return;
+  }
+  geometry_msgs::Pose pose;
+  size_t lookups = pads_.getSize() < marker_names_.size() ? marker_names_.size() : 1;
+  for (; lookups > 0; lookups--)
+  {
+    const size_t marker = next_marker_;
+    next_marker_ = (next_marker_ + 1) % marker_names_.size();
+    if (state_cache_.getPose(marker_names_[marker], pose) == false)
+    {
+      continue;
+    }
+    if (marker_pads_[marker] < 0)
+    {
+      marker_pads_[marker] = pads_.addPad(pose.position.x, pose.position.y, pose.position.z);
+    }
+    else
+    {
+      pads_.movePad(marker_pads_[marker], pose.position.x, pose.position.y, pose.position.z);
+    }
+  }
+}
+
+void DeepReinforcedLanding::publishObservation()
+{
+  if (shared_memory_.isOpen() == false)
+  {
+    return;
+  }
+  const geometry_msgs::Pose &relative = quadrotor_to_marker_pose_;
+  double pose[7] = { relative.position.x,    relative.position.y,    relative.position.z,   relative.orientation.x,
+                     relative.orientation.y, relative.orientation.z, relative.orientation.w };
+  frame_stack_.copyStacked(out_.data, shared_memory_.beginWrite());
+  shared_memory_.endWrite(tick_, ros::Time::now().toSec(), reward_, done_, wrong_altitude_, pose);
+}
+
+void DeepReinforcedLanding::recordAction(ActionId action)
+{
+  if (recorder_.isOpen() == false)
+  {
+    return;
+  }
+  record_ = action != ACTION_UNKNOWN ? recorder_.beginRecord() : NULL;
+  if (record_ == NULL)
+  {
+    // Commands that are not actions (takeoff) are not recorded, nor the action they replace
+    recorder_.cancelRecord();
+    return;
+  }
+  frame_stack_.copyStacked(out_.data, record_->image_t);
+  record_->action = action;
+}
+
+void DeepReinforcedLanding::recordOutcome()
+{
+  if (record_ == NULL)
+  {
+    return;
+  }
+  frame_stack_.copyStacked(out_.data, record_->image_t1);
+  // The sum of the rewards of a repeated action
+  record_->reward = action_reward_;
+  record_->done = done_;
+  record_->position[0] = quadrotor_to_marker_pose_.position.x;
+  record_->position[1] = quadrotor_to_marker_pose_.position.y;
+  record_->position[2] = quadrotor_to_marker_pose_.position.z;
+  recorder_.endRecord();
+  record_ = NULL;
+}
+
+void DeepReinforcedLanding::applyAction(int id)
+{
+  const ActionEntry *entry = actions_.get(id);
+  action_ = entry != NULL ? entry->action : ACTION_UNKNOWN;
+  action_reward_ = 0;
+  action_evaluations_ = 0;
+  // The current frame is the observation on which the action has been chosen
+  recordAction(action_);
+  frame_stack_.push(out_.data);
+  // Every command sets all the axes, "left" after "forward" does not move diagonally
+  velocity_cmd_ = geometry_msgs::Twist();
+
+  if (entry == NULL)
+  {
+    // Unknown commands stop the UAV
+    can_move_ = true;
+  }
+  else if (entry->kind == ACTION_KIND_TAKEOFF)
+  {
+    can_takeoff_ = true;
+  }
+  else if (entry->kind == ACTION_KIND_LAND)
+  {
+    can_land_ = true;
+  }
+  else
+  {
+    velocity_cmd_.linear.x = entry->velocity[0];
+    velocity_cmd_.linear.y = entry->velocity[1];
+    velocity_cmd_.linear.z = entry->velocity[2];
+    velocity_cmd_.angular.z = entry->velocity[3];
+    can_move_ = true;
+  }
+}
+
+void DeepReinforcedLanding::applyStepCommand()
+{
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  if (has_step_command_)
+  {
+    command_received_ = step_received_;
+    applyAction(step_action_);
+    has_step_command_ = false;
+    step_applied_id_ = step_requested_id_;
+    step_repeat_left_ = step_repeat_;
+    lockstep_pending_ = lockstep_;
+  }
+}
+
+void DeepReinforcedLanding::publishCommand()
+{
+  bool takeoff, move;
+  geometry_msgs::Twist velocity_cmd;
+  ros::WallTime received;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    takeoff = can_takeoff_;
+    move = can_takeoff_ == false && can_land_ == false && can_move_;
+    velocity_cmd = velocity_cmd_;
+    received = command_received_;
+    // Land commands are consumed without being published
+    if (can_takeoff_)
+    {
+      can_takeoff_ = false;
+    }
+    else if (can_land_)
+    {
+      can_land_ = false;
+    }
+    else
+    {
+      can_move_ = false;
+    }
+  }
+
+  const int64_t start = LatencyHistogram::now();
+  if (takeoff)
+  {
+    dispatcher_.takeoff(received);
+  }
+  else if (move)
+  {
+    dispatcher_.move(velocity_cmd, received);
+  }
+  if (takeoff || move)
+  {
+    tracer_.span("command_published", start, LatencyHistogram::now());
+  }
+}
+
+bool DeepReinforcedLanding::getLockstep()
+{
+  return lockstep_;
+}
+
+void DeepReinforcedLanding::advanceLockstep()
+{
+  if (lockstep_pending_ == false)
+  {
+    return;
+  }
+  lockstep_pending_ = false;
+
+  // Give the controller the time to receive the command before the first iteration runs
+  ros::WallDuration(lockstep_publish_delay_).sleep();
+  const int64_t physics_start = LatencyHistogram::now();
+  ros::Time start = ros::Time::now();
+  stepper_.step(lockstep_iterations_, ros::WallDuration(lockstep_timeout_));
+
+  // Wait for the image thread to process a frame rendered after the command
+  {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    if (frame_cond_.wait_for(lock, std::chrono::duration<double>(lockstep_timeout_),
+                             [&] { return last_frame_stamp_ > start; }) == false)
+    {
+      // The reward is evaluated on the last frame received
+      __atomic_fetch_add(&missed_deadlines_, 1, __ATOMIC_RELAXED);
+    }
+  }
+  endStage(STAGE_PHYSICS, physics_start, tick_ + 1);
+
+  setReward();
+}
+
+void DeepReinforcedLanding::recordLoop(int64_t start, int64_t end, bool overrun)
+{
+  latency_[STAGE_LOOP].record(end - start);
+  tracer_.span(STAGE_NAMES[STAGE_LOOP], start, end);
+  if (overrun)
+  {
+    __atomic_fetch_add(&loop_overruns_, 1, __ATOMIC_RELAXED);
+  }
 }
 
-void DeepReinforcedLanding::setActionCommand(std::string action)
+void DeepReinforcedLanding::publishDiagnostics()
 {
-  action_ = action;
-  //cout << "Message received: " << action_ << endl;
+  const ros::WallTime now = ros::WallTime::now();
+  if (diagnostics_period_ <= 0.0 || now < next_diagnostics_)
+  {
+    return;
+  }
+  next_diagnostics_ = now + ros::WallDuration(diagnostics_period_);
+  if (diagnostics_pub_.getNumSubscribers() == 0)
+  {
+    return;
+  }
+
+  diagnostic_msgs::DiagnosticArray diagnostics;
+  diagnostics.header.stamp = ros::Time::now();
+  diagnostic_msgs::KeyValue value;
+  for (int stage = 0; stage < NUM_STAGES; stage++)
+  {
+    const LatencyHistogram &latency = latency_[stage];
+    diagnostic_msgs::DiagnosticStatus status;
+    status.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status.name = std::string("drl_node: ") + STAGE_NAMES[stage];
+    status.message = "latency [ms]";
+    value.key = "count";
+    value.value = std::to_string(latency.getCount());
+    status.values.push_back(value);
+    value.key = "mean";
+    value.value = std::to_string(latency.getMean() * 1e-6);
+    status.values.push_back(value);
+    const double percentiles[] = { 50.0, 90.0, 99.0 };
+    for (int i = 0; i < 3; i++)
+    {
+      value.key = "p" + std::to_string((int)percentiles[i]);
+      value.value = std::to_string(latency.getPercentile(percentiles[i]) * 1e-6);
+      status.values.push_back(value);
+    }
+    value.key = "max";
+    value.value = std::to_string(latency.getMax() * 1e-6);
+    status.values.push_back(value);
+    diagnostics.status.push_back(status);
+  }
+
+  // The counters warn when they have grown since the last publication
+  const uint64_t overruns = __atomic_load_n(&loop_overruns_, __ATOMIC_RELAXED);
+  const uint64_t deadlines = __atomic_load_n(&missed_deadlines_, __ATOMIC_RELAXED);
+  const uint64_t drops = __atomic_load_n(&dropped_frames_, __ATOMIC_RELAXED);
+  diagnostic_msgs::DiagnosticStatus status;
+  status.name = "drl_node: counters";
+  status.level = overruns > published_overruns_ || deadlines > published_deadlines_ || drops > published_drops_ ?
+                     diagnostic_msgs::DiagnosticStatus::WARN : diagnostic_msgs::DiagnosticStatus::OK;
+  status.message = status.level == diagnostic_msgs::DiagnosticStatus::OK ? "ok" : "hot path behind";
+  value.key = "loop_overruns";
+  value.value = std::to_string(overruns);
+  status.values.push_back(value);
+  value.key = "missed_deadlines";
+  value.value = std::to_string(deadlines);
+  status.values.push_back(value);
+  value.key = "dropped_frames";
+  value.value = std::to_string(drops);
+  status.values.push_back(value);
+  diagnostics.status.push_back(status);
+  published_overruns_ = overruns;
+  published_deadlines_ = deadlines;
+  published_drops_ = drops;
+
+  diagnostics_pub_.publish(diagnostics);
 }
 
 int main(int argc, char **argv)
@@ -651,15 +1621,16 @@ int main(int argc, char **argv)
   DeepReinforcedLanding drl_node;
   gazebo_msgs::SetModelState tmp_model_state;
   ros::Rate rate(30);
-  std_msgs::Empty land_takeoff_cmd;
-  double reward;
 
 
   while(ros::ok()){
+    const int64_t loop_start = LatencyHistogram::now();
 
-
-    // Calculate the reward at every iteration
-    drl_node.setReward();
+    // Calculate the reward at every iteration (in lockstep mode only after the physics has been stepped)
+    if (drl_node.getLockstep() == false)
+    {
+      drl_node.setReward();
+    }
     
     // Reset position only if the reset service has been called;
     if (drl_node.getReset() == true)
@@ -670,25 +1641,27 @@ int main(int argc, char **argv)
     //then set to false the bool variable to not publish further msg at the following iteration
     drl_node.setReset(false);
 
-    // Send command if requested---------------
-    if(drl_node.getCanTakeOff())
+    // Apply the command of a pending step request, its outcome is evaluated at the next iteration
+    drl_node.applyStepCommand();
+
+    // Send command if requested
+    drl_node.publishCommand();
+    drl_node.publishDiagnostics();
+
+    if (drl_node.getLockstep() == true)
     {
-      drl_node.getTakeoffPub().publish(land_takeoff_cmd);
-      drl_node.setCanTakeOff(false);
+      // No wall-clock rate: run the physics as soon as a step is requested
+      drl_node.advanceLockstep();
+      drl_node.recordLoop(loop_start, LatencyHistogram::now(), false);
+      ros::getGlobalCallbackQueue()->callAvailable(ros::WallDuration(0.001));
     }
-    else if(drl_node.getCanLand())
-    {
-      //drl_node.getLandPub().publish(land_takeoff_cmd);
-      drl_node.setCanLand(false);
-    }else if(drl_node.getCanMove())
+    else
     {
-      drl_node.getCmdPub().publish(drl_node.getVelocityCmd());
-      drl_node.setCanMove(false);
+      ros::spinOnce();
+      // The work is timed without the sleep, which returns false when the iteration took longer than the period
+      const int64_t loop_end = LatencyHistogram::now();
+      drl_node.recordLoop(loop_start, loop_end, rate.sleep() == false);
     }
-    //-----------------------------------------
-
-    ros::spinOnce();
-    rate.sleep();
   }
 
   return 0;
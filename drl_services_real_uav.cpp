@@ -12,8 +12,14 @@
 
   Main class for the deep reinforced landing node.
 */
-#include "../include/boundingBox.h"
-#include "../include/utilities.h"
+#include "../include/actionTable.h"
+#include "../include/actions.h"
+#include "../include/commandDispatcher.h"
+#include "../include/framePreprocessor.h"
+#include "../include/frameStack.h"
+#include "../include/rewardEngine.h"
+#include "../include/spawnSampler.h"
+#include "../include/traceRecorder.h"
 #include "ardrone_autonomy/Navdata.h"
 #include "gazebo_msgs/GetModelState.h"
 #include "gazebo_msgs/ModelState.h"
@@ -25,22 +31,30 @@
 #include "ros/service_client.h"
 #include "sensor_msgs/Image.h"
 #include "std_msgs/Empty.h"
+#include <algorithm>
+#include <condition_variable>
 #include <cv_bridge/cv_bridge.h>
 #include <image_transport/image_transport.h>
 #include <map>
 #include <math.h>
+#include <memory>
+#include <mutex>
+#include <ros/callback_queue.h>
+#include <ros/spinner.h>
 #include <std_srvs/Empty.h>
 #include <stdlib.h>
 #include <string>
-#include <tf/LinearMath/Matrix3x3.h>
 #include <tf/transform_datatypes.h>
 
 #include "deep_reinforced_landing/GetCameraImage.h"
 #include "deep_reinforced_landing/GetDoneAndReward.h"
+#include "deep_reinforced_landing/GetFrameStack.h"
 #include "deep_reinforced_landing/GetRelativePose.h"
 #include "deep_reinforced_landing/NewCameraService.h"
 #include "deep_reinforced_landing/ResetPosition.h"
+#include "deep_reinforced_landing/SendAction.h"
 #include "deep_reinforced_landing/SendCommand.h"
+#include "deep_reinforced_landing/Step.h"
 
 const int LANDED_STATUS = 2;
 
@@ -51,6 +65,13 @@ using namespace cv;
 class DeepReinforcedLandingUAV {
 private:
   ros::NodeHandle nh_;
+  // Callbacks are served by one thread per role, so that none of them waits
+  // for the others: the camera, the commands and resets, the state/reward
+  // queries. The global queue is left to the main loop.
+  ros::NodeHandle nh_image_, nh_control_, nh_services_;
+  ros::CallbackQueue image_queue_, control_queue_, services_queue_;
+  std::unique_ptr<ros::AsyncSpinner> image_spinner_, control_spinner_,
+      services_spinner_;
   // Create a subscriber for getting the UAV's latests status
   ros::Subscriber uav_sub_;
   // Subscribe to the bottom camera's topic
@@ -74,13 +95,22 @@ private:
   // Create a service for offering the full camera's image or only the matrix
   ros::ServiceServer service_camera_;
   ros::ServiceServer service_camera_matrix_;
+  ros::ServiceServer service_camera_stack_;
   // Create a service to invoke control's publisher (cmd_pub_, land_pub_,
   // takeoff_pub_)
   ros::ServiceServer service_send_command_;
+  ros::ServiceServer service_send_action_;
   // Create a service for getting the reset request...
   ros::ServiceServer service_reset_;
   // ...and then call the service offered by gazebo
   ros::ServiceClient set_state_client_;
+  // Create a service that applies a command and returns the outcome in one
+  // call. It is served from its own queue so that it can wait for the main
+  // loop.
+  ros::NodeHandle nh_step_;
+  ros::CallbackQueue step_queue_;
+  std::unique_ptr<ros::AsyncSpinner> step_spinner_;
+  ros::ServiceServer service_step_;
 
   //--------Callbacks and Services-----
   /*
@@ -95,7 +125,7 @@ private:
 
     @param msg is the latest frame acquired by the camera
   */
-  void getImageCallback(const sensor_msgs::Image &msg);
+  void getImageCallback(const sensor_msgs::ImageConstPtr &msg);
 
   /*
     Get UAV's pose
@@ -125,6 +155,17 @@ private:
   */
   bool getNewCamera(deep_reinforced_landing::NewCameraService::Request &req,
                     deep_reinforced_landing::NewCameraService::Response &res);
+
+  /*
+    Get the stacked observation fed to the Q-network
+
+    @param req is an empty message
+    @param res is the height x width x depth block of the frames observed at
+    the last actions plus the latest one
+  */
+  bool
+  getCameraImageStack(deep_reinforced_landing::GetFrameStack::Request &req,
+                      deep_reinforced_landing::GetFrameStack::Response &res);
   /*
     Set new UAV's pose
 
@@ -146,10 +187,38 @@ private:
   bool sendCommand(deep_reinforced_landing::SendCommand::Request &req,
                    deep_reinforced_landing::SendCommand::Response &res);
 
+  /*
+    Send a new command to the UAV by its index in the action table
+
+    @param req is the index of the action (/drl_node/action_names)
+    @param res is false if the index is not in the table, the UAV is stopped
+    instead
+  */
+  bool sendAction(deep_reinforced_landing::SendAction::Request &req,
+                  deep_reinforced_landing::SendAction::Response &res);
+
   bool getRelativePose(deep_reinforced_landing::GetRelativePose::Request &req,
                        deep_reinforced_landing::GetRelativePose::Response &res);
 
-  void setActionCommand(std::string action);
+  /*
+    Apply a command, wait for the following reward evaluation and return
+    everything in one response
+
+    @param req is the command to send to the UAV (same strings accepted by
+    sendCommand)
+    @param res contains reward, done, wrong_altitude, the pose wrt the marker
+    and the 84x84 greyscale frame
+  */
+  bool step(deep_reinforced_landing::Step::Request &req,
+            deep_reinforced_landing::Step::Response &res);
+
+  /*
+    Translate an action into velocities and flags read by the main loop
+
+    @param id is the index of the action in the table, any other value stops
+    the UAV
+  */
+  void applyAction(int id);
 
   //-------Data-----------
   // Server for getting UAV's pose and various related variables
@@ -162,30 +231,56 @@ private:
   // Half side for the landing BB and the flight one
   double bb_landing_half_size_, bb_flight_half_size_;
   double bb_landing_height_, bb_flight_height_;
-  BoundingBox bb_landing_, bb_flight_;
+  RewardEngine reward_engine_;
   double respawn_height;
+  // Respawn poses wrt the marker, reproducible from /drl_node/seed
+  SpawnSampler spawn_sampler_;
 
   // Reinforcement Learning data
   bool done_;
   float reward_;
   bool reset_;
-  std::string action_;
+  ActionId action_;
+  // Velocities of the commands, indexed by the integer of drl/send_action
+  // (/drl_node/action_*)
+  ActionTable actions_;
 
   bool wrong_altitude_;
   float altitude_;
 
+  // Synchronisation between the step service and the main loop
+  std::mutex state_mutex_;
+  std::condition_variable tick_cond_;
+  unsigned long tick_;
+  // Index of the action of the pending step request, -1 if its command is not
+  // in the table
+  int step_action_;
+  bool has_step_command_;
+  unsigned long step_requested_id_, step_applied_id_, step_applied_tick_;
+
   // Image related variables
-  sensor_msgs::Image image_total_;
-  cv::Mat src_;
+  sensor_msgs::ImageConstPtr image_total_;
   cv::Mat out_;
+  FramePreprocessor preprocessor_;
+  // Frames observed when the last actions were chosen
+  FrameStack frame_stack_;
+  int frame_stack_depth_;
 
   // UAV's flight control related variables
   geometry_msgs::Twist velocity_cmd_;
   std_msgs::Empty land_takeoff_cmd_;
   bool can_takeoff_, can_land_, can_move_;
-
-  // Offers useful methods
-  Utilities utilities_;
+  // When the command being applied and the one of the pending step request
+  // reached the node
+  ros::WallTime command_received_, step_received_;
+  // Publishes the commands as soon as they are applied, re-sends them and
+  // stops the UAV if no new command arrives (/drl_node/command_rate,
+  // command_hold)
+  CommandDispatcher dispatcher_;
+  // Optional timeline of the stages of every step, written as Chrome trace
+  // events by a background thread (/drl_node/trace_path)
+  TraceRecorder tracer_;
+  std::string trace_path_;
 
 protected:
 public:
@@ -222,11 +317,25 @@ public:
   int getReward();
   void setReward(double reward);
   void setReward();
+  /*
+    Apply the command of a pending step request, if any. Must be called by the
+    main loop after setReward() and before the commands are published.
+  */
+  void applyStepCommand();
+  /*
+    Publish the command applied since the last call, if any. Called right
+    after drl/send_command and by the main loop for the step requests.
+  */
+  void publishCommand();
 };
 
 DeepReinforcedLandingUAV::DeepReinforcedLandingUAV() {
-  camera_sub_ = nh_.subscribe("ardrone/bottom/image_raw", 1,
-                              &DeepReinforcedLandingUAV::getImageCallback, this);
+  nh_image_.setCallbackQueue(&image_queue_);
+  nh_control_.setCallbackQueue(&control_queue_);
+  nh_services_.setCallbackQueue(&services_queue_);
+  camera_sub_ =
+      nh_image_.subscribe("ardrone/bottom/image_raw", 1,
+                          &DeepReinforcedLandingUAV::getImageCallback, this);
   cmd_pub_ = nh_.advertise<geometry_msgs::Twist>("/cmd_vel", 1);
   land_pub_ = nh_.advertise<std_msgs::Empty>("/ardrone/land", 1);
   takeoff_pub_ = nh_.advertise<std_msgs::Empty>("/ardrone/takeoff", 1);
@@ -237,21 +346,31 @@ DeepReinforcedLandingUAV::DeepReinforcedLandingUAV() {
 
   get_state_client_ =
       nh_.serviceClient<gazebo_msgs::GetModelState>("/gazebo/get_model_state");
-  service_done_reward_ = nh_.advertiseService(
+  service_done_reward_ = nh_services_.advertiseService(
       "drl/get_done_reward", &DeepReinforcedLandingUAV::getStatus, this);
-  service_camera_ = nh_.advertiseService(
+  service_camera_ = nh_services_.advertiseService(
       "drl/get_camera_image", &DeepReinforcedLandingUAV::getCameraImage, this);
   service_camera_matrix_ =
-      nh_.advertiseService("drl/get_camera_image_matrix",
-                           &DeepReinforcedLandingUAV::getNewCamera, this);
-  service_reset_ = nh_.advertiseService(
+      nh_services_.advertiseService("drl/get_camera_image_matrix",
+                                    &DeepReinforcedLandingUAV::getNewCamera,
+                                    this);
+  service_camera_stack_ = nh_services_.advertiseService(
+      "drl/get_camera_image_stack",
+      &DeepReinforcedLandingUAV::getCameraImageStack, this);
+  service_reset_ = nh_control_.advertiseService(
       "drl/set_model_state", &DeepReinforcedLandingUAV::setModelState, this);
   set_state_client_ =
       nh_.serviceClient<gazebo_msgs::SetModelState>("/gazebo/set_model_state");
-  service_send_command_ = nh_.advertiseService(
+  service_send_command_ = nh_control_.advertiseService(
       "drl/send_command", &DeepReinforcedLandingUAV::sendCommand, this);
-  service_relative_pose_ = nh_.advertiseService(
-      "drl/get_relative_pose", &DeepReinforcedLandingUAV::getRelativePose, this);
+  service_send_action_ = nh_control_.advertiseService(
+      "drl/send_action", &DeepReinforcedLandingUAV::sendAction, this);
+  service_relative_pose_ = nh_services_.advertiseService(
+      "drl/get_relative_pose", &DeepReinforcedLandingUAV::getRelativePose,
+      this);
+  nh_step_.setCallbackQueue(&step_queue_);
+  service_step_ =
+      nh_step_.advertiseService("drl/step", &DeepReinforcedLandingUAV::step, this);
 
   // With a flight BB having 15m per side, we need a minimum height of 20m for
   // perceiving the marker
@@ -266,6 +385,91 @@ DeepReinforcedLandingUAV::DeepReinforcedLandingUAV() {
   // Calculate the side of the landing BB's base and divide it by two
   // bb_landing_half_size_ = sqrt(bb_landing_volume / bb_flight_height_) / 2;
   bb_landing_half_size_ = 0.75; // add math expression
+  nh_.param("/drl_node/frame_stack_depth", frame_stack_depth_, 4);
+  double command_rate, command_hold;
+  nh_.param("/drl_node/command_rate", command_rate, 30.0);
+  nh_.param("/drl_node/command_hold", command_hold, 0.5);
+  dispatcher_.init(cmd_pub_, takeoff_pub_, land_pub_, command_rate,
+                   command_hold);
+  int trace_ring_size;
+  nh_.param("/drl_node/trace_path", trace_path_, std::string(""));
+  nh_.param("/drl_node/trace_ring_size", trace_ring_size, 4096);
+  if (!trace_path_.empty() &&
+      !tracer_.open(trace_path_, std::max(trace_ring_size, 1))) {
+    ROS_ERROR("Trace file %s cannot be created, the steps are not traced",
+              trace_path_.c_str());
+  }
+
+  // Reward of simulation_1/6 (the former
+  // Utilities::assignRewardWithoutFlightBB with the action)
+  RewardConfig reward_config;
+  reward_config.policy = REWARD_LANDING_ALTITUDE;
+  reward_config.landing_half_size = bb_landing_half_size_;
+  reward_config.landing_height = bb_landing_height_;
+  reward_config.flight_half_size = bb_flight_half_size_;
+  reward_config.flight_height = bb_flight_height_;
+  reward_engine_ = RewardEngine(reward_config);
+
+  // Respawns over the flight box, from 1 m above the landing box to 15 m over
+  // the marker, unless the parameters of drl_services_node are set
+  SpawnConfig spawn_config;
+  spawn_config.xy_half_size = bb_flight_half_size_;
+  spawn_config.z_from = bb_landing_height_ + 1.0;
+  spawn_config.z_to = 15.0 - bb_landing_height_;
+  spawn_config.z_from_2 = spawn_config.z_from;
+  spawn_config.z_to_2 = spawn_config.z_to;
+  std::string xy_gaussian_uniform;
+  int spawn_seed;
+  nh_.param("/drl_node/xy_gaussian_uniform", xy_gaussian_uniform,
+            std::string("uniform"));
+  nh_.param("/drl_node/xy_gaussian_mean", spawn_config.xy_mean,
+            spawn_config.xy_mean);
+  nh_.param("/drl_node/xy_gaussian_stdev", spawn_config.xy_stdev,
+            spawn_config.xy_stdev);
+  nh_.param("/drl_node/num_z_uniform", spawn_config.z_bands,
+            spawn_config.z_bands);
+  nh_.param("/drl_node/z_uniform_from", spawn_config.z_from,
+            spawn_config.z_from);
+  nh_.param("/drl_node/z_uniform_to", spawn_config.z_to, spawn_config.z_to);
+  nh_.param("/drl_node/z_uniform_from_2", spawn_config.z_from_2,
+            spawn_config.z_from_2);
+  nh_.param("/drl_node/z_uniform_to_2", spawn_config.z_to_2,
+            spawn_config.z_to_2);
+  if (!nh_.getParam("/drl_node/seed", spawn_seed)) {
+    spawn_seed = std::random_device()() & 0x7fffffff;
+  }
+  spawn_config.xy_gaussian = xy_gaussian_uniform == "gaussian";
+  std::string spawn_error;
+  if (xy_gaussian_uniform != "gaussian" && xy_gaussian_uniform != "uniform") {
+    ROS_ERROR("A wrong distribution has been chosen (typo?). [uniform or "
+              "gaussian]");
+    ros::shutdown();
+  } else if (!spawn_config.validate(&spawn_error)) {
+    ROS_ERROR("Invalid respawn distribution (%s), check "
+              "/drl_node/xy_gaussian_* and /drl_node/*z_uniform*",
+              spawn_error.c_str());
+    ros::shutdown();
+  }
+  spawn_sampler_ = SpawnSampler(spawn_config, spawn_seed);
+  ROS_INFO("Respawn seed %d (/drl_node/seed)", spawn_seed);
+
+  // The real UAV descends slower than it moves, and flies the diagonals
+  actions_ = ActionTable::defaults(0.5, 0.2, true);
+  std::vector<std::string> action_names;
+  std::vector<double> action_directions, action_magnitudes;
+  nh_.param("/drl_node/action_names", action_names,
+            std::vector<std::string>());
+  nh_.param("/drl_node/action_directions", action_directions,
+            std::vector<double>());
+  nh_.param("/drl_node/action_magnitudes", action_magnitudes,
+            std::vector<double>());
+  std::string action_error;
+  if (!action_names.empty() &&
+      !actions_.load(action_names, action_directions, action_magnitudes,
+                     &action_error)) {
+    ROS_ERROR("Invalid action table (%s), the default one is used",
+              action_error.c_str());
+  }
 
   done_ = false;
   reward_ = 0;
@@ -275,6 +479,16 @@ DeepReinforcedLandingUAV::DeepReinforcedLandingUAV() {
   can_move_ = false;
 
   wrong_altitude_ = false;
+  out_ = cv::Mat::zeros(preprocessor_.getOutSize(), preprocessor_.getOutSize(),
+                        CV_8UC1);
+  frame_stack_ =
+      FrameStack(out_.rows, out_.cols, std::max(frame_stack_depth_, 1));
+
+  action_ = ACTION_UNKNOWN;
+  tick_ = 0;
+  step_action_ = -1;
+  has_step_command_ = false;
+  step_requested_id_ = step_applied_id_ = step_applied_tick_ = 0;
 
   //----------- RESET POSE -----
   start_pose_.position.x = start_pose_.position.y = start_pose_.position.z = 0;
@@ -297,14 +511,42 @@ DeepReinforcedLandingUAV::DeepReinforcedLandingUAV() {
     set_state_client_.call(set_model_state_);
   }
   reset_ = false;
+
+  step_spinner_.reset(new ros::AsyncSpinner(1, &step_queue_));
+  step_spinner_->start();
+  image_spinner_.reset(new ros::AsyncSpinner(1, &image_queue_));
+  image_spinner_->start();
+  control_spinner_.reset(new ros::AsyncSpinner(1, &control_queue_));
+  control_spinner_->start();
+  services_spinner_.reset(new ros::AsyncSpinner(1, &services_queue_));
+  services_spinner_->start();
 }
 
-DeepReinforcedLandingUAV::~DeepReinforcedLandingUAV() {}
+DeepReinforcedLandingUAV::~DeepReinforcedLandingUAV() {
+  step_spinner_->stop();
+  image_spinner_->stop();
+  control_spinner_->stop();
+  services_spinner_->stop();
+  dispatcher_.shutdown();
+  if (tracer_.isOpen()) {
+    tracer_.close();
+    ROS_INFO("%lu events traced in %s, %lu dropped",
+             (unsigned long)tracer_.getWritten(), trace_path_.c_str(),
+             (unsigned long)tracer_.getDropped());
+  }
+  if (dispatcher_.getDispatched() > 0) {
+    ROS_INFO("%lu commands, command to publish latency mean %.3f ms, max "
+             "%.3f ms",
+             dispatcher_.getDispatched(), dispatcher_.getMeanLatency() * 1e3,
+             dispatcher_.getMaxLatency() * 1e3);
+  }
+}
 
 //----------------SERVICES-----------
 bool DeepReinforcedLandingUAV::getStatus(
     deep_reinforced_landing::GetDoneAndReward::Request &req,
     deep_reinforced_landing::GetDoneAndReward::Response &res) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
   res.done = done_;
   res.reward = reward_;
   res.wrong_altitude = wrong_altitude_;
@@ -321,24 +563,44 @@ bool DeepReinforcedLandingUAV::getStatus(
 bool DeepReinforcedLandingUAV::getCameraImage(
     deep_reinforced_landing::GetCameraImage::Request &req,
     deep_reinforced_landing::GetCameraImage::Response &res) {
-  res.image = image_total_;
+  // The frame is immutable, only the reference is taken under the lock
+  sensor_msgs::ImageConstPtr image;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    image = image_total_;
+  }
+  if (image) {
+    res.image = *image;
+  }
   return true;
 }
 
 bool DeepReinforcedLandingUAV::getNewCamera(
     deep_reinforced_landing::NewCameraService::Request &req,
     deep_reinforced_landing::NewCameraService::Response &res) {
+  // out_ is a continuous 8UC1 buffer preallocated in the constructor
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  size_t size = std::min(out_.total(), (size_t)res.image.size());
+  std::copy(out_.data, out_.data + size, res.image.begin());
+  return true;
+}
 
-  int size = out_.rows * out_.cols;
-  for (int i = 0; i < size; i++) {
-    res.image[i] = out_.at<int>(i);
-  }
+bool DeepReinforcedLandingUAV::getCameraImageStack(
+    deep_reinforced_landing::GetFrameStack::Request &req,
+    deep_reinforced_landing::GetFrameStack::Response &res) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  res.height = frame_stack_.getHeight();
+  res.width = frame_stack_.getWidth();
+  res.depth = frame_stack_.getDepth();
+  res.image.resize(out_.total() * res.depth);
+  frame_stack_.copyStacked(out_.data, &res.image[0]);
   return true;
 }
 
 bool DeepReinforcedLandingUAV::setModelState(
     deep_reinforced_landing::ResetPosition::Request &req,
     deep_reinforced_landing::ResetPosition::Response &res) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
   reset_ = req.reset;
   return true;
 }
@@ -346,61 +608,30 @@ bool DeepReinforcedLandingUAV::setModelState(
 bool DeepReinforcedLandingUAV::sendCommand(
     deep_reinforced_landing::SendCommand::Request &req,
     deep_reinforced_landing::SendCommand::Response &res) {
-  setActionCommand(req.command);
-
-  float velocity = 0.5;
-  if (req.command == "left") {
-    velocity_cmd_.linear.y = velocity;
-    can_move_ = true;
-  } else if (req.command == "left_forward") {
-    velocity_cmd_.linear.y = velocity;
-    velocity_cmd_.linear.x = velocity;
-    can_move_ = true;
-  } else if (req.command == "right") {
-    velocity_cmd_.linear.y = -velocity;
-    can_move_ = true;
-  } else if (req.command == "right_forward") {
-    velocity_cmd_.linear.y = -velocity;
-    velocity_cmd_.linear.x = velocity;
-    can_move_ = true;
-  } else if (req.command == "forward") {
-    velocity_cmd_.linear.x = velocity;
-    can_move_ = true;
-  } else if (req.command == "backward") {
-    velocity_cmd_.linear.x = -velocity;
-    can_move_ = true;
-  } else if (req.command == "left_backward") {
-    velocity_cmd_.linear.y = velocity;
-    velocity_cmd_.linear.x = -velocity;
-    can_move_ = true;
-  } else if (req.command == "right_backward") {
-    velocity_cmd_.linear.y = -velocity;
-    velocity_cmd_.linear.x = -velocity;
-    can_move_ = true;
-  } else if (req.command == "ascend") {
-    velocity_cmd_.linear.z = velocity;
-    can_move_ = true;
-  } else if (req.command == "descend") {
-    velocity_cmd_.linear.z = -0.2;
-    can_move_ = true;
-  } else if (req.command == "rotate_left") {
-    velocity_cmd_.angular.z = velocity;
-    can_move_ = true;
-  } else if (req.command == "rotate_right") {
-    velocity_cmd_.angular.z = -velocity;
-    can_move_ = true;
-  } else if (req.command == "takeoff") {
-    can_takeoff_ = true;
-  } else if (req.command == "land") {
-    can_land_ = true;
-  } else {
-    velocity_cmd_.linear.x = velocity_cmd_.linear.y = velocity_cmd_.linear.z =
-        0;
-    velocity_cmd_.angular.x = velocity_cmd_.angular.y =
-        velocity_cmd_.angular.z = 0;
-    can_move_ = true;
+  const ros::WallTime received = ros::WallTime::now();
+  tracer_.instant("command_received");
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    command_received_ = received;
+    applyAction(actions_.find(req.command));
   }
+  // Published now rather than at the next pass of the main loop
+  publishCommand();
+  return true;
+}
 
+bool DeepReinforcedLandingUAV::sendAction(
+    deep_reinforced_landing::SendAction::Request &req,
+    deep_reinforced_landing::SendAction::Response &res) {
+  const ros::WallTime received = ros::WallTime::now();
+  tracer_.instant("command_received");
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    command_received_ = received;
+    applyAction(req.action);
+  }
+  publishCommand();
+  res.success = actions_.get(req.action) != NULL;
   return true;
 }
 
@@ -411,12 +642,53 @@ bool DeepReinforcedLandingUAV::getRelativePose(
   // (setReward). Therefore that method need to be
   // called before this one in order to have the relative pose of the quadrotor
   // to the marker
+  std::lock_guard<std::mutex> lock(state_mutex_);
   res.pose.position.x = quadrotor_to_marker_pose_.position.x;
   res.pose.position.y = quadrotor_to_marker_pose_.position.y;
   res.pose.position.z = quadrotor_to_marker_pose_.position.z;
 
   return true;
 }
+
+bool DeepReinforcedLandingUAV::step(
+    deep_reinforced_landing::Step::Request &req,
+    deep_reinforced_landing::Step::Response &res) {
+  if (req.repeat > 1) {
+    // Only drl_services_node repeats the actions
+    ROS_WARN_ONCE("Action repeat is not supported on the real UAV, the "
+                  "commands are applied once");
+  }
+  std::unique_lock<std::mutex> lock(state_mutex_);
+  step_action_ = actions_.find(req.command);
+  step_received_ = ros::WallTime::now();
+  has_step_command_ = true;
+  unsigned long id = ++step_requested_id_;
+  tracer_.instant("command_received", id);
+
+  // The command is applied by the main loop, the answer is ready at the first
+  // reward evaluation after that
+  while (!(step_applied_id_ == id && tick_ > step_applied_tick_)) {
+    tick_cond_.wait_for(lock, std::chrono::milliseconds(100));
+    if (!ros::ok()) {
+      return false;
+    }
+  }
+
+  res.reward = reward_;
+  res.done = done_;
+  res.wrong_altitude = wrong_altitude_;
+  res.pose.position.x = quadrotor_to_marker_pose_.position.x;
+  res.pose.position.y = quadrotor_to_marker_pose_.position.y;
+  res.pose.position.z = quadrotor_to_marker_pose_.position.z;
+  res.repeats = 1;
+  res.height = out_.rows;
+  res.width = out_.cols;
+  if (out_.isContinuous()) {
+    res.image.assign(out_.data, out_.data + out_.total());
+  }
+  tracer_.instant("response_sent", id);
+  return true;
+}
 //----------------------------------
 
 //-------CALLBACKS------------------
@@ -431,69 +703,65 @@ void DeepReinforcedLandingUAV::setDoneCallback(
   }
 }
 
-void DeepReinforcedLandingUAV::getImageCallback(const sensor_msgs::Image &msg) {
+void DeepReinforcedLandingUAV::getImageCallback(
+    const sensor_msgs::ImageConstPtr &msg) {
+  const int64_t start = TraceRecorder::now();
+  if (msg->width == 0 || msg->height == 0 ||
+      msg->data.size() < (size_t)msg->step * msg->height) {
+    ROS_ERROR_THROTTLE(1.0, "Camera frame of %ux%u with %zu bytes ignored",
+                       msg->width, msg->height, msg->data.size());
+    return;
+  }
+  std::lock_guard<std::mutex> lock(state_mutex_);
 
-  // Get color image
+  // Keep a reference to the color image, no copy is made
   image_total_ = msg;
 
-  // Get greyscale
-  src_ = cv_bridge::toCvCopy(msg, sensor_msgs::image_encodings::MONO8)->image;
-  // Scale image to 84px x 150px
-  cv::resize(src_, out_, cv::Size(), 0.233333333, 0.233333333);
-  // cout << out_.cols << " " << out_.rows << " " << out_.size << endl;
-  // Setup a rectangle to define a region of interest
-  cv::Rect myROI(33, 0, 84, 84);
-  // Crop the full image to that image contained by the rectangle myROI
-  cv::Mat croppedRef(out_, myROI);
-
-  // Copy the data in the original output image
-  croppedRef.copyTo(out_);
-
-  greyscale_camera_pub_.publish(
-      (cv_bridge::CvImage(msg.header, "mono8", out_).toImageMsg()));
+  // Crop, scale (0.2333 and 84x84 region at x=33) and convert to greyscale in
+  // a single pass
+  if (!preprocessor_.process(&msg->data[0], msg->width, msg->height, msg->step,
+                             msg->encoding, out_.data)) {
+    // Unusual encodings are converted by cv_bridge first
+    cv_bridge::CvImageConstPtr mono =
+        cv_bridge::toCvShare(msg, sensor_msgs::image_encodings::MONO8);
+    preprocessor_.process(mono->image.data, mono->image.cols, mono->image.rows,
+                          mono->image.step, "mono8", out_.data);
+  }
+
+  if (greyscale_camera_pub_.getNumSubscribers() > 0) {
+    greyscale_camera_pub_.publish(
+        (cv_bridge::CvImage(msg->header, "mono8", out_).toImageMsg()));
+  }
+  tracer_.span("image_callback", start, TraceRecorder::now(), msg->header.seq);
 }
 
 //---------------------------------
 
-bool DeepReinforcedLandingUAV::getReset() { return reset_; }
+bool DeepReinforcedLandingUAV::getReset() {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  return reset_;
+}
 
-void DeepReinforcedLandingUAV::setReset(bool reset) { reset_ = reset; }
+void DeepReinforcedLandingUAV::setReset(bool reset) {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  reset_ = reset;
+}
 
 gazebo_msgs::SetModelState DeepReinforcedLandingUAV::getModelState() {
   gazebo_msgs::SetModelState set_model_state = set_model_state_;
-  float tmp_x, tmp_y, tmp_z;
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::normal_distribution<> gaussian_xy(0, 0.75);
-
-  tmp_x = markerPose_.position.x - bb_flight_half_size_ +
-          (2 * bb_flight_half_size_ * rand()) /
-              (RAND_MAX + 1.0); // spawn also inside the landing BB
-  set_model_state.request.model_state.pose.position.x = tmp_x;
-
-  tmp_y = markerPose_.position.y - bb_flight_half_size_ +
-          (2 * bb_flight_half_size_ * rand()) /
-              (RAND_MAX + 1.0); // spawn also inside the landing BB
-  set_model_state.request.model_state.pose.position.y = tmp_y;
-
-  std::random_device rand_dev;
-  std::mt19937 generator(rand_dev());
-  std::uniform_int_distribution<int> uniform_int(
-      markerPose_.position.z + bb_landing_height_ + 1,
-      markerPose_.position.z + 15.0 - bb_landing_height_);
-
-  tmp_z = uniform_int(generator) / 1.0;
-  set_model_state.request.model_state.pose.position.z = tmp_z;
-  // std::cout << "[INFO]Altitute at the reset: " << tmp_z << std::endl;
-
-  tfScalar roll, pitch, yaw;
-  yaw = (rand() % 360); // - 180; // rand() supports only integer
-  // cout << yaw << endl;
-  tf::Matrix3x3 m;
-  m.setEulerYPR(yaw, pitch, roll);
-  tf::Quaternion orientation;
-  m.getRotation(orientation);
+  Spawn spawn;
+  geometry_msgs::Point marker;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    spawn = spawn_sampler_.next();
+    marker = markerPose_.position;
+  }
+  // Around the marker, roll and pitch are zero
+  set_model_state.request.model_state.pose.position.x = marker.x + spawn.x;
+  set_model_state.request.model_state.pose.position.y = marker.y + spawn.y;
+  set_model_state.request.model_state.pose.position.z = marker.z + spawn.z;
 
+  tf::Quaternion orientation = tf::createQuaternionFromYaw(spawn.yaw);
   set_model_state.request.model_state.pose.orientation.x = orientation.getX();
   set_model_state.request.model_state.pose.orientation.y = orientation.getY();
   set_model_state.request.model_state.pose.orientation.z = orientation.getZ();
@@ -505,6 +773,9 @@ gazebo_msgs::SetModelState DeepReinforcedLandingUAV::getModelState() {
 void DeepReinforcedLandingUAV::setModelState(
     gazebo_msgs::SetModelState set_model_state) {
   set_state_client_.call(set_model_state);
+  // A new episode begins, its first observation is the first frame repeated
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  frame_stack_.clear();
 }
 
 bool DeepReinforcedLandingUAV::getCanMove() { return can_move_; }
@@ -536,31 +807,34 @@ int DeepReinforcedLandingUAV::getReward() { return reward_; }
 void DeepReinforcedLandingUAV::setReward(double reward) { reward_ = reward; }
 
 void DeepReinforcedLandingUAV::setReward() {
-
+  const int64_t fetch_start = TraceRecorder::now();
+  // The poses are fetched without the lock, the services read them with it
   srv_.request.model_name = "quadrotor";
-  if (get_state_client_.call(srv_)) { // NB: quadrotor's altitude can be used to
-                                      // understand if it still flying or landed
-    quadrotorPose_.position.x = srv_.response.pose.position.x;
-    quadrotorPose_.position.y = srv_.response.pose.position.y;
-    quadrotorPose_.position.z = srv_.response.pose.position.z;
-  } else {
+  const bool quadrotor_fetched =
+      get_state_client_.call(srv_); // NB: quadrotor's altitude can be used to
+                                    // understand if it still flying or landed
+  const geometry_msgs::Point quadrotor_position = srv_.response.pose.position;
+  if (!quadrotor_fetched) {
     ROS_ERROR("Service has not been called");
   }
 
   srv_.request.model_name = "marker2";
-  if (get_state_client_.call(srv_)) {
-    markerPose_.position.x = srv_.response.pose.position.x;
-    markerPose_.position.y = srv_.response.pose.position.y;
-    markerPose_.position.z = srv_.response.pose.position.z;
-    // Create a bounding box for autonomous landing given the marker's position
-    // and a number
-    bb_landing_.setDimension(markerPose_, bb_landing_half_size_,
-                             bb_landing_height_);
-    bb_flight_.setDimension(markerPose_, bb_flight_half_size_,
-                            bb_flight_height_);
-  } else {
+  const bool marker_fetched = get_state_client_.call(srv_);
+  if (!marker_fetched) {
     ROS_ERROR("Service has not been called");
   }
+  const int64_t reward_start = TraceRecorder::now();
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  tracer_.span("state_fetch", fetch_start, reward_start, tick_ + 1);
+  if (quadrotor_fetched) {
+    quadrotorPose_.position = quadrotor_position;
+  }
+  if (marker_fetched) {
+    markerPose_.position = srv_.response.pose.position;
+    // Place the landing and flight boxes around the marker
+    reward_engine_.setMarker(markerPose_.position.x, markerPose_.position.y,
+                             markerPose_.position.z);
+  }
 
   // Calculate the quadrotor pose wrt the marker's one
   quadrotor_to_marker_pose_.position.x =
@@ -570,19 +844,87 @@ void DeepReinforcedLandingUAV::setReward() {
   quadrotor_to_marker_pose_.position.z =
       quadrotorPose_.position.z - markerPose_.position.z;
 
-  // setReward(utilities_.assignReward(quadrotorPose_, bb_landing_, bb_flight_,
-  // &done_));
+  // landing_altitude for simulation_1/6, land_action for simulation_2
+  RewardOutcome outcome;
+  reward_engine_.evaluate(quadrotorPose_.position.x, quadrotorPose_.position.y,
+                          quadrotorPose_.position.z, action_, &outcome);
+  setReward(outcome.reward);
+  done_ = outcome.done;
+  wrong_altitude_ = outcome.wrong_altitude;
+
+  // Wake up the step requests waiting for this evaluation
+  tick_++;
+  tick_cond_.notify_all();
+  tracer_.span("reward", reward_start, TraceRecorder::now(), tick_);
+}
 
-  setReward(utilities_.assignRewardWithoutFlightBB(
-      quadrotorPose_, bb_landing_, bb_flight_, &done_, action_,
-      &wrong_altitude_)); // for simulation_1/6
-  // setReward(utilities_.assignRewardWhenLanding(quadrotorPose_, bb_landing_,
-  // bb_flight_, &done_, action_)); // for simulation_2
+void DeepReinforcedLandingUAV::applyAction(int id) {
+  const ActionEntry *entry = actions_.get(id);
+  action_ = entry != NULL ? entry->action : ACTION_UNKNOWN;
+  // The current frame is the observation on which the action has been chosen
+  frame_stack_.push(out_.data);
+  // Every command sets all the axes, "left" after "forward" does not move
+  // diagonally
+  velocity_cmd_ = geometry_msgs::Twist();
+
+  if (entry == NULL) {
+    // Unknown commands stop the UAV
+    can_move_ = true;
+  } else if (entry->kind == ACTION_KIND_TAKEOFF) {
+    can_takeoff_ = true;
+  } else if (entry->kind == ACTION_KIND_LAND) {
+    can_land_ = true;
+  } else {
+    velocity_cmd_.linear.x = entry->velocity[0];
+    velocity_cmd_.linear.y = entry->velocity[1];
+    velocity_cmd_.linear.z = entry->velocity[2];
+    velocity_cmd_.angular.z = entry->velocity[3];
+    can_move_ = true;
+  }
+}
+
+void DeepReinforcedLandingUAV::applyStepCommand() {
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  if (has_step_command_) {
+    command_received_ = step_received_;
+    applyAction(step_action_);
+    has_step_command_ = false;
+    step_applied_id_ = step_requested_id_;
+    step_applied_tick_ = tick_;
+  }
 }
 
-void DeepReinforcedLandingUAV::setActionCommand(std::string action) {
-  action_ = action;
-  // cout << "Message received: " << action_ << endl;
+void DeepReinforcedLandingUAV::publishCommand() {
+  bool takeoff, land, move;
+  geometry_msgs::Twist velocity_cmd;
+  ros::WallTime received;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    takeoff = can_takeoff_;
+    land = !can_takeoff_ && can_land_;
+    move = !can_takeoff_ && !can_land_ && can_move_;
+    velocity_cmd = velocity_cmd_;
+    received = command_received_;
+    if (can_takeoff_) {
+      can_takeoff_ = false;
+    } else if (can_land_) {
+      can_land_ = false;
+    } else {
+      can_move_ = false;
+    }
+  }
+
+  const int64_t start = TraceRecorder::now();
+  if (takeoff) {
+    dispatcher_.takeoff(received);
+  } else if (land) {
+    dispatcher_.land(received);
+  } else if (move) {
+    dispatcher_.move(velocity_cmd, received);
+  }
+  if (takeoff || land || move) {
+    tracer_.span("command_published", start, TraceRecorder::now());
+  }
 }
 
 int main(int argc, char **argv) {
@@ -590,8 +932,6 @@ int main(int argc, char **argv) {
   DeepReinforcedLandingUAV drl_node;
   gazebo_msgs::SetModelState tmp_model_state;
   ros::Rate rate(30);
-  std_msgs::Empty land_takeoff_cmd;
-  double reward;
 
   while (ros::ok()) {
 
@@ -607,18 +947,12 @@ int main(int argc, char **argv) {
     // following iteration
     drl_node.setReset(false);
 
-    // Send command if requested---------------
-    if (drl_node.getCanTakeOff()) {
-      drl_node.getTakeoffPub().publish(land_takeoff_cmd);
-      drl_node.setCanTakeOff(false);
-    } else if (drl_node.getCanLand()) {
-      drl_node.getLandPub().publish(land_takeoff_cmd);
-      drl_node.setCanLand(false);
-    } else if (drl_node.getCanMove()) {
-      drl_node.getCmdPub().publish(drl_node.getVelocityCmd());
-      drl_node.setCanMove(false);
-    }
-    //-----------------------------------------
+    // Apply the command of a pending step request, its outcome is evaluated at
+    // the next iteration
+    drl_node.applyStepCommand();
+
+    // Send the command of a step request
+    drl_node.publishCommand();
 
     ros::spinOnce();
     rate.sleep();
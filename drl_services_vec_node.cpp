@@ -0,0 +1,733 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Main class for the vectorised deep reinforced landing node: N quadrotor/marker pairs living in the same world
+  are driven by a single batched step service.
+*/
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "../include/actions.h"
+#include "../include/actionTable.h"
+#include "../include/rewardEngine.h"
+#include "../include/spawnSampler.h"
+#include "../include/gazeboStepper.h"
+#include "../include/modelStateCache.h"
+#include "../include/framePreprocessor.h"
+#include "gazebo_msgs/ModelState.h"
+#include "gazebo_msgs/SetModelState.h"
+#include "geometry_msgs/Pose.h"
+#include "geometry_msgs/Twist.h"
+#include "ros/node_handle.h"
+#include "ros/ros.h"
+#include "sensor_msgs/Image.h"
+#include "std_msgs/Empty.h"
+#include <tf/LinearMath/Matrix3x3.h>
+#include <tf/transform_datatypes.h>
+#include <cv_bridge/cv_bridge.h>
+#include <ros/callback_queue.h>
+#include <ros/spinner.h>
+
+#include "deep_reinforced_landing/BatchStep.h"
+#include "deep_reinforced_landing/BatchReset.h"
+
+using namespace std;
+using namespace cv;
+
+// State of a single quadrotor/marker pair
+struct LandingEnvironment
+{
+  std::string quadrotor_name;
+  std::string marker_name;
+
+  ros::Publisher cmd_pub;
+  ros::Publisher land_pub;
+  ros::Publisher takeoff_pub;
+  ros::Subscriber camera_sub;
+
+  geometry_msgs::Pose quadrotor_pose, marker_pose, quadrotor_to_marker_pose;
+  // Reward and done given the boxes around the marker of the pair
+  RewardEngine reward_engine;
+  geometry_msgs::Point bb_origin;
+  bool bb_valid;
+  // Respawn poses wrt the marker, one stream of /drl_node/seed per pair
+  SpawnSampler spawn_sampler;
+
+  // Flight control
+  geometry_msgs::Twist velocity_cmd;
+  bool can_takeoff, can_land, can_move;
+  ActionId action;
+
+  // Reinforcement Learning data
+  bool done;
+  float reward;
+  // The episode ended at the previous step, the next step resets the pair instead of applying the command
+  bool needs_reset;
+  bool was_reset;
+
+  // Latest greyscale 84x84 frame
+  cv::Mat frame;
+  ros::Time frame_stamp;
+  // Fused crop/scale/greyscale kernel and its output before being published in frame
+  FramePreprocessor preprocessor;
+  cv::Mat frame_buffer;
+};
+
+// Node class for the vectorised deep reinforced landing
+class DeepReinforcedLandingVec
+{
+private:
+
+  ros::NodeHandle nh_;
+  // Create a service that steps all the sub-environments, served from its own queue
+  // so that it can wait for the main loop
+  ros::NodeHandle nh_step_;
+  ros::CallbackQueue step_queue_;
+  std::unique_ptr<ros::AsyncSpinner> step_spinner_;
+  ros::ServiceServer service_step_;
+  ros::ServiceServer service_reset_;
+  // The cameras are served by their own threads, every sub-environment processes its frames on its own buffer
+  ros::NodeHandle nh_image_;
+  ros::CallbackQueue image_queue_;
+  std::unique_ptr<ros::AsyncSpinner> image_spinner_;
+  // Gazebo service for moving the quadrotors
+  ros::ServiceClient set_state_client_;
+
+  ModelStateCache state_cache_;
+  GazeboStepper stepper_;
+
+  std::vector<LandingEnvironment> envs_;
+
+  //--------Callbacks and Services-----
+/*
+  Get the latest frame of a sub-environment's camera
+
+  @param msg is the latest frame acquired by the camera
+  @param env is the index of the sub-environment
+*/
+  void getImageCallback(const sensor_msgs::ImageConstPtr &msg, size_t env);
+
+/*
+  Apply one command per sub-environment and return rewards, dones and frames of all of them
+
+  @param req contains num_envs commands (same strings accepted by drl/send_command)
+  @param res contains num_envs rewards, dones, resets and a num_envs x 84 x 84 frame tensor
+*/
+  bool batchStep(deep_reinforced_landing::BatchStep::Request &req,
+                 deep_reinforced_landing::BatchStep::Response &res);
+
+/*
+  Reset some or all the sub-environments at the next iteration
+
+  @param req contains the indices of the sub-environments, empty for all of them
+  @param res is an empty message
+*/
+  bool batchReset(deep_reinforced_landing::BatchReset::Request &req,
+                  deep_reinforced_landing::BatchReset::Response &res);
+
+/*
+  @param id is the index of the action in the table, any other value stops the UAV
+*/
+  void applyAction(LandingEnvironment &env, int id);
+/*
+  Start a new episode of a sub-environment, the UAV is moved by the caller
+
+  @param model_state is the respawn state of the UAV, drawn around the marker of the pair
+  @return false if the pose of the marker is not known yet, the pair is then stopped, answered as reset and reset
+  again at the next step
+*/
+  bool resetEnvironment(LandingEnvironment &env, gazebo_msgs::ModelState *model_state);
+  void setReward(LandingEnvironment &env);
+
+  //-------Data-----------
+  // Half side for the landing BB and the flight one
+  double bb_landing_half_size_, bb_flight_half_size_;
+  double bb_landing_height_, bb_flight_height_;
+  // Velocities of the commands, shared by all the sub-environments (/drl_node/action_*)
+  ActionTable actions_;
+
+  // Synchronisation between the step service and the main loop
+  std::mutex state_mutex_;
+  std::condition_variable tick_cond_;
+  // Signalled by the image callbacks at every new frame
+  std::condition_variable frame_cond_;
+  unsigned long tick_;
+  // Indices in the action table of the commands of the pending step request
+  std::vector<int> step_actions_;
+  bool has_step_commands_;
+  unsigned long step_requested_id_, step_applied_id_, step_applied_tick_;
+
+  // Lockstep simulation (see drl_services_node)
+  bool lockstep_;
+  int lockstep_iterations_;
+  double lockstep_timeout_;
+  double lockstep_publish_delay_;
+  bool lockstep_pending_;
+
+public:
+  DeepReinforcedLandingVec();
+  ~DeepReinforcedLandingVec();
+
+  bool getLockstep();
+/*
+  Evaluate reward and done of every sub-environment and wake up the pending step request
+*/
+  void setRewards();
+/*
+  Reset the finished sub-environments and apply the commands of a pending step request, if any
+*/
+  void applyStepCommands();
+/*
+  Publish the commands of every sub-environment
+*/
+  void publishCommands();
+/*
+  In lockstep mode, advance the physics after a step request has been applied and evaluate the rewards
+*/
+  void advanceLockstep();
+};
+
+DeepReinforcedLandingVec::DeepReinforcedLandingVec()
+{
+  int num_envs, image_threads;
+  std::string quadrotor_prefix, marker_prefix;
+  nh_.param ("/drl_node/num_envs", num_envs, 1 );
+  nh_.param ("/drl_node/image_threads", image_threads, 0 );
+  nh_.param ("/drl_node/quadrotor_prefix", quadrotor_prefix, std::string("quadrotor_") );
+  nh_.param ("/drl_node/marker_prefix", marker_prefix, std::string("marker_") );
+
+  // Load parameters from param server
+  nh_.getParam ("/drl_node/bb_flight_half_size", bb_flight_half_size_ );
+  nh_.getParam ("/drl_node/bb_flight_height", bb_flight_height_ );
+  nh_.getParam ("/drl_node/bb_landing_half_size", bb_landing_half_size_ );
+  nh_.getParam ("/drl_node/bb_landing_height", bb_landing_height_ );
+  SpawnConfig spawn_config;
+  std::string xy_gaussian_uniform;
+  int spawn_seed, spawn_batch;
+  nh_.getParam ("/drl_node/xy_gaussian_uniform", xy_gaussian_uniform );
+  nh_.getParam ("/drl_node/xy_gaussian_mean", spawn_config.xy_mean );
+  nh_.getParam ("/drl_node/xy_gaussian_stdev", spawn_config.xy_stdev );
+  nh_.getParam ("/drl_node/num_z_uniform", spawn_config.z_bands );
+  nh_.getParam ("/drl_node/z_uniform_from", spawn_config.z_from );
+  nh_.getParam ("/drl_node/z_uniform_to", spawn_config.z_to );
+  nh_.getParam ("/drl_node/z_uniform_from_2", spawn_config.z_from_2 );
+  nh_.getParam ("/drl_node/z_uniform_to_2", spawn_config.z_to_2 );
+  if (nh_.getParam ("/drl_node/seed", spawn_seed ) == false)
+  {
+    spawn_seed = std::random_device()() & 0x7fffffff;
+  }
+  nh_.param ("/drl_node/spawn_batch", spawn_batch, 0 );
+  nh_.param ("/drl_node/lockstep", lockstep_, false );
+  nh_.param ("/drl_node/lockstep_iterations", lockstep_iterations_, 33 );
+  nh_.param ("/drl_node/lockstep_timeout", lockstep_timeout_, 0.5 );
+  nh_.param ("/drl_node/lockstep_publish_delay", lockstep_publish_delay_, 0.002 );
+  RewardConfig reward_config;
+  std::string reward_policy;
+  double step_reward, success_reward, failure_reward;
+  nh_.param ("/drl_node/reward_policy", reward_policy, std::string(rewardPolicyName(reward_config.policy)) );
+  nh_.param ("/drl_node/reward_step", step_reward, (double)reward_config.step_reward );
+  nh_.param ("/drl_node/reward_success", success_reward, (double)reward_config.success_reward );
+  nh_.param ("/drl_node/reward_failure", failure_reward, (double)reward_config.failure_reward );
+  nh_.param ("/drl_node/reward_min_altitude", reward_config.min_altitude, reward_config.min_altitude );
+  if (parseRewardPolicy(reward_policy, &reward_config.policy) == false)
+  {
+    ROS_ERROR("Unknown reward policy %s, %s is used", reward_policy.c_str(), rewardPolicyName(reward_config.policy));
+  }
+  reward_config.landing_half_size = bb_landing_half_size_;
+  reward_config.landing_height = bb_landing_height_;
+  reward_config.flight_half_size = bb_flight_half_size_;
+  reward_config.flight_height = bb_flight_height_;
+  reward_config.step_reward = step_reward;
+  reward_config.success_reward = success_reward;
+  reward_config.failure_reward = failure_reward;
+
+  // Same table as drl_services_node
+  actions_ = ActionTable::defaults(0.5, 0.5, false);
+  std::vector<std::string> action_names;
+  std::vector<double> action_directions, action_magnitudes;
+  nh_.param ("/drl_node/action_names", action_names, std::vector<std::string>() );
+  nh_.param ("/drl_node/action_directions", action_directions, std::vector<double>() );
+  nh_.param ("/drl_node/action_magnitudes", action_magnitudes, std::vector<double>() );
+  std::string action_error;
+  if (action_names.empty() == false && actions_.load(action_names, action_directions, action_magnitudes,
+                                                     &action_error) == false)
+  {
+    ROS_ERROR("Invalid action table (%s), the default one is used", action_error.c_str());
+  }
+
+  spawn_config.xy_gaussian = xy_gaussian_uniform == "gaussian";
+  spawn_config.xy_half_size = bb_landing_half_size_;
+  std::string spawn_error;
+  if (xy_gaussian_uniform != "gaussian" && xy_gaussian_uniform != "uniform")
+  {
+    ROS_ERROR("A wrong distribution has been chosen (typo?). [uniform or gaussian]");
+    ros::shutdown();
+  }
+  else if (spawn_config.validate(&spawn_error) == false)
+  {
+    ROS_ERROR("Invalid respawn distribution (%s), check /drl_node/xy_gaussian_* and /drl_node/*z_uniform*",
+              spawn_error.c_str());
+    ros::shutdown();
+  }
+  ROS_INFO("Respawn seed %d (/drl_node/seed)", spawn_seed);
+
+  // Every pair lives in the namespace of its quadrotor, e.g. /quadrotor_3/cmd_vel
+  envs_.resize(num_envs);
+  nh_image_.setCallbackQueue(&image_queue_);
+  for (size_t i = 0; i < envs_.size(); i++)
+  {
+    LandingEnvironment &env = envs_[i];
+    env.quadrotor_name = quadrotor_prefix + std::to_string(i);
+    env.marker_name = marker_prefix + std::to_string(i);
+    env.cmd_pub = nh_.advertise<geometry_msgs::Twist>("/" + env.quadrotor_name + "/cmd_vel", 1);
+    env.land_pub = nh_.advertise<std_msgs::Empty>("/" + env.quadrotor_name + "/ardrone/land", 1);
+    env.takeoff_pub = nh_.advertise<std_msgs::Empty>("/" + env.quadrotor_name + "/ardrone/takeoff", 1);
+    env.camera_sub = nh_image_.subscribe<sensor_msgs::Image>(
+        "/" + env.quadrotor_name + "/ardrone/bottom/ardrone/bottom/image_raw", 1,
+        boost::bind(&DeepReinforcedLandingVec::getImageCallback, this, _1, i));
+    env.reward_engine = RewardEngine(reward_config);
+    env.spawn_sampler = SpawnSampler(spawn_config, spawn_seed, i, std::max(spawn_batch, 0));
+    env.bb_valid = false;
+    env.action = ACTION_UNKNOWN;
+    env.can_takeoff = env.can_land = env.can_move = false;
+    env.done = false;
+    env.reward = 0;
+    env.needs_reset = true;
+    env.was_reset = false;
+    env.frame = cv::Mat::zeros(84, 84, CV_8UC1);
+    env.frame_buffer = cv::Mat::zeros(84, 84, CV_8UC1);
+  }
+
+  set_state_client_ = nh_.serviceClient<gazebo_msgs::SetModelState>("/gazebo/set_model_state", true);
+  state_cache_.init(nh_);
+
+  tick_ = 0;
+  has_step_commands_ = false;
+  step_requested_id_ = step_applied_id_ = step_applied_tick_ = 0;
+  lockstep_pending_ = false;
+
+  if (lockstep_ == true && stepper_.init(nh_) == false)
+  {
+    ROS_ERROR("Lockstep mode requested but the world cannot be stepped");
+    ros::shutdown();
+  }
+
+  nh_step_.setCallbackQueue(&step_queue_);
+  service_step_ = nh_step_.advertiseService("drl/batch_step", &DeepReinforcedLandingVec::batchStep, this);
+  service_reset_ = nh_step_.advertiseService("drl/batch_reset", &DeepReinforcedLandingVec::batchReset, this);
+  step_spinner_.reset(new ros::AsyncSpinner(1, &step_queue_));
+  step_spinner_->start();
+  // A subscription is never served by two threads at once, more threads than cameras would be idle
+  if (image_threads <= 0)
+  {
+    image_threads = std::min<int>(num_envs, std::max<int>(std::thread::hardware_concurrency(), 1));
+  }
+  image_spinner_.reset(new ros::AsyncSpinner(std::min(image_threads, num_envs), &image_queue_));
+  image_spinner_->start();
+
+  ROS_INFO("Vectorised node managing %d quadrotor/marker pairs", num_envs);
+}
+
+DeepReinforcedLandingVec::~DeepReinforcedLandingVec()
+{
+  step_spinner_->stop();
+  image_spinner_->stop();
+}
+
+//----------------SERVICES-----------
+bool DeepReinforcedLandingVec::batchStep(deep_reinforced_landing::BatchStep::Request &req,
+                                         deep_reinforced_landing::BatchStep::Response &res)
+{
+  if (req.commands.size() != envs_.size())
+  {
+    ROS_ERROR("Batch step requires %zu commands, %zu received", envs_.size(), req.commands.size());
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(state_mutex_);
+  step_actions_.resize(req.commands.size());
+  for (size_t i = 0; i < req.commands.size(); i++)
+  {
+    step_actions_[i] = actions_.find(req.commands[i]);
+  }
+  has_step_commands_ = true;
+  unsigned long id = ++step_requested_id_;
+
+  // The commands are applied by the main loop, the answer is ready at the first reward evaluation after that
+  while (!(step_applied_id_ == id && tick_ > step_applied_tick_))
+  {
+    tick_cond_.wait_for(lock, std::chrono::milliseconds(100));
+    if (!ros::ok())
+    {
+      return false;
+    }
+  }
+
+  const size_t frame_size = 84 * 84;
+  res.num_envs = envs_.size();
+  res.height = 84;
+  res.width = 84;
+  res.rewards.resize(envs_.size());
+  res.dones.resize(envs_.size());
+  res.resets.resize(envs_.size());
+  res.images.resize(envs_.size() * frame_size);
+  for (size_t i = 0; i < envs_.size(); i++)
+  {
+    res.rewards[i] = envs_[i].reward;
+    res.dones[i] = envs_[i].done;
+    res.resets[i] = envs_[i].was_reset;
+    std::copy(envs_[i].frame.data, envs_[i].frame.data + frame_size, res.images.begin() + i * frame_size);
+  }
+  return true;
+}
+
+bool DeepReinforcedLandingVec::batchReset(deep_reinforced_landing::BatchReset::Request &req,
+                                          deep_reinforced_landing::BatchReset::Response &res)
+{
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  if (req.envs.empty())
+  {
+    for (size_t i = 0; i < envs_.size(); i++)
+    {
+      envs_[i].needs_reset = true;
+    }
+  }
+  for (size_t i = 0; i < req.envs.size(); i++)
+  {
+    if (req.envs[i] < envs_.size())
+    {
+      envs_[req.envs[i]].needs_reset = true;
+    }
+  }
+  return true;
+}
+//----------------------------------
+
+//-------CALLBACKS------------------
+void DeepReinforcedLandingVec::getImageCallback(const sensor_msgs::ImageConstPtr &msg, size_t env)
+{
+  LandingEnvironment &environment = envs_[env];
+  if (msg->width == 0 || msg->height == 0 || msg->data.size() < (size_t)msg->step * msg->height)
+  {
+    ROS_ERROR_THROTTLE(1.0, "Camera frame of %ux%u with %zu bytes ignored", msg->width, msg->height, msg->data.size());
+    return;
+  }
+
+  // Crop, scale (0.2333 and 84x84 region at x=33) and convert to greyscale in a single pass
+  if (!environment.preprocessor.process(&msg->data[0], msg->width, msg->height, msg->step, msg->encoding,
+                                        environment.frame_buffer.data))
+  {
+    cv_bridge::CvImageConstPtr mono = cv_bridge::toCvShare(msg, sensor_msgs::image_encodings::MONO8);
+    environment.preprocessor.process(mono->image.data, mono->image.cols, mono->image.rows, mono->image.step, "mono8",
+                                     environment.frame_buffer.data);
+  }
+
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  environment.frame_buffer.copyTo(environment.frame);
+  environment.frame_stamp = msg->header.stamp;
+  frame_cond_.notify_all();
+}
+//---------------------------------
+
+void DeepReinforcedLandingVec::applyAction(LandingEnvironment &env, int id)
+{
+  const ActionEntry *entry = actions_.get(id);
+  env.action = entry != NULL ? entry->action : ACTION_UNKNOWN;
+  // Every command sets all the axes, "left" after "forward" does not move diagonally
+  env.velocity_cmd = geometry_msgs::Twist();
+
+  if (entry == NULL)
+  {
+    // Unknown commands stop the UAV
+    env.can_move = true;
+  }
+  else if (entry->kind == ACTION_KIND_TAKEOFF)
+  {
+    env.can_takeoff = true;
+  }
+  else if (entry->kind == ACTION_KIND_LAND)
+  {
+    env.can_land = true;
+  }
+  else
+  {
+    env.velocity_cmd.linear.x = entry->velocity[0];
+    env.velocity_cmd.linear.y = entry->velocity[1];
+    env.velocity_cmd.linear.z = entry->velocity[2];
+    env.velocity_cmd.angular.z = entry->velocity[3];
+    env.can_move = true;
+  }
+}
+
+bool DeepReinforcedLandingVec::resetEnvironment(LandingEnvironment &env, gazebo_msgs::ModelState *model_state)
+{
+  // The marker is read from the cache rather than from the last reward evaluation, which may not have run yet
+  geometry_msgs::Pose marker;
+  if (state_cache_.getPose(env.marker_name, marker) == false)
+  {
+    ROS_ERROR_THROTTLE(1.0, "Pose of %s not received yet, %s is reset later", env.marker_name.c_str(),
+                       env.quadrotor_name.c_str());
+    // Answered as a reset, so that the command ignored is not stored as a transition
+    applyAction(env, -1);
+    env.was_reset = true;
+    return false;
+  }
+  env.marker_pose.position = marker.position;
+
+  model_state->model_name = env.quadrotor_name;
+  model_state->reference_frame = "world";
+
+  // Same distributions of the single environment node, centred on the marker of the pair
+  const Spawn spawn = env.spawn_sampler.next();
+  model_state->pose.position.x = marker.position.x + spawn.x;
+  model_state->pose.position.y = marker.position.y + spawn.y;
+  model_state->pose.position.z = spawn.z;
+
+  tf::Quaternion orientation = tf::createQuaternionFromYaw(spawn.yaw);
+  model_state->pose.orientation.x = orientation.getX();
+  model_state->pose.orientation.y = orientation.getY();
+  model_state->pose.orientation.z = orientation.getZ();
+  model_state->pose.orientation.w = orientation.getW();
+
+  // Stop the UAV, the first command of the new episode starts from hovering
+  env.velocity_cmd = geometry_msgs::Twist();
+  env.can_move = true;
+  env.action = ACTION_STOP;
+  env.needs_reset = false;
+  env.was_reset = true;
+  return true;
+}
+
+void DeepReinforcedLandingVec::setReward(LandingEnvironment &env)
+{
+  geometry_msgs::Pose pose;
+
+  if (state_cache_.getPose(env.quadrotor_name, pose))
+  {
+    env.quadrotor_pose.position = pose.position;
+  }
+  else
+  {
+    ROS_ERROR_THROTTLE(1.0, "Pose of %s not received yet", env.quadrotor_name.c_str());
+  }
+
+  if (state_cache_.getPose(env.marker_name, pose))
+  {
+    env.marker_pose.position = pose.position;
+    if (env.bb_valid == false || env.bb_origin.x != pose.position.x || env.bb_origin.y != pose.position.y ||
+        env.bb_origin.z != pose.position.z)
+    {
+      env.reward_engine.setMarker(pose.position.x, pose.position.y, pose.position.z);
+      env.bb_origin = pose.position;
+      env.bb_valid = true;
+    }
+  }
+  else
+  {
+    ROS_ERROR_THROTTLE(1.0, "Pose of %s not received yet", env.marker_name.c_str());
+  }
+
+  env.quadrotor_to_marker_pose.position.x = env.quadrotor_pose.position.x - env.marker_pose.position.x;
+  env.quadrotor_to_marker_pose.position.y = env.quadrotor_pose.position.y - env.marker_pose.position.y;
+  env.quadrotor_to_marker_pose.position.z = env.quadrotor_pose.position.z - env.marker_pose.position.z;
+
+  if (env.was_reset == true)
+  {
+    // First observation of a new episode
+    env.reward = 0;
+    env.done = false;
+    return;
+  }
+  RewardOutcome outcome;
+  env.reward_engine.evaluate(env.quadrotor_pose.position.x, env.quadrotor_pose.position.y,
+                             env.quadrotor_pose.position.z, env.action, &outcome);
+  env.reward = outcome.reward;
+  env.done = outcome.done;
+  // The pair is restarted at the next step
+  env.needs_reset = env.done;
+}
+
+bool DeepReinforcedLandingVec::getLockstep()
+{
+  return lockstep_;
+}
+
+void DeepReinforcedLandingVec::setRewards()
+{
+  if (lockstep_ == true)
+  {
+    for (size_t i = 0; i < envs_.size(); i++)
+    {
+      state_cache_.refresh(envs_[i].quadrotor_name);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  for (size_t i = 0; i < envs_.size(); i++)
+  {
+    setReward(envs_[i]);
+  }
+
+  // Wake up the step request waiting for this evaluation
+  tick_++;
+  tick_cond_.notify_all();
+}
+
+void DeepReinforcedLandingVec::applyStepCommands()
+{
+  if (lockstep_ == true)
+  {
+    // The paused world may not have published the markers yet, they are read once from Gazebo
+    geometry_msgs::Pose marker;
+    for (size_t i = 0; i < envs_.size(); i++)
+    {
+      if (state_cache_.getPose(envs_[i].marker_name, marker) == false)
+      {
+        state_cache_.refresh(envs_[i].marker_name);
+      }
+    }
+  }
+
+  std::vector<gazebo_msgs::ModelState> respawns;
+  gazebo_msgs::ModelState respawn;
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (has_step_commands_ == false)
+    {
+      return;
+    }
+
+    for (size_t i = 0; i < envs_.size(); i++)
+    {
+      envs_[i].was_reset = false;
+      if (envs_[i].needs_reset == true)
+      {
+        if (resetEnvironment(envs_[i], &respawn))
+        {
+          respawns.push_back(respawn);
+        }
+      }
+      else
+      {
+        applyAction(envs_[i], step_actions_[i]);
+      }
+    }
+    has_step_commands_ = false;
+    step_applied_id_ = step_requested_id_;
+    step_applied_tick_ = tick_;
+    lockstep_pending_ = lockstep_;
+  }
+
+  // The UAVs are moved without the lock, so that the cameras and the waiting requests are not held up by Gazebo.
+  // The step is answered at the next reward evaluation, which the main loop runs after this.
+  gazebo_msgs::SetModelState set_model_state;
+  for (size_t i = 0; i < respawns.size(); i++)
+  {
+    set_model_state.request.model_state = respawns[i];
+    if (!set_state_client_.call(set_model_state))
+    {
+      ROS_ERROR("Unable to reset %s", respawns[i].model_name.c_str());
+    }
+  }
+}
+
+void DeepReinforcedLandingVec::publishCommands()
+{
+  std_msgs::Empty land_takeoff_cmd;
+  for (size_t i = 0; i < envs_.size(); i++)
+  {
+    LandingEnvironment &env = envs_[i];
+    if (env.can_takeoff)
+    {
+      env.takeoff_pub.publish(land_takeoff_cmd);
+      env.can_takeoff = false;
+    }
+    else if (env.can_land)
+    {
+      env.can_land = false;
+    }
+    else if (env.can_move)
+    {
+      env.cmd_pub.publish(env.velocity_cmd);
+      env.can_move = false;
+    }
+  }
+}
+
+void DeepReinforcedLandingVec::advanceLockstep()
+{
+  if (lockstep_pending_ == false)
+  {
+    return;
+  }
+  lockstep_pending_ = false;
+
+  // Give the controllers the time to receive the commands before the first iteration runs
+  ros::WallDuration(lockstep_publish_delay_).sleep();
+  ros::Time start = ros::Time::now();
+  stepper_.step(lockstep_iterations_, ros::WallDuration(lockstep_timeout_));
+
+  // Wait for the image threads to process a frame of every camera rendered after the commands
+  {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    frame_cond_.wait_for(lock, std::chrono::duration<double>(lockstep_timeout_), [&] {
+      for (size_t i = 0; i < envs_.size(); i++)
+      {
+        if (!(envs_[i].frame_stamp > start))
+        {
+          return false;
+        }
+      }
+      return true;
+    });
+  }
+
+  setRewards();
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "deep_reinforced_landing_vec_node");
+  DeepReinforcedLandingVec drl_node;
+  ros::Rate rate(30);
+
+  while(ros::ok()){
+
+    // Calculate the rewards at every iteration (in lockstep mode only after the physics has been stepped)
+    if (drl_node.getLockstep() == false)
+    {
+      drl_node.setRewards();
+    }
+
+    // Reset the finished pairs and apply the commands of a pending step request
+    drl_node.applyStepCommands();
+    drl_node.publishCommands();
+
+    if (drl_node.getLockstep() == true)
+    {
+      drl_node.advanceLockstep();
+      ros::getGlobalCallbackQueue()->callAvailable(ros::WallDuration(0.001));
+    }
+    else
+    {
+      ros::spinOnce();
+      rate.sleep();
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,212 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Fused preprocessing of the bottom camera's frames: crop, area downsampling and greyscale conversion in a single pass
+  that reads only the source pixels falling inside the region of interest.
+
+  Greyscale conversion and area averaging are both linear, so the source rows are first averaged channel by channel
+  (the bulk of the work, vectorised with AVX2 or NEON) and the greyscale value is computed on the 84x84 result.
+*/
+
+#include "../include/framePreprocessor.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+// ITU-R BT.601 weights, the same used by OpenCV (and therefore cv_bridge) for MONO8
+const float GREY_MONO[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+const float GREY_RGB[4] = { 0.299f, 0.587f, 0.114f, 0.0f };
+const float GREY_BGR[4] = { 0.114f, 0.587f, 0.299f, 0.0f };
+
+/*
+  acc[i] += weight * src[i] for n bytes
+*/
+void accumulateRow(const uint8_t *src, float weight, float *acc, int n)
+{
+  int i = 0;
+#if defined(__AVX2__)
+  const __m256 w = _mm256_set1_ps(weight);
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+    __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+#if defined(__FMA__)
+    _mm256_storeu_ps(acc + i, _mm256_fmadd_ps(lo, w, _mm256_loadu_ps(acc + i)));
+    _mm256_storeu_ps(acc + i + 8, _mm256_fmadd_ps(hi, w, _mm256_loadu_ps(acc + i + 8)));
+#else
+    _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(lo, w)));
+    _mm256_storeu_ps(acc + i + 8, _mm256_add_ps(_mm256_loadu_ps(acc + i + 8), _mm256_mul_ps(hi, w)));
+#endif
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const float32x4_t w = vdupq_n_f32(weight);
+  for (; i + 8 <= n; i += 8)
+  {
+    uint16x8_t half = vmovl_u8(vld1_u8(src + i));
+    float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(half)));
+    float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(half)));
+    vst1q_f32(acc + i, vmlaq_f32(vld1q_f32(acc + i), lo, w));
+    vst1q_f32(acc + i + 4, vmlaq_f32(vld1q_f32(acc + i + 4), hi, w));
+  }
+#endif
+  for (; i < n; i++)
+  {
+    acc[i] += weight * src[i];
+  }
+}
+}
+
+FramePreprocessor::FramePreprocessor(int out_size, double scale, int roi_x, int roi_y)
+{
+  out_size_ = out_size;
+  scale_ = scale;
+  roi_x_ = roi_x;
+  roi_y_ = roi_y;
+  width_ = height_ = 0;
+  x_begin_ = x_end_ = 0;
+}
+
+FramePreprocessor::~FramePreprocessor()
+{
+}
+
+int FramePreprocessor::getOutSize()
+{
+  return out_size_;
+}
+
+void FramePreprocessor::computeTaps(int offset, int count, double inv_scale, int size, std::vector<AreaTaps> &taps,
+                                    std::vector<float> &weights)
+{
+  taps.resize(count);
+  weights.clear();
+  for (int o = 0; o < count; o++)
+  {
+    // Interval of the source covered by the output pixel, clamped to the image
+    double from = std::min((offset + o) * inv_scale, size - 1.0);
+    double to = std::max(std::min((offset + o + 1) * inv_scale, (double)size), from + 1e-6);
+    int first = (int)std::floor(from);
+    int last = std::min((int)std::ceil(to), size);
+
+    taps[o].first = first;
+    taps[o].offset = weights.size();
+    for (int p = first; p < last; p++)
+    {
+      weights.push_back((std::min(p + 1.0, to) - std::max((double)p, from)) / (to - from));
+    }
+    taps[o].count = last - first;
+  }
+}
+
+void FramePreprocessor::configure(int width, int height)
+{
+  double inv_scale = 1.0 / scale_;
+  computeTaps(roi_x_, out_size_, inv_scale, width, x_taps_, x_weights_);
+  computeTaps(roi_y_, out_size_, inv_scale, height, y_taps_, y_weights_);
+  x_begin_ = x_taps_.front().first;
+  x_end_ = x_taps_.back().first + x_taps_.back().count;
+  width_ = width;
+  height_ = height;
+}
+
+template <int CHANNELS>
+void FramePreprocessor::reduceColumns(const float *coefficients, uint8_t *out_row)
+{
+  for (int c = 0; c < out_size_; c++)
+  {
+    const AreaTaps &taps = x_taps_[c];
+    const float *acc = &row_acc_[(taps.first - x_begin_) * CHANNELS];
+    const float *weights = &x_weights_[taps.offset];
+    float sum[CHANNELS] = {};
+    for (int j = 0; j < taps.count; j++)
+    {
+      for (int ch = 0; ch < CHANNELS; ch++)
+      {
+        sum[ch] += weights[j] * acc[j * CHANNELS + ch];
+      }
+    }
+    float grey = 0.0f;
+    for (int ch = 0; ch < CHANNELS; ch++)
+    {
+      grey += coefficients[ch] * sum[ch];
+    }
+    out_row[c] = (uint8_t)std::min(255, (int)(grey + 0.5f));
+  }
+}
+
+bool FramePreprocessor::process(const uint8_t *data, int width, int height, int step, const std::string &encoding,
+                                uint8_t *out)
+{
+  int channels;
+  const float *coefficients;
+  if (encoding == "mono8" || encoding == "8UC1")
+  {
+    channels = 1;
+    coefficients = GREY_MONO;
+  }
+  else if (encoding == "rgb8" || encoding == "rgba8")
+  {
+    channels = encoding == "rgb8" ? 3 : 4;
+    coefficients = GREY_RGB;
+  }
+  else if (encoding == "bgr8" || encoding == "bgra8")
+  {
+    channels = encoding == "bgr8" ? 3 : 4;
+    coefficients = GREY_BGR;
+  }
+  else
+  {
+    return false;
+  }
+  if (width <= 0 || height <= 0 || step < width * channels)
+  {
+    return false;
+  }
+
+  if (width != width_ || height != height_)
+  {
+    configure(width, height);
+  }
+
+  const int span = (x_end_ - x_begin_) * channels;
+  row_acc_.resize(span);
+  for (int r = 0; r < out_size_; r++)
+  {
+    const AreaTaps &taps = y_taps_[r];
+    std::fill(row_acc_.begin(), row_acc_.end(), 0.0f);
+    for (int k = 0; k < taps.count; k++)
+    {
+      const uint8_t *src = data + (size_t)(taps.first + k) * step + x_begin_ * channels;
+      accumulateRow(src, y_weights_[taps.offset + k], &row_acc_[0], span);
+    }
+
+    uint8_t *out_row = out + r * out_size_;
+    switch (channels)
+    {
+      case 1:
+        reduceColumns<1>(coefficients, out_row);
+        break;
+      case 3:
+        reduceColumns<3>(coefficients, out_row);
+        break;
+      default:
+        reduceColumns<4>(coefficients, out_row);
+        break;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,392 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Experience replay FIFO buffer storing every greyscale frame once.
+*/
+
+#include "../include/frameReplayBuffer.h"
+#include "../include/replayBuffer.h"
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+/*
+  HWC stack from DEPTH frames, with the depth known at compile time the loop is unrolled and vectorised
+*/
+template <int DEPTH>
+void interleave(const uint8_t *const *sources, size_t frame_size, uint8_t *out)
+{
+  for (size_t p = 0; p < frame_size; p++)
+  {
+    for (int k = 0; k < DEPTH; k++)
+    {
+      out[p * DEPTH + k] = sources[k][p];
+    }
+  }
+}
+
+// The common stack of 4 frames is written a pixel (4 bytes, little endian) at a time
+template <>
+void interleave<4>(const uint8_t *const *sources, size_t frame_size, uint8_t *out)
+{
+  const uint8_t *s0 = sources[0], *s1 = sources[1], *s2 = sources[2], *s3 = sources[3];
+  for (size_t p = 0; p < frame_size; p++)
+  {
+    uint32_t pixel = s0[p] | (uint32_t)s1[p] << 8 | (uint32_t)s2[p] << 16 | (uint32_t)s3[p] << 24;
+    memcpy(out + 4 * p, &pixel, sizeof(pixel));
+  }
+}
+}
+
+FrameReplayBuffer::FrameReplayBuffer(size_t capacity, int height, int width, int depth, uint64_t seed,
+                                     FrameCodec codec, size_t arena_bytes, int threads)
+{
+  capacity_ = capacity;
+  height_ = height;
+  width_ = width;
+  depth_ = depth;
+  frame_size_ = (size_t)height * width;
+  observation_size_ = frame_size_ * depth;
+  // Every transition adds one frame and every episode one more (its first frame), the headroom keeps the buffer
+  // full with episodes of 16 steps or more; shorter episodes evict transitions earlier
+  frame_capacity_ = capacity_ + capacity_ / 16 + depth_;
+
+  codec_ = codec;
+  if (codec == FRAME_RAW)
+  {
+    frames_.resize(frame_capacity_ * frame_size_);
+  }
+  else
+  {
+    compressed_.reset(new CompressedFrameStore(codec, frame_size_, frame_capacity_,
+                                               arena_bytes > 0 ? arena_bytes : frame_capacity_ * frame_size_ / 4));
+    pool_.reset(new WorkerPool(threads));
+    decoded_.resize(pool_->getSize());
+  }
+  episode_start_.resize(frame_capacity_);
+  transition_frames_.resize(capacity_);
+  actions_.resize(capacity_);
+  rewards_.resize(capacity_);
+  dones_.resize(capacity_);
+  last_observation_.resize(observation_size_);
+
+  generator_.seed(seed);
+  clear();
+}
+
+FrameReplayBuffer::~FrameReplayBuffer()
+{
+}
+
+size_t FrameReplayBuffer::slot(size_t position) const
+{
+  return (next_ + capacity_ - size_ + position) % capacity_;
+}
+
+uint64_t FrameReplayBuffer::firstFrame(uint64_t newest, uint64_t episode_start) const
+{
+  // Oldest frame of image_t, the transition of newest - 1
+  return newest - episode_start >= (uint64_t)depth_ ? newest - depth_ : episode_start;
+}
+
+void FrameReplayBuffer::evict(uint64_t first_kept)
+{
+  // Drop the oldest transitions whose stacks need a frame that is no longer available
+  while (size_ > 0)
+  {
+    uint64_t newest = transition_frames_[slot(0)];
+    uint64_t oldest = firstFrame(newest, episode_start_[newest % frame_capacity_]);
+    if (compressed_ != NULL)
+    {
+      oldest = compressed_->getKeyframe(oldest);
+    }
+    if (oldest >= first_kept)
+    {
+      break;
+    }
+    size_--;
+  }
+}
+
+uint8_t *FrameReplayBuffer::pushFrame(uint64_t episode_start)
+{
+  if (frames_written_ >= frame_capacity_)
+  {
+    evict(frames_written_ - frame_capacity_ + 1);
+  }
+  size_t s = frames_written_ % frame_capacity_;
+  episode_start_[s] = episode_start;
+  frames_written_++;
+  return compressed_ != NULL ? compressed_->stage() : &frames_[s * frame_size_];
+}
+
+void FrameReplayBuffer::commitFrame()
+{
+  // The frame returned by pushFrame has been written
+  if (compressed_ != NULL)
+  {
+    uint64_t frame = frames_written_ - 1;
+    evict(compressed_->commit(episode_start_[frame % frame_capacity_] == frame));
+  }
+}
+
+void FrameReplayBuffer::buildStack(uint64_t newest, uint64_t episode_start, const uint8_t *window,
+                                   uint64_t window_first, uint8_t *out) const
+{
+  // The frames come from the decoded window if given, from the circular array otherwise
+  std::vector<const uint8_t *> sources(depth_);
+  for (int k = 0; k < depth_; k++)
+  {
+    uint64_t back = depth_ - 1 - k;
+    uint64_t frame = newest - episode_start >= back ? newest - back : episode_start;
+    sources[k] = window != NULL ? window + (frame - window_first) * frame_size_ :
+                                  &frames_[(frame % frame_capacity_) * frame_size_];
+  }
+  switch (depth_)
+  {
+    case 4:
+      interleave<4>(&sources[0], frame_size_, out);
+      break;
+    case 3:
+      interleave<3>(&sources[0], frame_size_, out);
+      break;
+    case 2:
+      interleave<2>(&sources[0], frame_size_, out);
+      break;
+    default:
+      for (size_t p = 0; p < frame_size_; p++)
+      {
+        for (int k = 0; k < depth_; k++)
+        {
+          out[p * depth_ + k] = sources[k][p];
+        }
+      }
+      break;
+  }
+}
+
+void FrameReplayBuffer::startEpisode(const uint8_t *frame)
+{
+  memcpy(pushFrame(frames_written_), frame, frame_size_);
+  commitFrame();
+  in_episode_ = true;
+}
+
+bool FrameReplayBuffer::addStep(int32_t action, float reward, const uint8_t *frame_t1, bool done)
+{
+  if (in_episode_ == false || capacity_ == 0)
+  {
+    return false;
+  }
+  uint64_t start = episode_start_[(frames_written_ - 1) % frame_capacity_];
+  memcpy(pushFrame(start), frame_t1, frame_size_);
+  commitFrame();
+
+  if (size_ == capacity_)
+  {
+    size_--;
+  }
+  transition_frames_[next_] = frames_written_ - 1;
+  actions_[next_] = action;
+  rewards_[next_] = reward;
+  dones_[next_] = done;
+  next_ = (next_ + 1) % capacity_;
+  size_++;
+  in_episode_ = !done;
+  return true;
+}
+
+bool FrameReplayBuffer::add(const uint8_t *image_t, int32_t action, float reward, const uint8_t *image_t1, bool done)
+{
+  // image_t1 has to be image_t without its oldest frame plus a new one
+  for (size_t p = 0; p < frame_size_; p++)
+  {
+    if (memcmp(image_t + p * depth_ + 1, image_t1 + p * depth_, depth_ - 1) != 0)
+    {
+      return false;
+    }
+  }
+
+  if (in_episode_ == false || memcmp(image_t, &last_observation_[0], observation_size_) != 0)
+  {
+    // New episode: store the frames of image_t, except the leading repetitions of the oldest one
+    int repeated = 1;
+    while (repeated < depth_)
+    {
+      bool equal = true;
+      for (size_t p = 0; p < frame_size_ && equal; p++)
+      {
+        equal = image_t[p * depth_ + repeated] == image_t[p * depth_];
+      }
+      if (equal == false)
+      {
+        break;
+      }
+      repeated++;
+    }
+    uint64_t start = frames_written_;
+    for (int k = repeated - 1; k < depth_; k++)
+    {
+      uint8_t *frame = pushFrame(start);
+      for (size_t p = 0; p < frame_size_; p++)
+      {
+        frame[p] = image_t[p * depth_ + k];
+      }
+      commitFrame();
+    }
+    in_episode_ = true;
+  }
+
+  std::vector<uint8_t> frame_t1(frame_size_);
+  for (size_t p = 0; p < frame_size_; p++)
+  {
+    frame_t1[p] = image_t1[p * depth_ + depth_ - 1];
+  }
+  if (capacity_ == 0)
+  {
+    return true;
+  }
+  addStep(action, reward, &frame_t1[0], done);
+  memcpy(&last_observation_[0], image_t1, observation_size_);
+  return true;
+}
+
+bool FrameReplayBuffer::sampleIndices(size_t batch_size, size_t *positions)
+{
+  if (batch_size > size_)
+  {
+    return false;
+  }
+  sampleDistinct(generator_, size_, batch_size, positions, scratch_);
+  return true;
+}
+
+void FrameReplayBuffer::gather(const size_t *positions, size_t count, uint8_t *images_t, int32_t *actions,
+                               float *rewards, uint8_t *images_t1, uint8_t *dones) const
+{
+  if (compressed_ == NULL)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      size_t s = slot(positions[i]);
+      uint64_t newest = transition_frames_[s];
+      uint64_t start = episode_start_[newest % frame_capacity_];
+      buildStack(newest - 1, start, NULL, 0, images_t + i * observation_size_);
+      buildStack(newest, start, NULL, 0, images_t1 + i * observation_size_);
+      actions[i] = actions_[s];
+      rewards[i] = rewards_[s];
+      dones[i] = dones_[s];
+    }
+    return;
+  }
+
+  // Each worker decodes the frames of its share of the batch, from the oldest of image_t to the newest of image_t1
+  pool_->run(count, [&](size_t begin, size_t end, int worker) {
+    for (size_t i = begin; i < end; i++)
+    {
+      size_t s = slot(positions[i]);
+      uint64_t newest = transition_frames_[s];
+      uint64_t start = episode_start_[newest % frame_capacity_];
+      uint64_t first = firstFrame(newest, start);
+      const uint8_t *window = compressed_->decode(first, newest, decoded_[worker]);
+      buildStack(newest - 1, start, window, first, images_t + i * observation_size_);
+      buildStack(newest, start, window, first, images_t1 + i * observation_size_);
+      actions[i] = actions_[s];
+      rewards[i] = rewards_[s];
+      dones[i] = dones_[s];
+    }
+  }, 4);
+}
+
+bool FrameReplayBuffer::sample(size_t batch_size, uint8_t *images_t, int32_t *actions, float *rewards,
+                               uint8_t *images_t1, uint8_t *dones)
+{
+  std::vector<size_t> positions(batch_size);
+  if (sampleIndices(batch_size, positions.data()) == false)
+  {
+    return false;
+  }
+  gather(positions.data(), batch_size, images_t, actions, rewards, images_t1, dones);
+  return true;
+}
+
+size_t FrameReplayBuffer::getSlot(size_t position) const
+{
+  return slot(position);
+}
+
+void FrameReplayBuffer::seed(uint64_t seed)
+{
+  generator_.seed(seed);
+}
+
+void FrameReplayBuffer::clear()
+{
+  frames_written_ = 0;
+  next_ = 0;
+  size_ = 0;
+  in_episode_ = false;
+  if (compressed_ != NULL)
+  {
+    compressed_->clear();
+  }
+}
+
+size_t FrameReplayBuffer::getSize() const
+{
+  return size_;
+}
+
+size_t FrameReplayBuffer::getCapacity() const
+{
+  return capacity_;
+}
+
+size_t FrameReplayBuffer::getObservationSize() const
+{
+  return observation_size_;
+}
+
+int FrameReplayBuffer::getHeight() const
+{
+  return height_;
+}
+
+int FrameReplayBuffer::getWidth() const
+{
+  return width_;
+}
+
+int FrameReplayBuffer::getDepth() const
+{
+  return depth_;
+}
+
+FrameCodec FrameReplayBuffer::getCodec() const
+{
+  return codec_;
+}
+
+size_t FrameReplayBuffer::getByteSize() const
+{
+  return frames_.size() + (compressed_ != NULL ? compressed_->getByteSize() : 0) +
+         episode_start_.size() * sizeof(uint64_t) + transition_frames_.size() * sizeof(uint64_t) +
+         actions_.size() * sizeof(int32_t) + rewards_.size() * sizeof(float) + dones_.size() +
+         last_observation_.size();
+}
+
+size_t FrameReplayBuffer::getFrameBytes() const
+{
+  if (compressed_ != NULL)
+  {
+    return compressed_->getStoredBytes();
+  }
+  return std::min<uint64_t>(frames_written_, frame_capacity_) * frame_size_;
+}
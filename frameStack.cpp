@@ -0,0 +1,101 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Ring of the frames observed when the last actions were chosen, used to build the stacked observation of the
+  Q-network (height x width x depth, oldest frame first along the depth axis).
+*/
+
+#include "../include/frameStack.h"
+#include <string.h>
+
+FrameStack::FrameStack(int height, int width, int depth)
+{
+  height_ = height;
+  width_ = width;
+  depth_ = depth;
+  history_.resize((size_t)height * width * (depth - 1));
+  newest_ = -1;
+  count_ = 0;
+}
+
+FrameStack::~FrameStack()
+{
+}
+
+void FrameStack::push(const uint8_t *frame)
+{
+  if (depth_ < 2)
+  {
+    return;
+  }
+  const size_t frame_size = (size_t)height_ * width_;
+  newest_ = (newest_ + 1) % (depth_ - 1);
+  memcpy(&history_[newest_ * frame_size], frame, frame_size);
+  if (count_ < depth_ - 1)
+  {
+    count_++;
+  }
+}
+
+void FrameStack::clear()
+{
+  newest_ = -1;
+  count_ = 0;
+}
+
+void FrameStack::copyStacked(const uint8_t *latest, uint8_t *out) const
+{
+  const size_t frame_size = (size_t)height_ * width_;
+  const int slots = depth_ - 1;
+
+  // Source of every depth slot, oldest first
+  std::vector<const uint8_t *> sources(depth_);
+  for (int k = 0; k < slots; k++)
+  {
+    // Position of the slot counted backwards from the newest frame in the history
+    int age = slots - 1 - k;
+    if (count_ == 0)
+    {
+      sources[k] = latest;
+    }
+    else
+    {
+      if (age >= count_)
+      {
+        age = count_ - 1;
+      }
+      int index = ((newest_ - age) % slots + slots) % slots;
+      sources[k] = &history_[index * frame_size];
+    }
+  }
+  sources[depth_ - 1] = latest;
+
+  for (size_t p = 0; p < frame_size; p++)
+  {
+    for (int k = 0; k < depth_; k++)
+    {
+      out[p * depth_ + k] = sources[k][p];
+    }
+  }
+}
+
+int FrameStack::getHeight() const
+{
+  return height_;
+}
+
+int FrameStack::getWidth() const
+{
+  return width_;
+}
+
+int FrameStack::getDepth() const
+{
+  return depth_;
+}
@@ -0,0 +1,101 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Drive the Gazebo physics by a fixed number of iterations while the world is paused (lockstep simulation).
+*/
+
+#include "../include/gazeboStepper.h"
+#include <gazebo/gazebo_client.hh>
+#include <gazebo/msgs/msgs.hh>
+#include "gazebo_msgs/GetPhysicsProperties.h"
+#include <std_srvs/Empty.h>
+
+GazeboStepper::GazeboStepper()
+{
+  time_step_ = 0.0;
+  initialised_ = false;
+}
+
+GazeboStepper::~GazeboStepper()
+{
+  if (initialised_)
+  {
+    world_control_pub_.reset();
+    node_->Fini();
+    gazebo::client::shutdown();
+  }
+}
+
+bool GazeboStepper::init(ros::NodeHandle &nh)
+{
+  // The physics must not run on its own, otherwise the episodes are not reproducible
+  std_srvs::Empty empty;
+  if (!ros::service::waitForService("/gazebo/pause_physics", ros::Duration(10.0)) ||
+      !ros::service::call("/gazebo/pause_physics", empty))
+  {
+    ROS_ERROR("[LOCKSTEP] Unable to pause the physics");
+    return false;
+  }
+
+  gazebo_msgs::GetPhysicsProperties physics;
+  if (!ros::service::call("/gazebo/get_physics_properties", physics))
+  {
+    ROS_ERROR("[LOCKSTEP] Unable to read the physics properties");
+    return false;
+  }
+  time_step_ = physics.response.time_step;
+
+  if (!gazebo::client::setup())
+  {
+    ROS_ERROR("[LOCKSTEP] Unable to connect to the gazebo master");
+    return false;
+  }
+  node_ = gazebo::transport::NodePtr(new gazebo::transport::Node());
+  node_->Init();
+  world_control_pub_ = node_->Advertise<gazebo::msgs::WorldControl>("~/world_control");
+  world_control_pub_->WaitForConnection();
+
+  initialised_ = true;
+  ROS_INFO("[LOCKSTEP] World paused, physics time step: %f", time_step_);
+  return true;
+}
+
+ros::Time GazeboStepper::step(int iterations, ros::WallDuration timeout)
+{
+  ros::Time target = ros::Time::now() + ros::Duration(iterations * time_step_);
+
+  gazebo::msgs::WorldControl msg;
+  msg.set_multi_step(iterations);
+  world_control_pub_->Publish(msg);
+
+  // /clock is handled by the internal roscpp thread, so we only need to poll the time
+  ros::WallTime deadline = ros::WallTime::now() + timeout;
+  // Allow half an iteration of rounding between the expected and the published time
+  ros::Duration tolerance(time_step_ / 2.0);
+  while (ros::Time::now() + tolerance < target)
+  {
+    if (ros::WallTime::now() > deadline || !ros::ok())
+    {
+      ROS_WARN("[LOCKSTEP] Timeout while stepping the physics by %d iterations", iterations);
+      return ros::Time();
+    }
+    ros::WallDuration(0.0001).sleep();
+  }
+  return ros::Time::now();
+}
+
+double GazeboStepper::getTimeStep()
+{
+  return time_step_;
+}
+
+bool GazeboStepper::isInitialised()
+{
+  return initialised_;
+}
@@ -0,0 +1,90 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Table of the commands the nodes accept, indexed by integer: the velocity of every command (a direction scaled by
+  a magnitude) is read once at startup, so that a command is applied by index without comparing strings. The
+  default table has the actions of ActionId at the same indices, followed by takeoff; the table given by the
+  parameters may reorder them or add others (e.g. faster or diagonal moves).
+*/
+#ifndef ACTION_TABLE_H
+#define ACTION_TABLE_H
+
+#include <stddef.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "actions.h"
+
+enum ActionKind
+{
+  ACTION_KIND_MOVE = 0,
+  ACTION_KIND_TAKEOFF,
+  ACTION_KIND_LAND
+};
+
+struct ActionEntry
+{
+  std::string name;
+  // "takeoff" and "land" are commands of their own, every other name publishes the velocity
+  ActionKind kind;
+  // Action given to the reward and to the recorder, ACTION_UNKNOWN if it is not one of ActionId
+  ActionId action;
+  // Linear x, y, z and yaw rate
+  double velocity[4];
+};
+
+class ActionTable
+{
+private:
+  std::vector<ActionEntry> entries_;
+  std::unordered_map<std::string, int> index_;
+
+public:
+/*
+  @param speed is the magnitude of the moves
+  @param descend_speed is the magnitude of descend
+  @param diagonals gives the diagonal moves a velocity, otherwise they stop the UAV
+  @return the actions of ActionId at the same indices, followed by takeoff
+*/
+  static ActionTable defaults(double speed, double descend_speed, bool diagonals);
+
+/*
+  @param direction is linear x, y, z and yaw rate, scaled by the magnitude
+  @return the index of the action, -1 if the name is already in the table
+*/
+  int add(const std::string &name, const double direction[4], double magnitude);
+
+/*
+  Replace the table with the one given by the parameters (/drl_node/action_*), it is left as it is on error
+
+  @param names are the commands, in the order of their indices
+  @param directions are 4 values per command (see add)
+  @param magnitudes are 1 value per command
+  @param error is set to the reason of the failure
+*/
+  bool load(const std::vector<std::string> &names, const std::vector<double> &directions,
+            const std::vector<double> &magnitudes, std::string *error);
+
+/*
+  @return the entry of the index, NULL if it is out of the table
+*/
+  const ActionEntry *get(int id) const
+  {
+    return id >= 0 && id < (int)entries_.size() ? &entries_[id] : NULL;
+  }
+
+/*
+  @return the index of the command, -1 if it is not in the table
+*/
+  int find(const std::string &name) const;
+
+  size_t getSize() const;
+};
+
+#endif
@@ -0,0 +1,52 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Integer identifiers of the actions of the UAV, in the order of ACTION_LIST in native_replay_buffer.py: they are the
+  actions stored in the replay buffers and files.
+*/
+#ifndef ACTIONS_H
+#define ACTIONS_H
+
+#include <stdint.h>
+#include <string>
+
+enum ActionId
+{
+  ACTION_UNKNOWN = -1,
+  ACTION_LEFT = 0,
+  ACTION_RIGHT,
+  ACTION_FORWARD,
+  ACTION_BACKWARD,
+  ACTION_STOP,
+  ACTION_LAND,
+  ACTION_LEFT_FORWARD,
+  ACTION_LEFT_BACKWARD,
+  ACTION_RIGHT_FORWARD,
+  ACTION_RIGHT_BACKWARD,
+  ACTION_DESCEND,
+  ACTION_ASCEND,
+  ACTION_ROTATE_LEFT,
+  ACTION_ROTATE_RIGHT,
+  NUM_ACTIONS
+};
+
+// User flag of the replay files whose actions are ActionId (FLAG_STRING_ACTIONS in native_replay_buffer.py)
+const uint32_t REPLAY_FLAG_ACTION_IDS = 1;
+
+/*
+  @return the command string of the action (as accepted by drl/send_command), NULL if it is not an ActionId
+*/
+const char *actionName(int32_t action);
+
+/*
+  @return ACTION_UNKNOWN if the command is not one of the actions (e.g. takeoff)
+*/
+ActionId actionFromName(const std::string &name);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Publication of the UAV's commands as soon as they are received. A velocity command is then held: a watchdog thread
+  re-sends it at a fixed rate and, once the hold time has elapsed without a new command, sends a zero velocity so
+  that the UAV does not keep flying on a stale command. The latency from the reception of a command to its first
+  publication is measured.
+*/
+#ifndef COMMAND_DISPATCHER_H
+#define COMMAND_DISPATCHER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "geometry_msgs/Twist.h"
+#include "ros/ros.h"
+
+class CommandDispatcher
+{
+private:
+  ros::Publisher cmd_pub_, takeoff_pub_, land_pub_;
+  // Re-sends per second and duration of the hold [s], 0 disables them
+  double rate_, hold_;
+
+  // Velocity being held, re-sent at next_send_ until hold_until_
+  geometry_msgs::Twist active_;
+  bool holding_;
+  ros::WallTime next_send_, hold_until_;
+
+  std::thread watchdog_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool running_;
+
+  // Latency between the reception of the commands and their publication [s]
+  double last_latency_, total_latency_, max_latency_;
+  unsigned long dispatched_;
+
+  void watchdogLoop();
+  void account(const ros::WallTime &received);
+
+public:
+  CommandDispatcher();
+  ~CommandDispatcher();
+
+/*
+  Set the publishers and start the watchdog, if needed
+
+  @param rate is how many times per second the active velocity is re-sent, 0 sends it once
+  @param hold is how long a velocity is kept before a zero velocity replaces it, 0 keeps it until the next command
+*/
+  void init(const ros::Publisher &cmd_pub, const ros::Publisher &takeoff_pub, const ros::Publisher &land_pub,
+            double rate, double hold);
+
+/*
+  Stop the watchdog, nothing is published afterwards
+*/
+  void shutdown();
+
+/*
+  Publish a velocity now and hold it
+
+  @param received is when the command reached the node, for the latency
+*/
+  void move(const geometry_msgs::Twist &velocity, const ros::WallTime &received);
+
+/*
+  Publish a take-off or landing now, the velocity being held is dropped without being zeroed
+*/
+  void takeoff(const ros::WallTime &received);
+  void land(const ros::WallTime &received);
+
+  double getLastLatency();
+  double getMeanLatency();
+  double getMaxLatency();
+  unsigned long getDispatched();
+};
+
+#endif
@@ -0,0 +1,103 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  FIFO of compressed greyscale frames for FrameReplayBuffer. The frames are compressed with LZ4 one after the other in
+  a circular arena of fixed size, so the number of frames held depends on how well they compress: the oldest frames
+  are dropped when either the arena or the table of frames is full.
+
+  With FRAME_DELTA_LZ4 a frame is stored as its difference from the previous frame of the same episode (mostly zeros
+  on the uniform ground textures) and every KEYFRAME_INTERVAL frames, as well as the first frame of an episode, is a
+  keyframe compressed on its own. Decoding a frame starts from its keyframe.
+*/
+#ifndef COMPRESSED_FRAME_STORE_H
+#define COMPRESSED_FRAME_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+enum FrameCodec
+{
+  FRAME_RAW = 0,
+  FRAME_LZ4,
+  FRAME_DELTA_LZ4
+};
+
+class CompressedFrameStore
+{
+public:
+  static const int KEYFRAME_INTERVAL = 8;
+
+private:
+  FrameCodec codec_;
+  size_t frame_size_, frame_capacity_;
+
+  std::vector<char> arena_;
+  // Absolute bytes written in the arena, a frame that does not fit before its end starts again from 0
+  uint64_t arena_head_;
+
+  // Circular table of frames, addressed by the absolute number of the frame
+  std::vector<uint64_t> offsets_;
+  std::vector<uint32_t> lengths_;
+  std::vector<uint64_t> keyframes_;
+  uint64_t frames_written_;
+  // Oldest frame whose data is still in the arena
+  uint64_t first_valid_;
+
+  // Frame being added, previous frame of its episode and compression scratch
+  std::vector<uint8_t> staging_, previous_, delta_;
+  std::vector<char> compressed_;
+
+public:
+/*
+  @param codec is FRAME_LZ4 or FRAME_DELTA_LZ4
+  @param frame_size is the number of bytes of a frame
+  @param frame_capacity is the maximum number of frames
+  @param arena_bytes is the memory for the compressed frames (raised to hold at least a few of them)
+*/
+  CompressedFrameStore(FrameCodec codec, size_t frame_size, size_t frame_capacity, size_t arena_bytes);
+  ~CompressedFrameStore();
+
+/*
+  @return the buffer where the frame to add has to be written before calling commit
+*/
+  uint8_t *stage();
+
+/*
+  Compress the staged frame as the next frame
+
+  @param episode_start is true for the first frame of an episode
+  @return the oldest frame still available, the frames before it have been dropped
+*/
+  uint64_t commit(bool episode_start);
+
+/*
+  @return the frame from which the decoding of the given one starts
+*/
+  uint64_t getKeyframe(uint64_t frame) const;
+
+/*
+  Decode the consecutive frames [first, last] of one episode
+
+  @param frames is a scratch buffer, resized as needed (one per thread)
+  @return the decoded frame first, followed by the others
+*/
+  const uint8_t *decode(uint64_t first, uint64_t last, std::vector<uint8_t> &frames) const;
+
+  void clear();
+
+  uint64_t getFirstValid() const;
+/*
+  @return the compressed bytes of the frames available
+*/
+  size_t getStoredBytes() const;
+  size_t getByteSize() const;
+};
+
+#endif
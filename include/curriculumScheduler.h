@@ -0,0 +1,72 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Curriculum of the spawn distribution driven by the landing success rate. The first stage spawns the UAV close to
+  the marker (x/y spread scaled down, altitude capped), the last one uses the target distribution, the stages in
+  between are linear steps. The success rate is measured over the last episodes of the current stage: above the
+  promotion rate the next stage begins, below the demotion rate the previous one.
+*/
+#ifndef CURRICULUM_SCHEDULER_H
+#define CURRICULUM_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "spawnSampler.h"
+
+struct CurriculumConfig
+{
+  // 1 disables the curriculum: the target distribution is used from the beginning
+  int stages;
+  // Episodes over which the success rate is measured, a stage lasts at least as many
+  int window;
+  double promote_rate, demote_rate;
+  // x/y spread of the first stage wrt the target one
+  double start_xy_scale;
+  // Highest altitude of the first stage, 0 keeps the target altitudes at every stage
+  double start_z;
+
+  CurriculumConfig();
+};
+
+class CurriculumScheduler
+{
+private:
+  CurriculumConfig config_;
+  SpawnConfig target_;
+  int stage_;
+
+  // Outcomes of the last episodes of the stage, circular
+  std::vector<uint8_t> outcomes_;
+  size_t episodes_, successes_;
+
+public:
+  explicit CurriculumScheduler(const CurriculumConfig &config = CurriculumConfig(),
+                               const SpawnConfig &target = SpawnConfig());
+
+/*
+  Account for the end of an episode
+
+  @param success is true if the UAV landed in the landing box
+  @return true if the stage has changed (see getSpawnConfig)
+*/
+  bool reportEpisode(bool success);
+
+/*
+  @return the spawn distribution of the current stage
+*/
+  SpawnConfig getSpawnConfig() const;
+
+  int getStage() const;
+  int getNumStages() const;
+  double getSuccessRate() const;
+  size_t getEpisodes() const;
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Fused preprocessing of the bottom camera's frames: crop, area downsampling and greyscale conversion in a single pass
+  that reads only the source pixels falling inside the region of interest.
+*/
+#ifndef FRAME_PREPROCESSOR_H
+#define FRAME_PREPROCESSOR_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class FramePreprocessor
+{
+private:
+  // Source pixels (and their weights) averaged into an output row or column
+  struct AreaTaps
+  {
+    int first;
+    int count;
+    int offset;
+  };
+
+  int out_size_;
+  double scale_;
+  int roi_x_, roi_y_;
+
+  // Tables computed for the last source size
+  int width_, height_;
+  std::vector<AreaTaps> x_taps_, y_taps_;
+  std::vector<float> x_weights_, y_weights_;
+  int x_begin_, x_end_;
+  // Weighted sum of the source rows of an output row, still interleaved by channel
+  std::vector<float> row_acc_;
+
+  void configure(int width, int height);
+  static void computeTaps(int offset, int count, double inv_scale, int size, std::vector<AreaTaps> &taps,
+                          std::vector<float> &weights);
+  template <int CHANNELS>
+  void reduceColumns(const float *coefficients, uint8_t *out_row);
+
+public:
+/*
+  @param out_size is the side of the square output frame
+  @param scale is the resize factor applied to the full frame
+  @param roi_x, roi_y are the top-left corner of the region of interest in the resized frame
+*/
+  FramePreprocessor(int out_size = 84, double scale = 0.233333333, int roi_x = 33, int roi_y = 0);
+  ~FramePreprocessor();
+
+/*
+  Produce the greyscale out_size x out_size frame
+
+  @param data points to the first pixel of the source image
+  @param width, height are the source image size in pixels
+  @param step is the length of a source row in bytes
+  @param encoding is the ROS image encoding (mono8, rgb8, bgr8, rgba8, bgra8)
+  @param out is a buffer of out_size * out_size bytes
+  @return false if the encoding is not supported, or if the size is not (an empty image, rows shorter than width
+  pixels); the caller checks that data holds step * height bytes
+*/
+  bool process(const uint8_t *data, int width, int height, int step, const std::string &encoding, uint8_t *out);
+
+  int getOutSize();
+};
+
+#endif
@@ -0,0 +1,156 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Experience replay FIFO buffer storing every greyscale frame once. Consecutive stacked observations share
+  depth - 1 frames, so the frames are kept in a circular array and each transition only refers to the frame it
+  added: image_t and image_t1 are rebuilt at sample time from the depth frames preceding it.
+
+  An episode starts with a frame whose stack is that frame repeated depth times (as done by the training
+  scripts); frames preceding the beginning of an episode are replaced by its first frame.
+
+  The frames can be kept compressed (see CompressedFrameStore) in an arena of fixed size: the transitions whose
+  frames are dropped from the arena are evicted with them, and a batch is decoded by a pool of threads.
+*/
+#ifndef FRAME_REPLAY_BUFFER_H
+#define FRAME_REPLAY_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <random>
+#include <vector>
+#include "compressedFrameStore.h"
+#include "workerPool.h"
+
+class FrameReplayBuffer
+{
+private:
+  size_t capacity_, frame_capacity_;
+  int height_, width_, depth_;
+  size_t frame_size_, observation_size_;
+
+  // Circular array of frames, addressed by the absolute number of the frame (empty when they are compressed)
+  FrameCodec codec_;
+  std::vector<uint8_t> frames_;
+  std::unique_ptr<CompressedFrameStore> compressed_;
+  std::unique_ptr<WorkerPool> pool_;
+  // Decoded frames of every worker of the pool
+  mutable std::vector<std::vector<uint8_t> > decoded_;
+  // Absolute number of the first frame of the episode each frame belongs to
+  std::vector<uint64_t> episode_start_;
+  uint64_t frames_written_;
+
+  // Circular array of transitions: newest frame of image_t1, action, reward and done
+  std::vector<uint64_t> transition_frames_;
+  std::vector<int32_t> actions_;
+  std::vector<float> rewards_;
+  std::vector<uint8_t> dones_;
+  size_t next_;
+  size_t size_;
+
+  // Stack added last through add(), to recognise the continuation of an episode
+  std::vector<uint8_t> last_observation_;
+  bool in_episode_;
+
+  std::mt19937_64 generator_;
+  std::vector<size_t> scratch_;
+
+  size_t slot(size_t position) const;
+  void evict(uint64_t first_kept);
+  uint8_t *pushFrame(uint64_t episode_start);
+  void commitFrame();
+  uint64_t firstFrame(uint64_t newest, uint64_t episode_start) const;
+  void buildStack(uint64_t newest, uint64_t episode_start, const uint8_t *window, uint64_t window_first,
+                  uint8_t *out) const;
+
+public:
+/*
+  @param capacity is the maximum number of transitions
+  @param height, width, depth are the shape of the stacked observations (HWC, uint8)
+  @param seed initialises the generator used for sampling
+  @param codec is FRAME_RAW or how the frames are compressed
+  @param arena_bytes is the memory for the compressed frames, 0 for a quarter of the uncompressed ones
+  @param threads decoding a batch of compressed frames, 0 for one per core
+*/
+  FrameReplayBuffer(size_t capacity, int height, int width, int depth, uint64_t seed = 0,
+                    FrameCodec codec = FRAME_RAW, size_t arena_bytes = 0, int threads = 0);
+  ~FrameReplayBuffer();
+
+/*
+  Begin an episode
+
+  @param frame is the first height x width frame, its stack is the frame repeated depth times
+*/
+  void startEpisode(const uint8_t *frame);
+
+/*
+  Add the transition following the last frame of the current episode
+
+  @param frame_t1 is the height x width frame observed after the action
+  @return false if no episode is in progress (never started or already done)
+*/
+  bool addStep(int32_t action, float reward, const uint8_t *frame_t1, bool done);
+
+/*
+  Add a transition given as stacked observations (same interface as ReplayBuffer). It continues the current
+  episode when image_t is the last image_t1 added, otherwise the frames of image_t begin a new episode.
+
+  @param image_t, image_t1 are height x width x depth observations
+  @return false if image_t1 is not image_t shifted by one frame, such transition cannot be stored
+*/
+  bool add(const uint8_t *image_t, int32_t action, float reward, const uint8_t *image_t1, bool done);
+
+/*
+  Draw distinct positions uniformly (0 is the oldest transition)
+
+  @return false if batch_size is larger than the number of transitions stored
+*/
+  bool sampleIndices(size_t batch_size, size_t *positions);
+
+/*
+  Rebuild the transitions at the given positions in the caller's buffers
+
+  @param images_t, images_t1 receive count * getObservationSize() bytes
+  @param actions, rewards, dones receive count elements
+*/
+  void gather(const size_t *positions, size_t count, uint8_t *images_t, int32_t *actions, float *rewards,
+              uint8_t *images_t1, uint8_t *dones) const;
+
+/*
+  Uniform sampling without replacement into the caller's buffers (see gather)
+
+  @return false if batch_size is larger than the number of transitions stored
+*/
+  bool sample(size_t batch_size, uint8_t *images_t, int32_t *actions, float *rewards, uint8_t *images_t1,
+              uint8_t *dones);
+
+/*
+  @param position of a stored transition (0 is the oldest)
+  @return the storage slot of the transition, in [0, capacity) and stable until it is overwritten
+*/
+  size_t getSlot(size_t position) const;
+
+  void seed(uint64_t seed);
+  void clear();
+
+  size_t getSize() const;
+  size_t getCapacity() const;
+  size_t getObservationSize() const;
+  int getHeight() const;
+  int getWidth() const;
+  int getDepth() const;
+  FrameCodec getCodec() const;
+  size_t getByteSize() const;
+/*
+  @return the bytes taken by the frames available, compressed or not
+*/
+  size_t getFrameBytes() const;
+};
+
+#endif
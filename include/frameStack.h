@@ -0,0 +1,58 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Ring of the frames observed when the last actions were chosen, used to build the stacked observation of the
+  Q-network (height x width x depth, oldest frame first along the depth axis).
+*/
+#ifndef FRAME_STACK_H
+#define FRAME_STACK_H
+
+#include <stdint.h>
+#include <vector>
+
+class FrameStack
+{
+private:
+  int height_, width_, depth_;
+  // depth - 1 frames, the last slot of the stack is always the latest frame
+  std::vector<uint8_t> history_;
+  int newest_;
+  int count_;
+
+public:
+  FrameStack(int height = 84, int width = 84, int depth = 4);
+  ~FrameStack();
+
+/*
+  Store the frame on which an action has been chosen
+
+  @param frame is a height x width greyscale frame
+*/
+  void push(const uint8_t *frame);
+
+/*
+  Forget the history, e.g. at the beginning of an episode
+*/
+  void clear();
+
+/*
+  Build the stacked observation. Missing history (beginning of an episode) is filled with the oldest
+  frame available, as done by the training scripts.
+
+  @param latest is the current height x width frame, placed last along the depth axis
+  @param out is a buffer of height * width * depth bytes in HWC order
+*/
+  void copyStacked(const uint8_t *latest, uint8_t *out) const;
+
+  int getHeight() const;
+  int getWidth() const;
+  int getDepth() const;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Drive the Gazebo physics by a fixed number of iterations while the world is paused (lockstep simulation).
+*/
+#ifndef GAZEBO_STEPPER_H
+#define GAZEBO_STEPPER_H
+
+#include <gazebo/transport/transport.hh>
+#include "ros/ros.h"
+
+class GazeboStepper
+{
+private:
+  // Gazebo transport node used to publish on ~/world_control
+  gazebo::transport::NodePtr node_;
+  gazebo::transport::PublisherPtr world_control_pub_;
+
+  // Duration of a single physics iteration
+  double time_step_;
+  bool initialised_;
+
+public:
+  GazeboStepper();
+  ~GazeboStepper();
+
+/*
+  Connect to the Gazebo master, pause the world and read the physics time step
+
+  @param nh is the node handle used for querying the physics properties
+  @return true if the world is ready to be stepped
+*/
+  bool init(ros::NodeHandle &nh);
+
+/*
+  Advance the paused world and wait until the simulation time reflects it.
+  The wait relies on /clock, therefore gazebo must publish it at every iteration (pub_clock_frequency = 0).
+
+  @param iterations is the number of physics iterations to run
+  @param timeout is the maximum wall time to wait for the iterations to complete
+  @return the simulation time reached, or a zero time on timeout
+*/
+  ros::Time step(int iterations, ros::WallDuration timeout);
+
+  double getTimeStep();
+  bool isInitialised();
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Landing pads of a world with many markers: the markers and their landing boxes (as those of RewardEngine) are
+  a struct of arrays, indexed by a uniform grid on x/y with about one pad per cell and cells at least as large as a
+  landing box. A box overlaps at most the 3x3 cells around its marker, so the box containing a point is found among
+  a handful of pads and the nearest marker by visiting rings of cells around the point; neither cost grows with the
+  number of pads.
+*/
+#ifndef LANDING_PADS_H
+#define LANDING_PADS_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "rewardEngine.h"
+
+class LandingPads
+{
+private:
+  double landing_half_size_, landing_height_;
+  double cell_size_;
+
+  // Markers and landing boxes, one element per pad
+  std::vector<double> marker_x_, marker_y_, marker_z_;
+  std::vector<double> min_x_, max_x_, min_y_, max_y_, min_z_, max_z_;
+  std::vector<uint64_t> cell_of_;
+
+  // Pads of the non-empty cells and the extent of the grid (it only grows)
+  std::unordered_map<uint64_t, std::vector<int> > cells_;
+  int32_t min_cell_x_, max_cell_x_, min_cell_y_, max_cell_y_;
+
+  int32_t cellOf(double coordinate) const;
+  static uint64_t key(int32_t cell_x, int32_t cell_y);
+  void insert(int pad);
+  void remove(int pad);
+  void rebuild();
+
+public:
+/*
+  @param config gives the size of the landing boxes
+*/
+  explicit LandingPads(const RewardConfig &config = RewardConfig());
+
+/*
+  @return the index of the new pad
+*/
+  int addPad(double x, double y, double z);
+
+/*
+  Move the marker of a pad, nothing is done if it has not moved
+*/
+  void movePad(int pad, double x, double y, double z);
+
+/*
+  @return the pad whose landing box contains the point, -1 if none
+*/
+  int containing(double x, double y, double z) const;
+
+/*
+  @return the pad whose marker is the nearest on x/y, -1 if there are no pads
+*/
+  int nearest(double x, double y) const;
+
+/*
+  Pad the UAV is referred to: the one whose landing box contains it, otherwise the nearest
+
+  @return -1 if there are no pads
+*/
+  int locate(double x, double y, double z) const
+  {
+    int pad = containing(x, y, z);
+    return pad >= 0 ? pad : nearest(x, y);
+  }
+
+  void getMarker(int pad, double *x, double *y, double *z) const;
+  RewardBox getLandingBox(int pad) const;
+  size_t getSize() const;
+};
+
+#endif
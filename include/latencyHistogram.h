@@ -0,0 +1,117 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Histogram of latencies in nanoseconds with a bounded relative error, as HdrHistogram: every power of two is split
+  in 32 linear buckets, so that any percentile is known within 3% from 1 ns to about 36 minutes with a fixed array
+  of counters. Recording is a bucket lookup (a count of leading zeros) and a relaxed atomic increment: any thread
+  may record without locks, the readers see the counts as they are at that moment.
+*/
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+
+class LatencyHistogram
+{
+public:
+  static const int SUB_BUCKET_BITS = 5;
+  static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  // Latencies below 2^41 ns, longer ones are counted in the last bucket
+  static const int MAX_EXPONENT = 40;
+  static const int NUM_BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+private:
+  uint64_t counts_[NUM_BUCKETS];
+  uint64_t count_, total_, max_;
+
+public:
+  LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram &other) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &other) = delete;
+
+/*
+  @return the time of a monotonic clock [ns]
+*/
+  static int64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+/*
+  @param latency is in nanoseconds, negative values count as 0
+*/
+  void record(int64_t latency)
+  {
+    const uint64_t value = latency > 0 ? latency : 0;
+    __atomic_fetch_add(&counts_[bucketOf(value)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&count_, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&total_, value, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&max_, __ATOMIC_RELAXED);
+    while (value > max && !__atomic_compare_exchange_n(&max_, &max, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+  }
+
+/*
+  Record the time elapsed since start, a value of now()
+*/
+  void recordSince(int64_t start)
+  {
+    record(now() - start);
+  }
+
+/*
+  @param percentile is in [0, 100]
+  @return the latency below which that percentage of the records falls [ns], 0 if there are none
+*/
+  uint64_t getPercentile(double percentile) const;
+
+  uint64_t getCount() const;
+  uint64_t getMax() const;
+  double getMean() const;
+
+/*
+  Discard the records, those made meanwhile by other threads may be partly kept
+*/
+  void reset();
+
+  static int bucketOf(uint64_t value)
+  {
+    if (value < (uint64_t)SUB_BUCKETS)
+    {
+      return value;
+    }
+    const int exponent = 63 - __builtin_clzll(value);
+    if (exponent > MAX_EXPONENT)
+    {
+      return NUM_BUCKETS - 1;
+    }
+    const int shift = exponent - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+  }
+
+/*
+  @return the smallest latency counted in the bucket
+*/
+  static uint64_t lowestOf(int bucket)
+  {
+    if (bucket < SUB_BUCKETS)
+    {
+      return bucket;
+    }
+    const int shift = bucket / SUB_BUCKETS - 1;
+    return (uint64_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+  }
+};
+
+#endif
@@ -0,0 +1,82 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Table of the latest poses of all the models in the Gazebo world, fed by /gazebo/model_states.
+*/
+#ifndef MODEL_STATE_CACHE_H
+#define MODEL_STATE_CACHE_H
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "gazebo_msgs/ModelStates.h"
+#include "geometry_msgs/Pose.h"
+#include "ros/ros.h"
+
+class ModelStateCache
+{
+private:
+  ros::Subscriber model_states_sub_;
+  // Persistent client, used only when a pose must be read synchronously
+  ros::ServiceClient get_state_client_;
+
+  // Model names in the order of the last message and their slot in the table
+  std::vector<std::string> names_;
+  std::map<std::string, size_t> index_;
+  std::vector<geometry_msgs::Pose> poses_;
+  // Poses read by refresh() of the models missing from the last message, kept apart so that the names above
+  // always match the messages
+  std::map<std::string, geometry_msgs::Pose> fallback_poses_;
+  unsigned long updates_;
+  std::mutex mutex_;
+
+/*
+  Store the poses of the latest message. The name index is rebuilt only when models are added or removed.
+
+  @param msg contains names and poses of all the models in the world
+*/
+  void modelStatesCallback(const gazebo_msgs::ModelStates::ConstPtr &msg);
+
+public:
+  ModelStateCache();
+  ~ModelStateCache();
+
+/*
+  Subscribe to the model states and open the persistent GetModelState client
+
+  @param nh is the node handle whose callback queue serves the subscription
+*/
+  void init(ros::NodeHandle &nh);
+
+/*
+  Get the latest known pose of a model
+
+  @param name is the name of the model in Gazebo
+  @param pose is filled with the pose of the model
+  @return false if the model has never been seen
+*/
+  bool getPose(const std::string &name, geometry_msgs::Pose &pose);
+
+/*
+  Read the pose of a model from Gazebo through the persistent client and store it in the table.
+  Used when the pose must be the current one (e.g. the world has just been stepped).
+
+  @param name is the name of the model in Gazebo
+  @return false if the service call failed
+*/
+  bool refresh(const std::string &name);
+
+/*
+  @return the number of model states messages received so far
+*/
+  unsigned long getUpdates();
+};
+
+#endif
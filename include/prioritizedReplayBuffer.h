@@ -0,0 +1,182 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Proportional prioritised experience replay (Schaul et al., 2016) on top of ReplayBuffer or FrameReplayBuffer.
+  Transition i is sampled with probability p_i^alpha / sum_k p_k^alpha, where p_i is its last TD error; new
+  transitions get the largest priority seen so far. Samples are returned with their importance-sampling weights
+  (N * P(i))^-beta normalised by the largest weight, and with the slot used to update their priorities and the
+  write count of the slot, which tells a transition written into the slot after the sampling.
+*/
+#ifndef PRIORITIZED_REPLAY_BUFFER_H
+#define PRIORITIZED_REPLAY_BUFFER_H
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "priorityTree.h"
+
+template <typename Storage>
+class PrioritizedReplayBuffer
+{
+private:
+  Storage storage_;
+  PriorityTree tree_;
+  double alpha_;
+  double epsilon_;
+  // Largest priority seen so far (before alpha)
+  double max_priority_;
+  std::mt19937_64 generator_;
+  std::vector<size_t> positions_;
+  // Transitions written into each slot so far
+  std::vector<uint64_t> writes_;
+
+  size_t position(size_t slot) const
+  {
+    const size_t capacity = storage_.getCapacity();
+    return (slot + capacity - storage_.getSlot(0)) % capacity;
+  }
+
+public:
+/*
+  @param capacity is the maximum number of transitions
+  @param height, width, depth are the shape of the stacked observations (HWC, uint8)
+  @param alpha is the prioritisation exponent (0 gives uniform sampling)
+  @param epsilon is added to the TD errors so that no transition has zero probability
+*/
+  PrioritizedReplayBuffer(size_t capacity, int height, int width, int depth, double alpha = 0.6,
+                          double epsilon = 1e-6, uint64_t seed = 0)
+    : storage_(capacity, height, width, depth, seed), tree_(capacity), writes_(capacity, 0)
+  {
+    alpha_ = alpha;
+    epsilon_ = epsilon;
+    max_priority_ = 1.0;
+    generator_.seed(seed + 1);
+  }
+
+/*
+  Add a transition with the largest priority (see Storage::add)
+*/
+  bool add(const uint8_t *image_t, int32_t action, float reward, const uint8_t *image_t1, bool done)
+  {
+    const size_t before = storage_.getSize();
+    const size_t oldest = before > 0 ? storage_.getSlot(0) : 0;
+    if (storage_.add(image_t, action, reward, image_t1, done) == false)
+    {
+      return false;
+    }
+    const size_t after = storage_.getSize();
+    if (after == 0)
+    {
+      return true;
+    }
+    // Transitions evicted by the storage leave the distribution
+    const size_t capacity = storage_.getCapacity();
+    for (size_t i = 0; i + after < before + 1; i++)
+    {
+      tree_.set((oldest + i) % capacity, 0.0);
+    }
+    const size_t slot = storage_.getSlot(after - 1);
+    writes_[slot]++;
+    tree_.set(slot, std::pow(max_priority_, alpha_));
+    return true;
+  }
+
+/*
+  Proportional sampling with replacement: one sample in each of batch_size equal ranges of the total priority
+
+  @param beta is the importance-sampling exponent (annealed towards 1 during training)
+  @param weights receives batch_size importance-sampling weights
+  @param slots receives batch_size slots, to be given back to updatePriorities
+  @param writes receives the write counts of the slots, to be given back to updatePriorities (may be NULL)
+  @return false if the buffer is empty
+*/
+  bool sample(size_t batch_size, double beta, uint8_t *images_t, int32_t *actions, float *rewards,
+              uint8_t *images_t1, uint8_t *dones, float *weights, size_t *slots, uint64_t *writes = NULL)
+  {
+    const size_t size = storage_.getSize();
+    const double total = tree_.getTotal();
+    if (size == 0 || total <= 0.0)
+    {
+      return false;
+    }
+    const double segment = total / batch_size;
+    const double max_weight = std::pow(size * tree_.getMin() / total, -beta);
+    positions_.resize(batch_size);
+    for (size_t i = 0; i < batch_size; i++)
+    {
+      std::uniform_real_distribution<double> distribution(i * segment, (i + 1) * segment);
+      slots[i] = tree_.find(std::min(distribution(generator_), std::nextafter(total, 0.0)));
+      positions_[i] = position(slots[i]);
+      weights[i] = (float)(std::pow(size * tree_.get(slots[i]) / total, -beta) / max_weight);
+      if (writes != NULL)
+      {
+        writes[i] = writes_[slots[i]];
+      }
+    }
+    storage_.gather(positions_.data(), batch_size, images_t, actions, rewards, images_t1, dones);
+    return true;
+  }
+
+/*
+  Set the priorities of sampled transitions after a learner step
+
+  @param slots are the slots returned by sample
+  @param td_errors are the new absolute TD errors
+  @param writes are the write counts returned by sample. If NULL, a transition written into a slot since the
+  sampling gets the TD error of the one it replaced
+*/
+  void updatePriorities(const size_t *slots, const float *td_errors, size_t count, const uint64_t *writes = NULL)
+  {
+    const size_t size = storage_.getSize();
+    for (size_t i = 0; i < count; i++)
+    {
+      // A slot emptied or overwritten since it was sampled keeps its current priority
+      if (size == 0 || position(slots[i]) >= size || tree_.get(slots[i]) <= 0.0 ||
+          (writes != NULL && writes[i] != writes_[slots[i]]))
+      {
+        continue;
+      }
+      double priority = std::fabs(td_errors[i]) + epsilon_;
+      max_priority_ = std::max(max_priority_, priority);
+      tree_.set(slots[i], std::pow(priority, alpha_));
+    }
+  }
+
+  void clear()
+  {
+    storage_.clear();
+    tree_.clear();
+    max_priority_ = 1.0;
+  }
+
+  void seed(uint64_t seed)
+  {
+    storage_.seed(seed);
+    generator_.seed(seed + 1);
+  }
+
+  const Storage &getStorage() const
+  {
+    return storage_;
+  }
+
+  size_t getByteSize() const
+  {
+    // Sum and min heaps of doubles over the slots rounded up to a power of two
+    size_t leaves = 1;
+    while (leaves < storage_.getCapacity())
+    {
+      leaves *= 2;
+    }
+    return storage_.getByteSize() + 4 * leaves * sizeof(double) + writes_.size() * sizeof(uint64_t);
+  }
+};
+
+#endif
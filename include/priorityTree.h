@@ -0,0 +1,51 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Sum-tree and min-tree over the priorities of the replay buffer's slots: O(log n) update, proportional search and
+  O(1) total and minimum.
+*/
+#ifndef PRIORITY_TREE_H
+#define PRIORITY_TREE_H
+
+#include <stddef.h>
+#include <vector>
+
+class PriorityTree
+{
+private:
+  size_t leaves_;
+  // Binary heaps, node i has children 2i and 2i + 1, the leaves start at leaves_
+  std::vector<double> sum_;
+  std::vector<double> min_;
+
+public:
+/*
+  @param size is the number of slots, all with priority 0
+*/
+  PriorityTree(size_t size = 0);
+  ~PriorityTree();
+
+  void set(size_t index, double priority);
+  double get(size_t index) const;
+
+/*
+  @param prefix is a value in [0, getTotal())
+  @return the slot whose cumulative priority range contains prefix
+*/
+  size_t find(double prefix) const;
+
+  double getTotal() const;
+/*
+  @return the smallest non-zero priority (infinity when all are 0)
+*/
+  double getMin() const;
+  void clear();
+};
+
+#endif
@@ -0,0 +1,115 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Experience replay FIFO buffer for DQN with preallocated contiguous storage: one array per component of the
+  transitions (image_t, action, reward, image_t1, done). When the buffer is full the oldest transition is
+  overwritten, as done by ExperienceReplayBuffer in experience_replay_buffer.py.
+*/
+#ifndef REPLAY_BUFFER_H
+#define REPLAY_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <random>
+#include <vector>
+
+/*
+  Draw distinct integers uniformly in [0, n), in O(1) each when count is small wrt n
+
+  @param out receives count integers
+  @param scratch is reused between calls when count is comparable to n
+*/
+void sampleDistinct(std::mt19937_64 &generator, size_t n, size_t count, size_t *out, std::vector<size_t> &scratch);
+
+class ReplayBuffer
+{
+private:
+  size_t capacity_;
+  size_t observation_size_;
+  int height_, width_, depth_;
+
+  std::vector<uint8_t> images_t_;
+  std::vector<int32_t> actions_;
+  std::vector<float> rewards_;
+  std::vector<uint8_t> images_t1_;
+  std::vector<uint8_t> dones_;
+
+  // Slot written by the next add and number of transitions stored
+  size_t next_;
+  size_t size_;
+
+  std::mt19937_64 generator_;
+  std::vector<size_t> scratch_;
+
+  size_t slot(size_t position) const;
+
+public:
+/*
+  @param capacity is the maximum number of transitions
+  @param height, width, depth are the shape of the stacked observations (HWC, uint8)
+  @param seed initialises the generator used for sampling
+*/
+  ReplayBuffer(size_t capacity, int height, int width, int depth, uint64_t seed = 0);
+  ~ReplayBuffer();
+
+/*
+  Add a transition, overwriting the oldest one when the buffer is full
+
+  @param image_t, image_t1 are height x width x depth observations
+  @return true, as every transition can be stored (same interface of FrameReplayBuffer)
+*/
+  bool add(const uint8_t *image_t, int32_t action, float reward, const uint8_t *image_t1, bool done);
+
+/*
+  Draw distinct positions uniformly, in O(1) per position when batch_size is small wrt the size
+
+  @param positions receives batch_size positions (0 is the oldest transition)
+  @return false if batch_size is larger than the number of transitions stored
+*/
+  bool sampleIndices(size_t batch_size, size_t *positions);
+
+/*
+  Copy the transitions at the given positions in the caller's buffers
+
+  @param images_t, images_t1 receive count * getObservationSize() bytes
+  @param actions, rewards, dones receive count elements
+*/
+  void gather(const size_t *positions, size_t count, uint8_t *images_t, int32_t *actions, float *rewards,
+              uint8_t *images_t1, uint8_t *dones) const;
+
+/*
+  Uniform sampling without replacement into the caller's buffers (see gather)
+
+  @return false if batch_size is larger than the number of transitions stored
+*/
+  bool sample(size_t batch_size, uint8_t *images_t, int32_t *actions, float *rewards, uint8_t *images_t1,
+              uint8_t *dones);
+
+/*
+  @param position of a stored transition (0 is the oldest)
+  @return the storage slot of the transition, in [0, capacity) and stable until it is overwritten
+*/
+  size_t getSlot(size_t position) const;
+
+  void seed(uint64_t seed);
+  void clear();
+
+  size_t getSize() const;
+  size_t getCapacity() const;
+  size_t getObservationSize() const;
+  int getHeight() const;
+  int getWidth() const;
+  int getDepth() const;
+/*
+  @return the bytes allocated for the storage
+*/
+  size_t getByteSize() const;
+};
+
+#endif
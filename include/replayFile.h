@@ -0,0 +1,232 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Chunked binary replay file, written append-only and read in place through mmap (no deserialisation).
+
+  Layout (little endian):
+    header    4096 bytes: magic "DRLRPF1", version, shape, chunk size, offsets of the columns, count of transitions
+    chunk[i]  the transitions [i * chunk_size, (i + 1) * chunk_size) as fixed-stride columns, each aligned to 64 bytes:
+              image_t (HWC uint8), image_t1 (HWC uint8), action (int32), reward (float32), done (uint8),
+              position (3 x float32, the UAV wrt the marker at t1, NaN when unknown)
+
+  Chunks are page aligned and allocated whole. The count in the header is updated only after the data of the
+  transitions it covers has been written, so a file left by a crash is valid up to the last commit.
+*/
+#ifndef REPLAY_FILE_H
+#define REPLAY_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <random>
+#include <string>
+#include <vector>
+
+class ReplayFile
+{
+public:
+  static const uint32_t VERSION = 1;
+  static const size_t HEADER_SIZE = 4096;
+
+  enum Column
+  {
+    IMAGES_T = 0,
+    IMAGES_T1,
+    ACTIONS,
+    REWARDS,
+    DONES,
+    POSITIONS,
+    NUM_COLUMNS
+  };
+
+  struct Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t height;
+    uint32_t width;
+    uint32_t depth;
+    uint32_t chunk_size;
+    // Free for the user of the file (e.g. how actions and images have to be decoded)
+    uint32_t user_flags;
+    uint64_t chunk_bytes;
+    uint64_t column_offsets[NUM_COLUMNS];
+    // Transitions committed, written last
+    uint64_t count;
+  };
+
+/*
+  @param chunk_size is the number of transitions of a chunk
+  @param column_offsets receives the offset of every column in a chunk
+  @return the bytes of a chunk, a multiple of the page size
+*/
+  static uint64_t layout(size_t observation_size, uint32_t chunk_size, uint64_t column_offsets[NUM_COLUMNS]);
+
+private:
+  int fd_;
+  uint8_t *memory_;
+  size_t size_;
+  const Header *header_;
+  bool writable_;
+  size_t count_;
+  size_t observation_size_;
+
+  std::mt19937_64 generator_;
+  std::vector<size_t> scratch_;
+
+  const uint8_t *column(Column column, size_t index, size_t stride) const;
+
+public:
+  ReplayFile();
+  ~ReplayFile();
+
+/*
+  Map a replay file, the transitions committed at this time are available
+
+  @param seed initialises the generator used for sampling
+  @param writable maps the file for rewriting transitions in place (see getMutableChunkColumn), it must not be
+  written by a ReplayFileWriter at the same time
+  @return false if the file cannot be mapped or it is not a valid replay file
+*/
+  bool open(const std::string &path, uint64_t seed = 0, bool writable = false);
+  void close();
+  bool isOpen() const;
+
+  const uint8_t *getImageT(size_t index) const;
+  const uint8_t *getImageT1(size_t index) const;
+  int32_t getAction(size_t index) const;
+  float getReward(size_t index) const;
+  bool getDone(size_t index) const;
+  const float *getPosition(size_t index) const;
+
+/*
+  Base of a column in a chunk, the transitions of the chunk are consecutive with a fixed stride
+
+  @return NULL if the chunk does not exist
+*/
+  const uint8_t *getChunkColumn(size_t chunk, Column column) const;
+
+/*
+  As getChunkColumn, for a file opened writable
+
+  @return NULL if the chunk does not exist or the file is read-only
+*/
+  uint8_t *getMutableChunkColumn(size_t chunk, Column column);
+
+/*
+  Flush what has been rewritten in place to disk
+*/
+  bool sync();
+
+/*
+  Hints for streaming a file larger than the memory: the chunks [begin, end) are read soon (read-ahead), or they
+  are not needed any more and their pages are dropped from the mapping
+*/
+  void prefetchChunks(size_t begin, size_t end) const;
+  void releaseChunks(size_t begin, size_t end) const;
+
+/*
+  Copy the transitions at the given indices in the caller's buffers
+
+  @param images_t, images_t1 receive count * getObservationSize() bytes
+  @param actions, rewards, dones receive count elements
+  @param positions if not NULL receives 3 * count elements
+*/
+  void gather(const size_t *indices, size_t count, uint8_t *images_t, int32_t *actions, float *rewards,
+              uint8_t *images_t1, uint8_t *dones, float *positions = NULL) const;
+
+/*
+  Uniform sampling without replacement into the caller's buffers (see gather)
+
+  @return false if batch_size is larger than the number of transitions
+*/
+  bool sample(size_t batch_size, uint8_t *images_t, int32_t *actions, float *rewards, uint8_t *images_t1,
+              uint8_t *dones, float *positions = NULL);
+
+  void seed(uint64_t seed);
+
+  size_t getSize() const;
+  size_t getChunkSize() const;
+  size_t getNumChunks() const;
+  size_t getObservationSize() const;
+  int getHeight() const;
+  int getWidth() const;
+  int getDepth() const;
+  uint32_t getUserFlags() const;
+};
+
+class ReplayFileWriter
+{
+private:
+  int fd_;
+  ReplayFile::Header *header_;
+  // Chunk being written and its mapping
+  uint8_t *chunk_;
+  void *chunk_base_;
+  size_t chunk_mapped_;
+  size_t chunk_index_;
+  uint64_t count_;
+  size_t observation_size_;
+
+  bool mapChunk(size_t chunk);
+  void unmapChunk();
+
+public:
+  ReplayFileWriter();
+  ~ReplayFileWriter();
+
+/*
+  Create a replay file or continue an existing one with the same shape
+
+  @param height, width, depth are the shape of the observations (HWC, uint8)
+  @param chunk_size is the number of transitions of a chunk, ignored when the file exists
+  @param truncate discards the transitions of an existing file
+  @return false if the file cannot be created or it exists with a different shape
+*/
+  bool open(const std::string &path, int height, int width, int depth, uint32_t chunk_size = 1024,
+            bool truncate = false);
+
+/*
+  Commit the transitions appended and close the file
+*/
+  void close();
+  bool isOpen() const;
+
+/*
+  Append a transition, it is committed when its chunk is complete or at the next commit
+
+  @param image_t, image_t1 are height x width x depth observations
+  @param position is x, y, z of the UAV wrt the marker at t1, NULL if unknown
+  @return false if the file cannot grow
+*/
+  bool append(const uint8_t *image_t, int32_t action, float reward, const uint8_t *image_t1, bool done,
+              const float *position = NULL);
+
+/*
+  Append count transitions stored contiguously, as filled by ReplayFile::gather
+
+  @param positions is 3 * count elements, NULL if unknown
+  @return false if the file cannot grow
+*/
+  bool appendBatch(const uint8_t *images_t, const int32_t *actions, const float *rewards, const uint8_t *images_t1,
+                   const uint8_t *dones, const float *positions, size_t count);
+
+/*
+  Make the transitions appended so far visible in the header
+
+  @param sync also waits for the data to reach the disk
+*/
+  void commit(bool sync = false);
+
+  void setUserFlags(uint32_t user_flags);
+  uint32_t getUserFlags() const;
+  size_t getSize() const;
+  size_t getObservationSize() const;
+};
+
+#endif
@@ -0,0 +1,88 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Episode reset without spawning or deleting models: every ground variant (model <name>_plane) is spawned once and
+  parked below the world, a reset moves the chosen one in view and the previous one out, then places the UAV.
+  All the model states of a reset go through one persistent SetModelState connection, back to back.
+*/
+#ifndef RESET_MANAGER_H
+#define RESET_MANAGER_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "gazebo_msgs/ModelState.h"
+#include "ros/ros.h"
+#include "spawnSampler.h"
+
+// Ground choices of ResetManager::reset besides the indices of the grounds
+const int GROUND_RANDOM = -1;
+const int GROUND_KEEP = -2;
+
+class ResetManager
+{
+private:
+  ros::ServiceClient set_state_client_;
+
+  // Ground variants, the one in view (-1 if none) and the altitude of the parked ones
+  std::vector<std::string> grounds_;
+  int current_;
+  double park_z_;
+  Xoshiro256 generator_;
+
+  // Wall time of the resets [s]
+  double last_latency_, total_latency_, max_latency_;
+  unsigned long resets_;
+  std::mutex mutex_;
+
+  static std::string modelName(const std::string &ground);
+  gazebo_msgs::ModelState groundState(int ground, bool in_view) const;
+  // Set the states in order until one fails, return how many have been set
+  size_t apply(const std::vector<gazebo_msgs::ModelState> &states);
+
+public:
+  ResetManager();
+
+/*
+  Open the persistent SetModelState client and preload the grounds: those not in the world yet are spawned from
+  <model_path>/<name>/model.sdf, then all of them are parked and a random one is moved in view.
+
+  @param nh is the node handle used for the Gazebo services
+  @param grounds are the names of the ground variants (e.g. sand1, snow2), none to only reset the UAV
+  @param model_path is the directory of the Gazebo models (~ is expanded)
+  @param park_depth is how far below the world the grounds out of view are kept
+  @param seed makes the random choices of the grounds reproducible
+  @return false if a ground could not be spawned (the others are still used)
+*/
+  bool init(ros::NodeHandle &nh, const std::vector<std::string> &grounds, const std::string &model_path,
+            double park_depth, uint64_t seed);
+
+/*
+  Show a ground variant and place the UAV, timing the whole operation
+
+  @param quadrotor is the new state of the UAV (pose and twist)
+  @param ground is the index of the ground, GROUND_RANDOM or GROUND_KEEP
+  @return false if a model state could not be set. If the old ground could not be parked the new one is parked
+  again, the ground in view is still the old one
+*/
+  bool reset(const gazebo_msgs::ModelState &quadrotor, int ground);
+
+/*
+  @return the name of the ground in view, empty if none
+*/
+  std::string getGround();
+  size_t getNumGrounds();
+
+  double getLastLatency();
+  double getMeanLatency();
+  double getMaxLatency();
+  unsigned long getResets();
+};
+
+#endif
@@ -0,0 +1,127 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Reward and done of the UAV given its position, the landing/flight boxes around the marker and the action taken.
+  The policy is chosen at run time (parameter /drl_node/reward_policy); each one is an evaluator bound once to a
+  function pointer, which allocates nothing and takes the actions as ActionId. It is the only implementation of
+  the rewards: it replaces BoundingBox and the Utilities::assignReward* functions of the training scripts, named
+  below.
+
+    flight_box        1 inside the landing box, -1 outside the flight box (both done), step reward otherwise
+                      (assignReward)
+    landing_box       1 inside the landing box (done), step reward otherwise (assignRewardWithoutFlightBB)
+    landing_altitude  at the altitude of the landing box 1 if inside it and -1 otherwise (both done), step reward
+                      otherwise; flags the wrong altitudes between the levels reached by descend
+                      (assignRewardWithoutFlightBB with the action)
+    land_action       with the land action 1 inside the landing box and -1 otherwise, -1 at or below the minimum
+                      altitude above the marker (all done), step reward otherwise (assignRewardWhenLanding, which
+                      took the altitude in the world)
+
+  The same policies relabel recorded transitions in batches (see relabel()).
+*/
+#ifndef REWARD_ENGINE_H
+#define REWARD_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+enum RewardPolicy
+{
+  REWARD_FLIGHT_BOX = 0,
+  REWARD_LANDING_BOX,
+  REWARD_LANDING_ALTITUDE,
+  REWARD_LAND_ACTION,
+  NUM_REWARD_POLICIES
+};
+
+// Extents of an axis-aligned box
+struct RewardBox
+{
+  double min_x, max_x, min_y, max_y, min_z, max_z;
+};
+
+struct RewardConfig
+{
+  RewardPolicy policy;
+  // Boxes centred on the marker in x and y, from its altitude up to the height
+  double landing_half_size, landing_height;
+  double flight_half_size, flight_height;
+  float step_reward, success_reward, failure_reward;
+  // Altitude above the marker at or below which the episode fails (land_action), online and in relabel()
+  double min_altitude;
+
+  RewardConfig();
+};
+
+struct RewardOutcome
+{
+  float reward;
+  bool done;
+  bool wrong_altitude;
+};
+
+class RewardEngine
+{
+public:
+  typedef void (*Evaluator)(const RewardEngine &engine, double x, double y, double z, int32_t action,
+                            RewardOutcome *outcome);
+
+private:
+  RewardConfig config_;
+  RewardBox landing_, flight_;
+  Evaluator evaluator_;
+
+public:
+  explicit RewardEngine(const RewardConfig &config = RewardConfig());
+
+/*
+  Place the boxes around the marker
+*/
+  void setMarker(double x, double y, double z);
+
+/*
+  @param x, y, z is the position of the UAV in the frame of the marker given to setMarker
+  @param action is the ActionId of the last action
+*/
+  void evaluate(double x, double y, double z, int32_t action, RewardOutcome *outcome) const
+  {
+    evaluator_(*this, x, y, z, action, outcome);
+  }
+
+/*
+  Recompute reward and done of recorded transitions, in blocks evaluated without branches. The boxes are placed
+  around the origin (the marker) and the minimum altitude is wrt the marker, as in evaluate(): the same config gives
+  the rewards and dones given online.
+
+  @param positions are 3 * count floats, the UAV wrt the marker at t1 (as in replay files). The transitions whose
+  position is unknown (NaN) keep their reward and done
+  @param actions, rewards, dones are count elements, rewards and dones are overwritten
+  @return the number of transitions relabelled
+*/
+  size_t relabel(const float *positions, const int32_t *actions, size_t count, float *rewards, uint8_t *dones) const;
+
+/*
+  @return true if the altitude is between two of the levels reached by descend (table lookup)
+*/
+  static bool isWrongAltitude(double z);
+
+  const RewardConfig &getConfig() const;
+  const RewardBox &getLandingBox() const;
+  const RewardBox &getFlightBox() const;
+};
+
+/*
+  @param name is flight_box, landing_box, landing_altitude or land_action
+  @return false if the name is not a policy
+*/
+bool parseRewardPolicy(const std::string &name, RewardPolicy *policy);
+const char *rewardPolicyName(RewardPolicy policy);
+
+#endif
@@ -0,0 +1,109 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  POSIX shared-memory ring publishing the observation of every tick (frame stack, pose wrt the marker, reward and
+  done) to readers on the same host, without serialization.
+
+  Layout (little endian, every block aligned to 64 bytes):
+    header    magic "DRLSHM1", version, slots, height, width, depth, slot size, count of published ticks
+    slot[i]   sequence, tick, stamp, reward, done, wrong altitude, pose (x y z qx qy qz qw), frame stack
+
+  Every slot is a seqlock: the sequence is odd while the writer fills it and becomes 2 * (n + 1) once the n-th
+  observation has been published in it. A reader takes the slot of the last published observation, reads the
+  sequence, uses the data and checks that the sequence did not change. The ring gives readers slots - 1 ticks before
+  the data they are looking at is overwritten.
+*/
+#ifndef SHARED_MEMORY_CHANNEL_H
+#define SHARED_MEMORY_CHANNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class SharedMemoryChannel
+{
+public:
+  static const uint32_t VERSION = 1;
+
+  struct Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t slots;
+    uint32_t height;
+    uint32_t width;
+    uint32_t depth;
+    uint32_t slot_size;
+    // Number of observations published so far, the latest lives in slot (published - 1) % slots
+    uint64_t published;
+    uint8_t reserved[24];
+  };
+
+  struct Slot
+  {
+    uint64_t sequence;
+    uint64_t tick;
+    double stamp;
+    float reward;
+    uint8_t done;
+    uint8_t wrong_altitude;
+    uint8_t reserved[2];
+    double pose[7];
+    uint8_t padding[40];
+    // followed by height * width * depth bytes of frame stack (HWC)
+  };
+
+private:
+  std::string name_;
+  int fd_;
+  void *memory_;
+  size_t size_;
+  Header *header_;
+  uint32_t frame_size_;
+  Slot *writing_;
+
+  Slot *slot(uint64_t index);
+
+public:
+  SharedMemoryChannel();
+  ~SharedMemoryChannel();
+
+/*
+  Create (or replace) the shared-memory object and initialise the ring
+
+  @param name is the POSIX name of the object, e.g. "/drl_observation"
+  @param height, width, depth are the shape of the frame stack
+  @param slots is the length of the ring
+  @return false if the object cannot be created or mapped
+*/
+  bool open(const std::string &name, int height, int width, int depth, int slots);
+
+/*
+  Unmap and unlink the object
+*/
+  void close();
+
+  bool isOpen() const;
+
+/*
+  Start publishing a new observation, readers of the slot being overwritten will fail their check
+
+  @return the buffer where the height x width x depth frame stack has to be written
+*/
+  uint8_t *beginWrite();
+
+/*
+  Complete the observation started by beginWrite and make it the latest one
+
+  @param pose is x, y, z, qx, qy, qz, qw of the UAV wrt the marker
+*/
+  void endWrite(uint64_t tick, double stamp, float reward, bool done, bool wrong_altitude, const double pose[7]);
+};
+
+#endif
@@ -0,0 +1,144 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Latest value of a state written by one thread and read by any number of threads without locks: a trivially
+  copyable value plus an optional block of bytes of fixed size (e.g. a frame), double buffered.
+
+  Each of the two slots is a seqlock (the same protocol as SharedMemoryChannel): its sequence is odd while the writer
+  fills it. The writer always fills the slot which is not the latest, so it never waits; a reader copies the latest
+  slot and checks that its sequence did not change, retrying only if the writer has published twice meanwhile.
+*/
+#ifndef SNAPSHOT_BUFFER_H
+#define SNAPSHOT_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+class SnapshotBuffer
+{
+  static_assert(std::is_trivially_copyable<T>::value, "snapshots are copied while they may be overwritten");
+
+private:
+  struct alignas(64) Slot
+  {
+    uint64_t sequence;
+    T value;
+  };
+
+  Slot slots_[2];
+  std::vector<uint8_t> payloads_[2];
+  size_t payload_size_;
+  // Number of snapshots published, the latest lives in slot (published - 1) % 2
+  alignas(64) uint64_t published_;
+
+public:
+/*
+  @param payload_size is the size of the block of bytes published with every value
+*/
+  explicit SnapshotBuffer(size_t payload_size = 0)
+  {
+    init(payload_size);
+  }
+
+  SnapshotBuffer(const SnapshotBuffer &other) = delete;
+  SnapshotBuffer &operator=(const SnapshotBuffer &other) = delete;
+
+/*
+  Discard the snapshots and change the size of the block, only while there are no readers
+*/
+  void init(size_t payload_size)
+  {
+    for (int i = 0; i < 2; i++)
+    {
+      slots_[i].sequence = 0;
+      slots_[i].value = T();
+      payloads_[i].assign(std::max<size_t>(payload_size, 1), 0);
+    }
+    payload_size_ = payload_size;
+    published_ = 0;
+  }
+
+/*
+  Publish a new snapshot (writer thread only)
+
+  @param payload is a block of getPayloadSize() bytes, NULL keeps the block of the previous snapshot
+*/
+  void write(const T &value, const uint8_t *payload = NULL)
+  {
+    const uint64_t published = published_;
+    Slot &slot = slots_[published & 1];
+    const uint64_t sequence = slot.sequence;
+
+    // Odd sequence: the slot is being written
+    __atomic_store_n(&slot.sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&slot.value, &value, sizeof(T));
+    // The writer is the only one modifying the slots, it can read the other one as it is
+    memcpy(&payloads_[published & 1][0], payload != NULL ? payload : &payloads_[(published + 1) & 1][0],
+           payload_size_);
+    __atomic_store_n(&slot.sequence, sequence + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&published_, published + 1, __ATOMIC_RELEASE);
+  }
+
+/*
+  Copy the latest snapshot (any thread)
+
+  @param value is filled with the value, if not NULL
+  @param payload is filled with the first payload_size bytes of the block, if not NULL
+  @return false if nothing has been published yet
+*/
+  bool read(T *value, uint8_t *payload = NULL, size_t payload_size = 0) const
+  {
+    payload_size = std::min(payload_size, payload_size_);
+    for (;;)
+    {
+      const uint64_t published = __atomic_load_n(&published_, __ATOMIC_ACQUIRE);
+      if (published == 0)
+      {
+        return false;
+      }
+      const Slot &slot = slots_[(published - 1) & 1];
+      const uint64_t sequence = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+      if (sequence & 1)
+      {
+        continue;
+      }
+      if (value != NULL)
+      {
+        memcpy(value, &slot.value, sizeof(T));
+      }
+      if (payload != NULL && payload_size > 0)
+      {
+        memcpy(payload, &payloads_[(published - 1) & 1][0], payload_size);
+      }
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) == sequence)
+      {
+        return true;
+      }
+    }
+  }
+
+  size_t getPayloadSize() const
+  {
+    return payload_size_;
+  }
+
+  uint64_t getPublished() const
+  {
+    return __atomic_load_n(&published_, __ATOMIC_ACQUIRE);
+  }
+};
+
+#endif
@@ -0,0 +1,148 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Poses at which the UAV is respawned at the beginning of an episode, drawn from a long-lived xoshiro256** stream.
+  The same seed gives the same spawns; environments sharing a seed use different streams, 2^128 draws apart.
+*/
+#ifndef SPAWN_SAMPLER_H
+#define SPAWN_SAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+  xoshiro256** (Blackman and Vigna), a UniformRandomBitGenerator of 32 bytes of state
+*/
+class Xoshiro256
+{
+private:
+  uint64_t state_[4];
+
+  static uint64_t rotl(uint64_t x, int k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+
+public:
+  typedef uint64_t result_type;
+
+  explicit Xoshiro256(uint64_t seed = 0)
+  {
+    this->seed(seed);
+  }
+
+/*
+  Expand the seed into the state with splitmix64
+*/
+  void seed(uint64_t seed);
+
+/*
+  Advance by 2^128 draws, the start of the next non-overlapping stream
+*/
+  void jump();
+
+  uint64_t operator()()
+  {
+    const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+    const uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 45);
+    return result;
+  }
+
+  static constexpr uint64_t min()
+  {
+    return 0;
+  }
+  static constexpr uint64_t max()
+  {
+    return UINT64_MAX;
+  }
+};
+
+struct SpawnConfig
+{
+  // x and y wrt the marker: gaussian (mean and stdev on each axis) or uniform within +-xy_half_size
+  bool xy_gaussian;
+  double xy_mean, xy_stdev;
+  double xy_half_size;
+  // Altitude uniform in [z_from, z_to] or, with two bands, half of the times in [z_from_2, z_to_2]
+  int z_bands;
+  double z_from, z_to;
+  double z_from_2, z_to_2;
+
+  SpawnConfig();
+
+/*
+  Check that the distributions can be drawn from
+
+  @param error is set to the reason, if not NULL
+  @return false if a value is out of range (e.g. a negative stdev or an empty band)
+*/
+  bool validate(std::string *error) const;
+};
+
+struct Spawn
+{
+  double x, y, z;
+  // Uniform in [-pi, pi), roll and pitch are zero
+  double yaw;
+};
+
+class SpawnSampler
+{
+private:
+  SpawnConfig config_;
+  Xoshiro256 generator_;
+  std::normal_distribution<double> xy_gaussian_;
+  std::uniform_real_distribution<double> xy_uniform_, z_uniform_, z_uniform_2_, yaw_uniform_;
+  std::bernoulli_distribution second_band_;
+
+  // Spawns drawn ahead, served from next_
+  std::vector<Spawn> batch_;
+  size_t next_;
+  size_t batch_size_;
+
+public:
+/*
+  @param stream selects one of the independent streams of the seed (e.g. the index of the environment)
+  @param batch_size spawns are drawn this many at a time ahead of the resets (0 draws each one when needed); the
+  sequence does not depend on it
+*/
+  explicit SpawnSampler(const SpawnConfig &config = SpawnConfig(), uint64_t seed = 0, uint64_t stream = 0,
+                        size_t batch_size = 0);
+
+/*
+  Restart the sequence, the spawns drawn ahead are discarded
+*/
+  void seed(uint64_t seed, uint64_t stream = 0);
+
+/*
+  Change the distributions, the stream goes on and the spawns drawn ahead are discarded
+*/
+  void setConfig(const SpawnConfig &config);
+
+  Spawn next();
+
+/*
+  Draw the next count spawns of the sequence at once
+*/
+  void sample(Spawn *spawns, size_t count);
+
+  const SpawnConfig &getConfig() const;
+};
+
+#endif
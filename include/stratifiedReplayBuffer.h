@@ -0,0 +1,111 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Experience replay buffer partitioned by reward class (positive, neutral, negative) over a single allocation.
+  Every class is a FIFO over its own range of slots with its own capacity, so the rare landing transitions are not
+  evicted by the far more frequent neutral ones. Sampling takes a mix of the classes in a single call.
+*/
+#ifndef STRATIFIED_REPLAY_BUFFER_H
+#define STRATIFIED_REPLAY_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <random>
+#include <vector>
+
+class StratifiedReplayBuffer
+{
+public:
+  enum RewardClass
+  {
+    POSITIVE = 0,
+    NEUTRAL = 1,
+    NEGATIVE = 2,
+    NUM_CLASSES = 3
+  };
+
+private:
+  size_t observation_size_;
+  int height_, width_, depth_;
+
+  // Slots [offset_[c], offset_[c] + capacity_[c]) belong to class c
+  size_t capacity_[NUM_CLASSES];
+  size_t offset_[NUM_CLASSES];
+  size_t next_[NUM_CLASSES];
+  size_t count_[NUM_CLASSES];
+
+  std::vector<uint8_t> images_t_;
+  std::vector<int32_t> actions_;
+  std::vector<float> rewards_;
+  std::vector<uint8_t> images_t1_;
+  std::vector<uint8_t> dones_;
+
+  std::mt19937_64 generator_;
+  std::vector<size_t> scratch_;
+
+public:
+/*
+  @param capacities are the maximum numbers of positive, neutral and negative transitions
+  @param height, width, depth are the shape of the stacked observations (HWC, uint8)
+  @param seed initialises the generator used for sampling
+*/
+  StratifiedReplayBuffer(const size_t capacities[NUM_CLASSES], int height, int width, int depth, uint64_t seed = 0);
+  ~StratifiedReplayBuffer();
+
+/*
+  @return the class of a reward: positive above 0, negative at -1 or below, neutral otherwise
+*/
+  static RewardClass classify(float reward);
+
+/*
+  Add a transition to its class, overwriting the oldest one of the class when it is full
+
+  @return true (same interface of ReplayBuffer)
+*/
+  bool add(const uint8_t *image_t, int32_t action, float reward, const uint8_t *image_t1, bool done);
+
+/*
+  Sample a batch with a given proportion of each class, the transitions of a class are drawn without replacement
+  when the class holds enough of them and with replacement otherwise. The share of an empty class goes to the other
+  classes. The batch is ordered by class.
+
+  @param mix are the proportions of positive, neutral and negative transitions (normalised)
+  @param counts if not NULL receives the number of transitions drawn from each class
+  @return false if the buffer is empty
+*/
+  bool sample(size_t batch_size, const double mix[NUM_CLASSES], uint8_t *images_t, int32_t *actions, float *rewards,
+              uint8_t *images_t1, uint8_t *dones, size_t *counts = NULL);
+
+/*
+  @param position orders all the transitions: positives, neutrals and then negatives, each from the oldest
+  @return the slot of the transition
+*/
+  size_t getSlot(size_t position) const;
+
+/*
+  Copy the transitions in the given slots in the caller's buffers
+*/
+  void gather(const size_t *slots, size_t count, uint8_t *images_t, int32_t *actions, float *rewards,
+              uint8_t *images_t1, uint8_t *dones) const;
+
+  void seed(uint64_t seed);
+  void clear();
+
+  size_t getCount(RewardClass reward_class) const;
+  size_t getClassCapacity(RewardClass reward_class) const;
+  size_t getSize() const;
+  size_t getCapacity() const;
+  size_t getObservationSize() const;
+  int getHeight() const;
+  int getWidth() const;
+  int getDepth() const;
+  size_t getByteSize() const;
+};
+
+#endif
@@ -0,0 +1,143 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Timeline of the spans of a node written as Chrome trace events (JSON), which chrome://tracing and Perfetto open.
+  Every thread records into a ring of its own, created at its first event: recording is a few stores and a release,
+  without locks nor allocation, and the span names are string literals which are not copied. A writer thread drains
+  the rings into the file in the same way as TransitionRecorder; when it falls behind, the new events are dropped.
+  While the recorder is closed, recording costs one load.
+*/
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TraceRecorder
+{
+private:
+  struct Event
+  {
+    // String literal
+    const char *name;
+    // Span [begin, end] or instant event (end < 0) [ns]
+    int64_t begin, end;
+    uint64_t arg;
+  };
+
+  // Events of a thread. head is written by the writer thread only, tail by the recording thread only
+  struct Ring
+  {
+    std::vector<Event> events;
+    long tid;
+    std::atomic<uint64_t> head;
+    // head and tail on their own cache lines (the rings are allocated one by one, without over-alignment)
+    char padding[64];
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+  };
+
+  FILE *file_;
+  bool first_event_;
+  // now() at the opening, the origin of the timestamps
+  int64_t origin_;
+  // Rings of the threads which have recorded since the opening, drained by the writer thread
+  std::vector<std::unique_ptr<Ring>> rings_;
+  // Rings of the previous openings: a thread which was recording during close() may still hold one, so they are
+  // freed only with the recorder
+  std::vector<std::unique_ptr<Ring>> retired_rings_;
+  std::mutex rings_mutex_;
+  std::atomic<size_t> ring_size_;
+  // Identifies the rings of this opening in the caches of the threads, read by them without the lock
+  std::atomic<uint64_t> generation_;
+  std::atomic<bool> enabled_;
+  std::atomic<uint64_t> written_;
+  std::atomic<bool> stop_;
+  std::thread thread_;
+
+  Ring *ring();
+  void push(const char *name, int64_t begin, int64_t end, uint64_t arg);
+  // Write the events recorded so far, true if there were any
+  bool drain();
+  void write();
+
+public:
+  TraceRecorder();
+  ~TraceRecorder();
+
+  TraceRecorder(const TraceRecorder &other) = delete;
+  TraceRecorder &operator=(const TraceRecorder &other) = delete;
+
+/*
+  Create the trace file and start the writer thread
+
+  @param ring_size is the number of events a thread can record while the writer is busy
+  @return false if the file cannot be created
+*/
+  bool open(const std::string &path, size_t ring_size = 4096);
+
+/*
+  Write the events still in the rings, terminate the file and stop the writer thread. The events of the threads
+  still recording are lost (stop the spinners first to keep them), their rings stay valid until the destruction.
+*/
+  void close();
+
+  bool isOpen() const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+/*
+  @return the time of a monotonic clock [ns], the time base of the events
+*/
+  static int64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+/*
+  Record a span of the calling thread
+
+  @param name is a string literal, shown as is
+  @param begin, end are values of now()
+  @param arg is shown with the span (e.g. the step or the tick)
+*/
+  void span(const char *name, int64_t begin, int64_t end, uint64_t arg = 0)
+  {
+    if (isOpen())
+    {
+      push(name, begin, end, arg);
+    }
+  }
+
+/*
+  Record an instant event of the calling thread, now
+*/
+  void instant(const char *name, uint64_t arg = 0)
+  {
+    if (isOpen())
+    {
+      push(name, now(), -1, arg);
+    }
+  }
+
+  uint64_t getWritten() const;
+  uint64_t getDropped();
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Records the transitions observed by a node in a replay file (see replayFile.h) without blocking its loop: the
+  transitions are built in place in a preallocated single-producer single-consumer ring, which a writer thread
+  drains into the file. When the writer falls behind, the ring fills up and the new transitions are dropped.
+
+  The producer side (beginRecord, getImageT, ..., endRecord) must be used by a single thread.
+*/
+#ifndef TRANSITION_RECORDER_H
+#define TRANSITION_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "replayFile.h"
+
+class TransitionRecorder
+{
+public:
+  struct Record
+  {
+    uint8_t *image_t;
+    uint8_t *image_t1;
+    int32_t action;
+    float reward;
+    bool done;
+    // The UAV wrt the marker at t1
+    float position[3];
+  };
+
+private:
+  ReplayFileWriter writer_;
+  size_t observation_size_;
+
+  // Ring of records, slot i uses the images i of images_. head_ is written by the writer thread only, tail_ by the
+  // producer only; each one is padded to its own cache line
+  std::vector<Record> records_;
+  std::vector<uint8_t> images_;
+  alignas(64) std::atomic<uint64_t> head_;
+  std::atomic<uint64_t> written_;
+  alignas(64) std::atomic<uint64_t> tail_;
+  // Transitions lost because the ring was full or the file could not grow
+  alignas(64) std::atomic<uint64_t> dropped_;
+  std::atomic<bool> stop_;
+  // Slot filled by the producer between beginRecord and endRecord, NULL if none
+  Record *open_;
+
+  std::thread thread_;
+  void write();
+
+public:
+  TransitionRecorder();
+  ~TransitionRecorder();
+
+/*
+  Create the replay file (or continue it) and start the writer thread
+
+  @param height, width, depth are the shape of the observations (HWC, uint8)
+  @param slots is the number of transitions the ring can hold while the writer is busy
+  @param user_flags are stored in the file (e.g. REPLAY_FLAG_ACTION_IDS)
+  @return false if the file cannot be created or it exists with a different shape
+*/
+  bool open(const std::string &path, int height, int width, int depth, size_t slots = 256, uint32_t user_flags = 0);
+
+/*
+  Write the transitions still in the ring, flush the file to disk and stop the writer thread
+*/
+  void close();
+  bool isOpen() const;
+
+/*
+  Take the next slot of the ring, whose image_t and image_t1 are getObservationSize() bytes to be filled. While a slot
+  is taken and not ended it is returned again.
+
+  @return NULL if the ring is full (the transition is dropped) or the recorder is not open
+*/
+  Record *beginRecord();
+
+/*
+  Hand the slot taken by beginRecord to the writer thread
+*/
+  void endRecord();
+
+/*
+  Forget the slot taken by beginRecord
+*/
+  void cancelRecord();
+
+  size_t getObservationSize() const;
+  uint64_t getRecorded() const;
+  uint64_t getDropped() const;
+};
+
+#endif
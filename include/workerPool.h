@@ -0,0 +1,62 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Persistent threads splitting a range of work items, the calling thread takes part in the work.
+*/
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+public:
+  typedef std::function<void(size_t begin, size_t end, int worker)> Job;
+
+private:
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_cond_, done_cond_;
+  // Serialises the calls to run
+  std::mutex run_mutex_;
+
+  const Job *job_;
+  size_t count_;
+  uint64_t generation_;
+  int pending_;
+  bool stop_;
+
+  void range(int worker, size_t *begin, size_t *end) const;
+  void work(int worker);
+
+public:
+/*
+  @param workers is the number of threads working on a job, including the caller (0 for one per core)
+*/
+  explicit WorkerPool(int workers = 0);
+  ~WorkerPool();
+
+/*
+  Split [0, count) in contiguous ranges, one per worker, and wait for all of them
+
+  @param job is called with its range and the index of the worker in [0, getSize())
+  @param min_per_worker is the smallest range worth a thread, smaller jobs run on the calling thread alone
+*/
+  void run(size_t count, const Job &job, size_t min_per_worker = 1);
+
+  int getSize() const;
+};
+
+#endif
@@ -0,0 +1,237 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Landing pads of a world with many markers, indexed by a uniform grid.
+*/
+
+#include "../include/landingPads.h"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+namespace
+{
+// Cells beyond this index are merged with the last one (coordinates out of any world)
+const int32_t CELL_LIMIT = 1 << 30;
+}
+
+LandingPads::LandingPads(const RewardConfig &config)
+{
+  landing_half_size_ = config.landing_half_size;
+  landing_height_ = config.landing_height;
+  cell_size_ = std::max(2.0 * landing_half_size_, 1e-3);
+  min_cell_x_ = min_cell_y_ = CELL_LIMIT;
+  max_cell_x_ = max_cell_y_ = -CELL_LIMIT;
+}
+
+void LandingPads::rebuild()
+{
+  // About one pad per cell over the area of the pads, never smaller than a landing box
+  const double width = *std::max_element(marker_x_.begin(), marker_x_.end()) -
+                       *std::min_element(marker_x_.begin(), marker_x_.end());
+  const double height = *std::max_element(marker_y_.begin(), marker_y_.end()) -
+                        *std::min_element(marker_y_.begin(), marker_y_.end());
+  cell_size_ = std::max(std::max(2.0 * landing_half_size_, 1e-3), sqrt(width * height / marker_x_.size()));
+  cells_.clear();
+  min_cell_x_ = min_cell_y_ = CELL_LIMIT;
+  max_cell_x_ = max_cell_y_ = -CELL_LIMIT;
+  for (size_t pad = 0; pad < marker_x_.size(); pad++)
+  {
+    insert(pad);
+  }
+}
+
+int32_t LandingPads::cellOf(double coordinate) const
+{
+  double cell = floor(coordinate / cell_size_);
+  if (!(cell > -CELL_LIMIT))
+  {
+    return -CELL_LIMIT;
+  }
+  return cell < CELL_LIMIT ? (int32_t)cell : CELL_LIMIT;
+}
+
+uint64_t LandingPads::key(int32_t cell_x, int32_t cell_y)
+{
+  return ((uint64_t)(uint32_t)cell_x << 32) | (uint32_t)cell_y;
+}
+
+void LandingPads::insert(int pad)
+{
+  const int32_t cell_x = cellOf(marker_x_[pad]), cell_y = cellOf(marker_y_[pad]);
+  cell_of_[pad] = key(cell_x, cell_y);
+  cells_[cell_of_[pad]].push_back(pad);
+  min_cell_x_ = std::min(min_cell_x_, cell_x);
+  max_cell_x_ = std::max(max_cell_x_, cell_x);
+  min_cell_y_ = std::min(min_cell_y_, cell_y);
+  max_cell_y_ = std::max(max_cell_y_, cell_y);
+}
+
+void LandingPads::remove(int pad)
+{
+  std::unordered_map<uint64_t, std::vector<int> >::iterator cell = cells_.find(cell_of_[pad]);
+  cell->second.erase(std::find(cell->second.begin(), cell->second.end(), pad));
+  if (cell->second.empty())
+  {
+    cells_.erase(cell);
+  }
+}
+
+int LandingPads::addPad(double x, double y, double z)
+{
+  const int pad = marker_x_.size();
+  marker_x_.push_back(x);
+  marker_y_.push_back(y);
+  marker_z_.push_back(z);
+  min_x_.push_back(x - landing_half_size_);
+  max_x_.push_back(x + landing_half_size_);
+  min_y_.push_back(y - landing_half_size_);
+  max_y_.push_back(y + landing_half_size_);
+  min_z_.push_back(z);
+  max_z_.push_back(z + landing_height_);
+  cell_of_.push_back(0);
+  // The cells are resized whenever the number of pads doubles
+  if ((marker_x_.size() & (marker_x_.size() - 1)) == 0)
+  {
+    rebuild();
+  }
+  else
+  {
+    insert(pad);
+  }
+  return pad;
+}
+
+void LandingPads::movePad(int pad, double x, double y, double z)
+{
+  if (marker_x_[pad] == x && marker_y_[pad] == y && marker_z_[pad] == z)
+  {
+    return;
+  }
+  remove(pad);
+  marker_x_[pad] = x;
+  marker_y_[pad] = y;
+  marker_z_[pad] = z;
+  min_x_[pad] = x - landing_half_size_;
+  max_x_[pad] = x + landing_half_size_;
+  min_y_[pad] = y - landing_half_size_;
+  max_y_[pad] = y + landing_half_size_;
+  min_z_[pad] = z;
+  max_z_[pad] = z + landing_height_;
+  insert(pad);
+}
+
+int LandingPads::containing(double x, double y, double z) const
+{
+  const int32_t cell_x = cellOf(x), cell_y = cellOf(y);
+  for (int32_t cx = std::max(cell_x - 1, min_cell_x_); cx <= std::min(cell_x + 1, max_cell_x_); cx++)
+  {
+    for (int32_t cy = std::max(cell_y - 1, min_cell_y_); cy <= std::min(cell_y + 1, max_cell_y_); cy++)
+    {
+      std::unordered_map<uint64_t, std::vector<int> >::const_iterator cell = cells_.find(key(cx, cy));
+      if (cell == cells_.end())
+      {
+        continue;
+      }
+      for (size_t i = 0; i < cell->second.size(); i++)
+      {
+        const int pad = cell->second[i];
+        if (x >= min_x_[pad] && x <= max_x_[pad] && y >= min_y_[pad] && y <= max_y_[pad] && z >= min_z_[pad] &&
+            z <= max_z_[pad])
+        {
+          return pad;
+        }
+      }
+    }
+  }
+  return -1;
+}
+
+int LandingPads::nearest(double x, double y) const
+{
+  if (cells_.empty())
+  {
+    return -1;
+  }
+  const int64_t cell_x = cellOf(x), cell_y = cellOf(y);
+  // Rings closer than the grid are empty, the farthest ring reaches its corners
+  const int64_t first = std::max<int64_t>(std::max<int64_t>(min_cell_x_ - cell_x, cell_x - max_cell_x_),
+                                          std::max<int64_t>(min_cell_y_ - cell_y, cell_y - max_cell_y_));
+  const int64_t last = std::max(std::max(cell_x - min_cell_x_, max_cell_x_ - cell_x),
+                                std::max(cell_y - min_cell_y_, max_cell_y_ - cell_y));
+
+  int best = -1;
+  double best_distance = std::numeric_limits<double>::infinity();
+  const auto visit = [&](int64_t cx, int64_t cy) {
+    std::unordered_map<uint64_t, std::vector<int> >::const_iterator cell = cells_.find(key(cx, cy));
+    if (cell == cells_.end())
+    {
+      return;
+    }
+    for (size_t i = 0; i < cell->second.size(); i++)
+    {
+      const int pad = cell->second[i];
+      const double dx = marker_x_[pad] - x, dy = marker_y_[pad] - y;
+      if (dx * dx + dy * dy < best_distance)
+      {
+        best_distance = dx * dx + dy * dy;
+        best = pad;
+      }
+    }
+  };
+  for (int64_t r = std::max<int64_t>(first, 0); r <= last; r++)
+  {
+    // Cells of the ring within the grid: top and bottom rows, then left and right columns
+    const int64_t from_x = std::max<int64_t>(cell_x - r, min_cell_x_);
+    const int64_t to_x = std::min<int64_t>(cell_x + r, max_cell_x_);
+    const int64_t from_y = std::max<int64_t>(cell_y - r + 1, min_cell_y_);
+    const int64_t to_y = std::min<int64_t>(cell_y + r - 1, max_cell_y_);
+    for (int64_t cx = from_x; cx <= to_x && cell_y - r >= min_cell_y_; cx++)
+    {
+      visit(cx, cell_y - r);
+    }
+    for (int64_t cx = from_x; cx <= to_x && r > 0 && cell_y + r <= max_cell_y_; cx++)
+    {
+      visit(cx, cell_y + r);
+    }
+    for (int64_t cy = from_y; cy <= to_y && cell_x - r >= min_cell_x_; cy++)
+    {
+      visit(cell_x - r, cy);
+    }
+    for (int64_t cy = from_y; cy <= to_y && cell_x + r <= max_cell_x_; cy++)
+    {
+      visit(cell_x + r, cy);
+    }
+    // The cells of the next rings are at least r cells away from the point
+    const double reach = r * cell_size_;
+    if (best >= 0 && best_distance <= reach * reach)
+    {
+      break;
+    }
+  }
+  return best;
+}
+
+void LandingPads::getMarker(int pad, double *x, double *y, double *z) const
+{
+  *x = marker_x_[pad];
+  *y = marker_y_[pad];
+  *z = marker_z_[pad];
+}
+
+RewardBox LandingPads::getLandingBox(int pad) const
+{
+  RewardBox box = { min_x_[pad], max_x_[pad], min_y_[pad], max_y_[pad], min_z_[pad], max_z_[pad] };
+  return box;
+}
+
+size_t LandingPads::getSize() const
+{
+  return marker_x_.size();
+}
@@ -0,0 +1,79 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Histogram of latencies with a bounded relative error.
+*/
+
+#include "../include/latencyHistogram.h"
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram()
+{
+  std::fill(counts_, counts_ + NUM_BUCKETS, 0);
+  count_ = total_ = max_ = 0;
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const
+{
+  // The total is summed again, count_ may be ahead of the buckets while a record is made
+  uint64_t counts[NUM_BUCKETS];
+  uint64_t count = 0;
+  for (int i = 0; i < NUM_BUCKETS; i++)
+  {
+    counts[i] = __atomic_load_n(&counts_[i], __ATOMIC_RELAXED);
+    count += counts[i];
+  }
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  const double rank = std::min(std::max(percentile, 0.0), 100.0) / 100.0 * count;
+  const uint64_t target = std::max<uint64_t>((uint64_t)(rank + 0.5), 1);
+  uint64_t seen = 0;
+  for (int i = 0; i < NUM_BUCKETS; i++)
+  {
+    seen += counts[i];
+    if (seen >= target)
+    {
+      // The middle of the bucket, but never more than the largest latency recorded
+      const uint64_t lowest = lowestOf(i);
+      const uint64_t width = i + 1 < NUM_BUCKETS ? lowestOf(i + 1) - lowest : 1;
+      return std::min(lowest + width / 2, std::max(getMax(), lowest));
+    }
+  }
+  return getMax();
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+  return __atomic_load_n(&count_, __ATOMIC_RELAXED);
+}
+
+uint64_t LatencyHistogram::getMax() const
+{
+  return __atomic_load_n(&max_, __ATOMIC_RELAXED);
+}
+
+double LatencyHistogram::getMean() const
+{
+  const uint64_t count = getCount();
+  return count > 0 ? (double)__atomic_load_n(&total_, __ATOMIC_RELAXED) / count : 0.0;
+}
+
+void LatencyHistogram::reset()
+{
+  for (int i = 0; i < NUM_BUCKETS; i++)
+  {
+    __atomic_store_n(&counts_[i], 0, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&count_, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&total_, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&max_, 0, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,105 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Table of the latest poses of all the models in the Gazebo world, fed by /gazebo/model_states.
+*/
+
+#include "../include/modelStateCache.h"
+#include "gazebo_msgs/GetModelState.h"
+
+ModelStateCache::ModelStateCache()
+{
+  updates_ = 0;
+}
+
+ModelStateCache::~ModelStateCache()
+{
+}
+
+void ModelStateCache::init(ros::NodeHandle &nh)
+{
+  // Only the latest message is relevant, older ones are dropped
+  model_states_sub_ = nh.subscribe("/gazebo/model_states", 1, &ModelStateCache::modelStatesCallback, this,
+                                   ros::TransportHints().tcpNoDelay());
+  get_state_client_ = nh.serviceClient<gazebo_msgs::GetModelState>("/gazebo/get_model_state", true);
+}
+
+void ModelStateCache::modelStatesCallback(const gazebo_msgs::ModelStates::ConstPtr &msg)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (msg->name != names_)
+  {
+    names_ = msg->name;
+    index_.clear();
+    for (size_t i = 0; i < names_.size(); i++)
+    {
+      index_[names_[i]] = i;
+      // The message now carries this model
+      fallback_poses_.erase(names_[i]);
+    }
+  }
+  poses_.assign(msg->pose.begin(), msg->pose.end());
+  updates_++;
+}
+
+bool ModelStateCache::getPose(const std::string &name, geometry_msgs::Pose &pose)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::map<std::string, size_t>::const_iterator it = index_.find(name);
+  if (it != index_.end() && it->second < poses_.size())
+  {
+    pose = poses_[it->second];
+    return true;
+  }
+  std::map<std::string, geometry_msgs::Pose>::const_iterator fallback = fallback_poses_.find(name);
+  if (fallback == fallback_poses_.end())
+  {
+    return false;
+  }
+  pose = fallback->second;
+  return true;
+}
+
+bool ModelStateCache::refresh(const std::string &name)
+{
+  gazebo_msgs::GetModelState srv;
+  srv.request.model_name = name;
+
+  // A persistent client drops the connection when the call fails, reopen it once
+  if (!get_state_client_.isValid())
+  {
+    ros::NodeHandle nh;
+    get_state_client_ = nh.serviceClient<gazebo_msgs::GetModelState>("/gazebo/get_model_state", true);
+  }
+  if (!get_state_client_.call(srv) || !srv.response.success)
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, size_t>::const_iterator it = index_.find(name);
+  if (it != index_.end() && it->second < poses_.size())
+  {
+    poses_[it->second] = srv.response.pose;
+  }
+  else
+  {
+    // Model not published yet, the table of the messages is left as is
+    fallback_poses_[name] = srv.response.pose;
+  }
+  return true;
+}
+
+unsigned long ModelStateCache::getUpdates()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return updates_;
+}
@@ -0,0 +1,432 @@
+#!/usr/bin/env python
+
+# The MIT License (MIT)
+# Copyright (c) 2017 Riccardo Polvara
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+# INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+# FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+# OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+#
+# Drop-in replacement of ExperienceReplayBuffer (experience_replay_buffer.py) backed by the
+# native buffer of the drl_replay module: preallocated contiguous arrays and O(1) sampling.
+#   from native_replay_buffer import ExperienceReplayBuffer
+# Actions given as strings are stored as their index in ACTION_LIST and returned as strings.
+# The buffers are saved as replay files (see include/replayFile.h), the pickles saved by the
+# Python buffer are still loaded and can be converted with convert_replay_buffer.py.
+
+import random
+try:
+    import cpickle as pickle
+except:
+    import pickle
+import numpy as np
+import drl_replay
+
+try:
+    STRING_TYPES = basestring
+except NameError:
+    STRING_TYPES = str
+
+# Actions used by the training scripts, the index is the integer stored in the buffer
+ACTION_LIST = ['left', 'right', 'forward', 'backward', 'stop', 'land', 'left_forward', 'left_backward',
+               'right_forward', 'right_backward', 'descend', 'ascend', 'rotate_left', 'rotate_right']
+ACTION_ID = dict((action, index) for index, action in enumerate(ACTION_LIST))
+
+# User flags of the replay files written by save()
+FLAG_STRING_ACTIONS = 1  # the actions are indices in ACTION_LIST
+FLAG_NO_CHANNEL_AXIS = 2  # the images are height x width, stored with depth 1
+REPLAY_FILE_MAGIC = b'DRLRPF1\0'
+
+
+def is_replay_file(file_name):
+    """Return True if the file is a replay file, False if it is (presumably) a pickle
+
+    @param file_name
+    """
+    with open(file_name, 'rb') as f:
+        return f.read(len(REPLAY_FILE_MAGIC)) == REPLAY_FILE_MAGIC
+
+
+class ExperienceReplayBuffer(object):
+    """Class ExperienceReplayBuffer
+
+    Implementation of the experience replay FIFO buffer for DQN.
+    The storage is allocated at the first experience, when the shape of the
+    images is known.
+    """
+
+    def __init__(self, capacity, seed=None):
+        """Initialise the experience buffer.
+
+        @param capacity it is an integer specifying the dimension of the buffer
+        @param seed of the generator used for sampling (random if None)
+        """
+        if capacity <= 0:
+            raise ValueError("[REPLAY BUFFER][ERROR] the capacity must be > 0")
+        self.capacity = capacity
+        self.seed = random.getrandbits(63) if seed is None else seed
+        self.native = None
+        self.string_actions = False
+
+    def _allocate(self, image_shape):
+        shape = image_shape if len(image_shape) == 3 else image_shape + (1,)
+        self.native = drl_replay.ReplayBuffer(self.capacity, shape[0], shape[1], shape[2], self.seed)
+        self.image_shape = image_shape
+
+    def _encode_action(self, action):
+        if isinstance(action, STRING_TYPES):
+            self.string_actions = True
+            return ACTION_ID[action]
+        return int(action)
+
+    def _decode_action(self, action):
+        return ACTION_LIST[action] if self.string_actions else int(action)
+
+    @property
+    def size(self):
+        return 0 if self.native is None else len(self.native)
+
+    def add_experience(self, image_t, action_t, reward_t, image_t1, done_t1):
+        """Add a new experience in the buffer
+
+        @param image_t the image at time t
+        @param action_t taken at time t (string or integer)
+        @param reward_t obtained at time t
+        @param image_t1 at time t+1
+        @param done_t1 boolean indicating if t+1 is terminal
+        """
+        image_t = np.asarray(image_t)
+        if self.native is None:
+            self._allocate(image_t.shape)
+        self.native.add(image_t, self._encode_action(action_t), reward_t, image_t1, done_t1)
+
+    def return_experience_arrays(self, batch_size):
+        """Return a batch as arrays, ready to be fed to the network
+
+        @param batch_size an integer representing the number of experiences to return
+        @return images_t (batch, h, w, d) uint8, actions int32, rewards float32, images_t1, dones bool
+        """
+        if batch_size > self.return_size():
+            raise Exception("ERROR: a batch of experience can be returned only if n < buffer_size")
+        images_t, actions, rewards, images_t1, dones = self.native.sample(batch_size)
+        if len(self.image_shape) == 2:
+            images_t = images_t[:, :, :, 0]
+            images_t1 = images_t1[:, :, :, 0]
+        return images_t, actions, rewards, images_t1, dones
+
+    def return_experience_batch(self, batch_size):
+        """Return a batch_size-lenght list of experiences
+
+        Same format of the Python buffer: [(image_t, action_t, reward_t, image_t1, done_t1), ...]
+        @param batch_size an integer representing the number of experiences to return
+        @return a batch of experiences
+        """
+        images_t, actions, rewards, images_t1, dones = self.return_experience_arrays(batch_size)
+        return [(images_t[i], self._decode_action(actions[i]), float(rewards[i]), images_t1[i], bool(dones[i]))
+                for i in range(batch_size)]
+
+    def return_experience(self, index):
+        """Return the experience at the given index, 0 is the oldest
+
+        @return (image_t, action_t, reward_t, image_t1, done_t1)
+        """
+        image_t, action, reward, image_t1, done = self.native.get(index)
+        if len(self.image_shape) == 2:
+            image_t = image_t[:, :, 0]
+            image_t1 = image_t1[:, :, 0]
+        return image_t, self._decode_action(action), reward, image_t1, done
+
+    def return_size(self):
+        """Return the number of elements inside the buffer
+
+        @return an integer representing the number of elements
+        """
+        return self.size
+
+    def return_size_byte(self, value='byte'):
+        """Return the number bytes allocated by the buffer
+
+        @param value a string representing the type of value
+            it can be: byte, kilobyte, megabyte, gigabyte.
+        @return the memory allocated
+        """
+        allocated = 0 if self.native is None else self.native.nbytes
+        divisors = {'byte': 1, 'kilobyte': 1024, 'megabyte': 1048576, 'gigabyte': 1073741824}
+        if value not in divisors:
+            raise Exception("[EXPERIENCE REPLAY BUFFER] Error: "
+                            "the value must be one of (byte, kilobyte, megabyte, gigabyte)")
+        return float(allocated) / divisors[value]
+
+    def save(self, file_name):
+        """ Save the buffer in a replay file, written as it is read and mapped by load().
+
+        @param file_name
+        """
+        if self.native is None:
+            drl_replay.ReplayFileWriter(file_name, truncate=True).close()
+            return
+        user_flags = FLAG_STRING_ACTIONS if self.string_actions else 0
+        if len(self.image_shape) == 2:
+            user_flags |= FLAG_NO_CHANNEL_AXIS
+        self.native.save(file_name, user_flags)
+
+    def load(self, file_name, clear=True):
+        """Load the buffer from a replay file or from a pickle saved by either buffer.
+
+        @param file_name
+        @param clear when False the experiences are added to the ones already stored
+        """
+        if clear and self.native is not None:
+            self.native.clear()
+        if not is_replay_file(file_name):
+            with open(file_name, 'rb') as f:
+                buffer = pickle.load(f)
+            for element in buffer:
+                self.add_experience(element[0], element[1], element[2], element[3], element[4])
+            return
+        replay_file = drl_replay.ReplayFile(file_name)
+        if len(replay_file) == 0:
+            return
+        if self.native is None:
+            height, width, depth = replay_file.shape
+            self._allocate((height, width) if replay_file.user_flags & FLAG_NO_CHANNEL_AXIS
+                           else (height, width, depth))
+        if replay_file.user_flags & FLAG_STRING_ACTIONS:
+            self.string_actions = True
+        self.native.extend(replay_file)
+
+    def append(self, replay_buffer_2):
+        """
+        Append a second replay buffer at the end of another one (oldest experiences first)
+
+        @param replay_buffer_2 is a second replay buffer
+        """
+        for i in range(replay_buffer_2.return_size()):
+            element = replay_buffer_2.return_experience(i)
+            self.add_experience(element[0], element[1], element[2], element[3], element[4])
+
+    def debug_experience(self, index=None, pad_size=2, pad_value=0, print_info=True):
+        """ Return a horizontal stack of the images contained in the experience and print experience values.
+
+        @param index: the index of the image to return, if None a random experience is returned
+        @param pad_size: the number of values to use for padding the images (default 2 pixels)
+        @param pad_value: the value to use for the padding (default 0 = black in OpenCV)
+        @param print_info: when True print the values of action, reward, done (default True)
+        @return: the padded images at t and t+1
+        """
+        if index is None:
+            index = random.randint(0, self.size - 1)
+        image_stack, action, reward, image_t1_stack, done = self.return_experience(index)
+        if print_info:
+            print("Index  ..... " + str(index))
+            print("Action ..... " + str(action))
+            print("Reward ..... " + str(reward))
+            print("Done   ..... " + str(done))
+            print("")
+        if image_stack.ndim == 2:
+            image_stack = image_stack[:, :, np.newaxis]
+            image_t1_stack = image_t1_stack[:, :, np.newaxis]
+        padding = ((pad_size, pad_size), (pad_size, pad_size))
+        image = np.hstack([np.pad(image_stack[:, :, d], padding, 'constant', constant_values=pad_value)
+                           for d in range(image_stack.shape[2])])
+        image_t1 = np.hstack([np.pad(image_t1_stack[:, :, d], padding, 'constant', constant_values=pad_value)
+                              for d in range(image_t1_stack.shape[2])])
+        return image, image_t1
+
+    def count_experience(self):
+        """
+        Count the number of positive, neutral and negative experiences contained in a buffer.
+        """
+        counter_positive = 0
+        counter_neutral = 0
+        counter_negative = 0
+        for i in range(self.size):
+            reward = self.native.get(i)[2]
+            if reward == 1.0:
+                counter_positive += 1
+            elif reward == -1.0:
+                counter_negative += 1
+            else:
+                counter_neutral += 1
+
+        print("Number of positive experiences: " + str(counter_positive))
+        print("Number of negative experiences: " + str(counter_negative))
+        print("Number of neutral experiences: " + str(counter_neutral))
+
+
+class FrameExperienceReplayBuffer(ExperienceReplayBuffer):
+    """Class FrameExperienceReplayBuffer
+
+    Same interface of ExperienceReplayBuffer, each frame is stored once and the
+    stacks are rebuilt at sample time (about 8 times less memory with stacks of 4).
+    The experiences of an episode have to be added in order: image_t equal to the
+    previous image_t1 continues the episode, anything else begins a new one.
+    The frames can also be compressed, trading some CPU at sample time for memory.
+    """
+
+    CODECS = {None: drl_replay.FrameCodec.RAW, 'lz4': drl_replay.FrameCodec.LZ4,
+              'delta': drl_replay.FrameCodec.DELTA_LZ4}
+
+    def __init__(self, capacity, seed=None, compression=None, compressed_bytes=0, decode_threads=0):
+        """Initialise the experience buffer.
+
+        @param capacity it is an integer specifying the dimension of the buffer
+        @param seed of the generator used for sampling (random if None)
+        @param compression None, 'lz4' or 'delta' (difference from the previous frame, then LZ4)
+        @param compressed_bytes the memory for the compressed frames, when full the oldest
+            experiences are dropped even if the capacity is not reached (0 for a quarter of the raw frames)
+        @param decode_threads the threads decoding a batch (0 for one per core)
+        """
+        super(FrameExperienceReplayBuffer, self).__init__(capacity, seed)
+        if compression not in self.CODECS:
+            raise ValueError("[REPLAY BUFFER][ERROR] the compression must be None, 'lz4' or 'delta'")
+        self.compression = compression
+        self.compressed_bytes = compressed_bytes
+        self.decode_threads = decode_threads
+
+    def _allocate(self, image_shape):
+        shape = image_shape if len(image_shape) == 3 else image_shape + (1,)
+        self.native = drl_replay.FrameReplayBuffer(self.capacity, shape[0], shape[1], shape[2], self.seed,
+                                                   self.CODECS[self.compression], self.compressed_bytes,
+                                                   self.decode_threads)
+        self.image_shape = image_shape
+
+
+class PrioritizedExperienceReplayBuffer(ExperienceReplayBuffer):
+    """Class PrioritizedExperienceReplayBuffer
+
+    Proportional prioritised experience replay: transitions are sampled with
+    probability proportional to their last TD error to the power of alpha and
+    come with importance-sampling weights. After each learner step the TD
+    errors of the batch are given back through update_priorities().
+    """
+
+    def __init__(self, capacity, alpha=0.6, beta=0.4, deduplicate_frames=False, seed=None):
+        """Initialise the experience buffer.
+
+        @param capacity it is an integer specifying the dimension of the buffer
+        @param alpha the prioritisation exponent (0 is uniform sampling)
+        @param beta the default importance-sampling exponent
+        @param deduplicate_frames when True every frame is stored once (see FrameExperienceReplayBuffer)
+        @param seed of the generators used for sampling (random if None)
+        """
+        super(PrioritizedExperienceReplayBuffer, self).__init__(capacity, seed)
+        self.alpha = alpha
+        self.beta = beta
+        self.deduplicate_frames = deduplicate_frames
+
+    def _allocate(self, image_shape):
+        shape = image_shape if len(image_shape) == 3 else image_shape + (1,)
+        native_class = (drl_replay.PrioritizedFrameReplayBuffer if self.deduplicate_frames
+                        else drl_replay.PrioritizedReplayBuffer)
+        self.native = native_class(self.capacity, shape[0], shape[1], shape[2], self.alpha, 1e-6, self.seed)
+        self.image_shape = image_shape
+
+    def return_experience_arrays(self, batch_size, beta=None):
+        """Return a prioritised batch as arrays
+
+        @param batch_size an integer representing the number of experiences to return
+        @param beta the importance-sampling exponent (the default one if None)
+        @return images_t, actions, rewards, images_t1, dones, weights (float32) and
+            indices to give back to update_priorities()
+        """
+        if self.return_size() == 0:
+            raise Exception("ERROR: a batch of experience can be returned only if the buffer is not empty")
+        images_t, actions, rewards, images_t1, dones, weights, indices = self.native.sample(
+            batch_size, self.beta if beta is None else beta)
+        if len(self.image_shape) == 2:
+            images_t = images_t[:, :, :, 0]
+            images_t1 = images_t1[:, :, :, 0]
+        return images_t, actions, rewards, images_t1, dones, weights, indices
+
+    def return_experience_batch(self, batch_size, beta=None):
+        """Return a batch_size-lenght list of experiences, their weights and indices
+
+        @return [(image_t, action_t, reward_t, image_t1, done_t1), ...], weights, indices
+        """
+        images_t, actions, rewards, images_t1, dones, weights, indices = self.return_experience_arrays(batch_size,
+                                                                                                      beta)
+        batch = [(images_t[i], self._decode_action(actions[i]), float(rewards[i]), images_t1[i], bool(dones[i]))
+                 for i in range(batch_size)]
+        return batch, weights, indices
+
+    def update_priorities(self, indices, td_errors):
+        """Set the priorities of a sampled batch after a learner step
+
+        @param indices returned with the batch
+        @param td_errors the absolute TD errors of the batch
+        """
+        self.native.update_priorities(indices, np.abs(np.asarray(td_errors, dtype=np.float32)).ravel())
+
+
+class StratifiedExperienceReplayBuffer(ExperienceReplayBuffer):
+    """Class StratifiedExperienceReplayBuffer
+
+    One buffer holding the positive, neutral and negative experiences as separate
+    FIFOs over a single allocation (it replaces the shared, positive, neutral and
+    negative buffers). The counts are O(1) and a batch with a given mix of the
+    classes is sampled in a single call.
+    """
+
+    def __init__(self, capacity_positive, capacity_neutral, capacity_negative, mix=(0.25, 0.5, 0.25), seed=None):
+        """Initialise the experience buffer.
+
+        @param capacity_positive, capacity_neutral, capacity_negative the capacity of each class
+        @param mix the default proportions of (positive, neutral, negative) experiences in a batch
+        @param seed of the generator used for sampling (random if None)
+        """
+        super(StratifiedExperienceReplayBuffer, self).__init__(
+            capacity_positive + capacity_neutral + capacity_negative, seed)
+        self.capacities = (capacity_positive, capacity_neutral, capacity_negative)
+        self.mix = tuple(mix)
+
+    def _allocate(self, image_shape):
+        shape = image_shape if len(image_shape) == 3 else image_shape + (1,)
+        self.native = drl_replay.StratifiedReplayBuffer(self.capacities, shape[0], shape[1], shape[2], self.seed)
+        self.image_shape = image_shape
+
+    def return_experience_arrays(self, batch_size, mix=None):
+        """Return a batch as arrays, with the given mix of the classes
+
+        @param batch_size an integer representing the number of experiences to return
+        @param mix the proportions of (positive, neutral, negative) experiences (the default one if None)
+        @return images_t, actions, rewards, images_t1, dones ordered by class
+        """
+        if self.return_size() == 0:
+            raise Exception("ERROR: a batch of experience can be returned only if the buffer is not empty")
+        images_t, actions, rewards, images_t1, dones, counts = self.native.sample(
+            batch_size, self.mix if mix is None else tuple(mix))
+        if len(self.image_shape) == 2:
+            images_t = images_t[:, :, :, 0]
+            images_t1 = images_t1[:, :, :, 0]
+        return images_t, actions, rewards, images_t1, dones
+
+    def return_experience_batch(self, batch_size, mix=None):
+        """Return a batch_size-lenght list of experiences with the given mix of the classes
+
+        @return [(image_t, action_t, reward_t, image_t1, done_t1), ...]
+        """
+        images_t, actions, rewards, images_t1, dones = self.return_experience_arrays(batch_size, mix)
+        return [(images_t[i], self._decode_action(actions[i]), float(rewards[i]), images_t1[i], bool(dones[i]))
+                for i in range(batch_size)]
+
+    def return_size(self, reward_class=None):
+        """Return the number of elements inside the buffer
+
+        @param reward_class drl_replay.StratifiedReplayBuffer.POSITIVE, NEUTRAL, NEGATIVE or None for all of them
+        @return an integer representing the number of elements
+        """
+        if self.native is None:
+            return 0
+        return len(self.native) if reward_class is None else self.native.count(reward_class)
+
+    def count_experience(self):
+        """
+        Print the number of positive, neutral and negative experiences contained in the buffer.
+        """
+        print("Number of positive experiences: " + str(self.return_size(drl_replay.StratifiedReplayBuffer.POSITIVE)))
+        print("Number of negative experiences: " + str(self.return_size(drl_replay.StratifiedReplayBuffer.NEGATIVE)))
+        print("Number of neutral experiences: " + str(self.return_size(drl_replay.StratifiedReplayBuffer.NEUTRAL)))
@@ -0,0 +1,84 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Sum-tree and min-tree over the priorities of the replay buffer's slots.
+*/
+
+#include "../include/priorityTree.h"
+#include <algorithm>
+#include <limits>
+
+PriorityTree::PriorityTree(size_t size)
+{
+  leaves_ = 1;
+  while (leaves_ < size)
+  {
+    leaves_ *= 2;
+  }
+  sum_.resize(2 * leaves_);
+  min_.resize(2 * leaves_);
+  clear();
+}
+
+PriorityTree::~PriorityTree()
+{
+}
+
+void PriorityTree::set(size_t index, double priority)
+{
+  size_t node = leaves_ + index;
+  sum_[node] = priority;
+  min_[node] = priority > 0.0 ? priority : std::numeric_limits<double>::infinity();
+  for (node /= 2; node >= 1; node /= 2)
+  {
+    sum_[node] = sum_[2 * node] + sum_[2 * node + 1];
+    min_[node] = std::min(min_[2 * node], min_[2 * node + 1]);
+  }
+}
+
+double PriorityTree::get(size_t index) const
+{
+  return sum_[leaves_ + index];
+}
+
+size_t PriorityTree::find(double prefix) const
+{
+  size_t node = 1;
+  while (node < leaves_)
+  {
+    size_t left = 2 * node;
+    // Rounding can leave prefix just above the left sum with an empty right subtree
+    if (prefix < sum_[left] || sum_[left + 1] <= 0.0)
+    {
+      node = left;
+    }
+    else
+    {
+      prefix -= sum_[left];
+      node = left + 1;
+    }
+  }
+  return node - leaves_;
+}
+
+double PriorityTree::getTotal() const
+{
+  return sum_[1];
+}
+
+double PriorityTree::getMin() const
+{
+  return min_[1];
+}
+
+void PriorityTree::clear()
+{
+  std::fill(sum_.begin(), sum_.end(), 0.0);
+  std::fill(min_.begin(), min_.end(), std::numeric_limits<double>::infinity());
+}
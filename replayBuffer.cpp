@@ -0,0 +1,184 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Experience replay FIFO buffer for DQN with preallocated contiguous storage.
+*/
+
+#include "../include/replayBuffer.h"
+#include <algorithm>
+#include <string.h>
+
+void sampleDistinct(std::mt19937_64 &generator, size_t n, size_t count, size_t *out, std::vector<size_t> &scratch)
+{
+  if (count * 4 > n)
+  {
+    // Large batch wrt n: partial Fisher-Yates shuffle of all the integers
+    scratch.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+      scratch[i] = i;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+      std::uniform_int_distribution<size_t> distribution(i, n - 1);
+      std::swap(scratch[i], scratch[distribution(generator)]);
+      out[i] = scratch[i];
+    }
+    return;
+  }
+
+  // Small batch: draw and reject the (rare) repetitions
+  std::uniform_int_distribution<size_t> distribution(0, n - 1);
+  for (size_t i = 0; i < count; i++)
+  {
+    size_t candidate;
+    do
+    {
+      candidate = distribution(generator);
+    } while (std::find(out, out + i, candidate) != out + i);
+    out[i] = candidate;
+  }
+}
+
+ReplayBuffer::ReplayBuffer(size_t capacity, int height, int width, int depth, uint64_t seed)
+{
+  capacity_ = capacity;
+  height_ = height;
+  width_ = width;
+  depth_ = depth;
+  observation_size_ = (size_t)height * width * depth;
+
+  images_t_.resize(capacity_ * observation_size_);
+  actions_.resize(capacity_);
+  rewards_.resize(capacity_);
+  images_t1_.resize(capacity_ * observation_size_);
+  dones_.resize(capacity_);
+
+  next_ = 0;
+  size_ = 0;
+  generator_.seed(seed);
+}
+
+ReplayBuffer::~ReplayBuffer()
+{
+}
+
+size_t ReplayBuffer::slot(size_t position) const
+{
+  // The oldest transition is the one that the next add overwrites once the buffer is full
+  return (next_ + capacity_ - size_ + position) % capacity_;
+}
+
+bool ReplayBuffer::add(const uint8_t *image_t, int32_t action, float reward, const uint8_t *image_t1, bool done)
+{
+  if (capacity_ == 0)
+  {
+    return true;
+  }
+  memcpy(&images_t_[next_ * observation_size_], image_t, observation_size_);
+  actions_[next_] = action;
+  rewards_[next_] = reward;
+  memcpy(&images_t1_[next_ * observation_size_], image_t1, observation_size_);
+  dones_[next_] = done;
+
+  next_ = (next_ + 1) % capacity_;
+  if (size_ < capacity_)
+  {
+    size_++;
+  }
+  return true;
+}
+
+bool ReplayBuffer::sampleIndices(size_t batch_size, size_t *positions)
+{
+  if (batch_size > size_)
+  {
+    return false;
+  }
+  sampleDistinct(generator_, size_, batch_size, positions, scratch_);
+  return true;
+}
+
+void ReplayBuffer::gather(const size_t *positions, size_t count, uint8_t *images_t, int32_t *actions, float *rewards,
+                          uint8_t *images_t1, uint8_t *dones) const
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    size_t s = slot(positions[i]);
+    memcpy(images_t + i * observation_size_, &images_t_[s * observation_size_], observation_size_);
+    actions[i] = actions_[s];
+    rewards[i] = rewards_[s];
+    memcpy(images_t1 + i * observation_size_, &images_t1_[s * observation_size_], observation_size_);
+    dones[i] = dones_[s];
+  }
+}
+
+bool ReplayBuffer::sample(size_t batch_size, uint8_t *images_t, int32_t *actions, float *rewards,
+                          uint8_t *images_t1, uint8_t *dones)
+{
+  std::vector<size_t> positions(batch_size);
+  if (sampleIndices(batch_size, positions.data()) == false)
+  {
+    return false;
+  }
+  gather(positions.data(), batch_size, images_t, actions, rewards, images_t1, dones);
+  return true;
+}
+
+size_t ReplayBuffer::getSlot(size_t position) const
+{
+  return slot(position);
+}
+
+void ReplayBuffer::seed(uint64_t seed)
+{
+  generator_.seed(seed);
+}
+
+void ReplayBuffer::clear()
+{
+  next_ = 0;
+  size_ = 0;
+}
+
+size_t ReplayBuffer::getSize() const
+{
+  return size_;
+}
+
+size_t ReplayBuffer::getCapacity() const
+{
+  return capacity_;
+}
+
+size_t ReplayBuffer::getObservationSize() const
+{
+  return observation_size_;
+}
+
+int ReplayBuffer::getHeight() const
+{
+  return height_;
+}
+
+int ReplayBuffer::getWidth() const
+{
+  return width_;
+}
+
+int ReplayBuffer::getDepth() const
+{
+  return depth_;
+}
+
+size_t ReplayBuffer::getByteSize() const
+{
+  return images_t_.size() + images_t1_.size() + actions_.size() * sizeof(int32_t) +
+         rewards_.size() * sizeof(float) + dones_.size();
+}
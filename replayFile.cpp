@@ -0,0 +1,574 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Chunked binary replay file, written append-only and read in place through mmap.
+*/
+
+#include "../include/replayFile.h"
+#include "../include/replayBuffer.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <limits>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(ReplayFile::Header) <= ReplayFile::HEADER_SIZE, "the header does not fit its page");
+
+namespace
+{
+const char MAGIC[8] = "DRLRPF1";
+const uint64_t CHUNK_ALIGNMENT = 4096;
+const uint64_t COLUMN_ALIGNMENT = 64;
+
+uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+/*
+  Map length bytes of the file from offset, which does not need to be aligned to the page size of the host
+
+  @param base receives the start of the mapping (to be given to munmap with length + (offset - aligned offset))
+  @return the address of offset in the mapping, NULL on failure
+*/
+uint8_t *mapRange(int fd, uint64_t offset, size_t length, int protection, void **base, size_t *mapped)
+{
+  const uint64_t page = sysconf(_SC_PAGESIZE);
+  const uint64_t aligned = offset / page * page;
+  *mapped = length + (offset - aligned);
+  *base = mmap(NULL, *mapped, protection, MAP_SHARED, fd, aligned);
+  if (*base == MAP_FAILED)
+  {
+    *base = NULL;
+    return NULL;
+  }
+  return static_cast<uint8_t *>(*base) + (offset - aligned);
+}
+}
+
+uint64_t ReplayFile::layout(size_t observation_size, uint32_t chunk_size, uint64_t column_offsets[NUM_COLUMNS])
+{
+  const uint64_t sizes[NUM_COLUMNS] = { observation_size, observation_size, sizeof(int32_t), sizeof(float),
+                                        sizeof(uint8_t), 3 * sizeof(float) };
+  uint64_t offset = 0;
+  for (int c = 0; c < NUM_COLUMNS; c++)
+  {
+    column_offsets[c] = offset;
+    offset = alignUp(offset + sizes[c] * chunk_size, COLUMN_ALIGNMENT);
+  }
+  return alignUp(offset, CHUNK_ALIGNMENT);
+}
+
+// ReplayFile
+
+ReplayFile::ReplayFile()
+{
+  fd_ = -1;
+  memory_ = NULL;
+  size_ = 0;
+  header_ = NULL;
+  writable_ = false;
+  count_ = 0;
+  observation_size_ = 0;
+}
+
+ReplayFile::~ReplayFile()
+{
+  close();
+}
+
+bool ReplayFile::open(const std::string &path, uint64_t seed, bool writable)
+{
+  close();
+  generator_.seed(seed);
+  fd_ = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+  if (fd_ < 0)
+  {
+    return false;
+  }
+  struct stat status;
+  if (fstat(fd_, &status) != 0 || (uint64_t)status.st_size < HEADER_SIZE)
+  {
+    close();
+    return false;
+  }
+  size_ = status.st_size;
+  void *memory = mmap(NULL, size_, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+  if (memory == MAP_FAILED)
+  {
+    close();
+    return false;
+  }
+  memory_ = static_cast<uint8_t *>(memory);
+  header_ = reinterpret_cast<const Header *>(memory_);
+  writable_ = writable;
+
+  // Reject anything that does not match the layout this build would write
+  uint64_t column_offsets[NUM_COLUMNS];
+  observation_size_ = (size_t)header_->height * header_->width * header_->depth;
+  if (memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0 || header_->version != VERSION || observation_size_ == 0 ||
+      header_->chunk_size == 0 ||
+      header_->chunk_bytes != layout(observation_size_, header_->chunk_size, column_offsets) ||
+      memcmp(header_->column_offsets, column_offsets, sizeof(column_offsets)) != 0)
+  {
+    close();
+    return false;
+  }
+  count_ = __atomic_load_n(&header_->count, __ATOMIC_ACQUIRE);
+  if (HEADER_SIZE + getNumChunks() * header_->chunk_bytes > size_)
+  {
+    close();
+    return false;
+  }
+  // Sampling touches the pages in random order, read-ahead would only waste memory
+  madvise(memory_ + HEADER_SIZE, size_ - HEADER_SIZE, MADV_RANDOM);
+  return true;
+}
+
+void ReplayFile::close()
+{
+  if (memory_ != NULL)
+  {
+    munmap(memory_, size_);
+    memory_ = NULL;
+  }
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  header_ = NULL;
+  writable_ = false;
+  size_ = 0;
+  count_ = 0;
+  observation_size_ = 0;
+}
+
+bool ReplayFile::isOpen() const
+{
+  return memory_ != NULL;
+}
+
+const uint8_t *ReplayFile::column(Column column, size_t index, size_t stride) const
+{
+  size_t chunk = index / header_->chunk_size;
+  size_t row = index % header_->chunk_size;
+  return memory_ + HEADER_SIZE + chunk * header_->chunk_bytes + header_->column_offsets[column] + row * stride;
+}
+
+const uint8_t *ReplayFile::getImageT(size_t index) const
+{
+  return column(IMAGES_T, index, observation_size_);
+}
+
+const uint8_t *ReplayFile::getImageT1(size_t index) const
+{
+  return column(IMAGES_T1, index, observation_size_);
+}
+
+int32_t ReplayFile::getAction(size_t index) const
+{
+  int32_t action;
+  memcpy(&action, column(ACTIONS, index, sizeof(int32_t)), sizeof(action));
+  return action;
+}
+
+float ReplayFile::getReward(size_t index) const
+{
+  float reward;
+  memcpy(&reward, column(REWARDS, index, sizeof(float)), sizeof(reward));
+  return reward;
+}
+
+bool ReplayFile::getDone(size_t index) const
+{
+  return *column(DONES, index, sizeof(uint8_t)) != 0;
+}
+
+const float *ReplayFile::getPosition(size_t index) const
+{
+  return reinterpret_cast<const float *>(column(POSITIONS, index, 3 * sizeof(float)));
+}
+
+const uint8_t *ReplayFile::getChunkColumn(size_t chunk, Column column) const
+{
+  if (chunk >= getNumChunks())
+  {
+    return NULL;
+  }
+  return memory_ + HEADER_SIZE + chunk * header_->chunk_bytes + header_->column_offsets[column];
+}
+
+uint8_t *ReplayFile::getMutableChunkColumn(size_t chunk, Column column)
+{
+  if (writable_ == false)
+  {
+    return NULL;
+  }
+  return const_cast<uint8_t *>(getChunkColumn(chunk, column));
+}
+
+bool ReplayFile::sync()
+{
+  return writable_ && msync(memory_, size_, MS_SYNC) == 0;
+}
+
+void ReplayFile::prefetchChunks(size_t begin, size_t end) const
+{
+  end = std::min(end, getNumChunks());
+  if (begin < end)
+  {
+    madvise(const_cast<uint8_t *>(getChunkColumn(begin, IMAGES_T)), (end - begin) * header_->chunk_bytes,
+            MADV_WILLNEED);
+  }
+}
+
+void ReplayFile::releaseChunks(size_t begin, size_t end) const
+{
+  end = std::min(end, getNumChunks());
+  if (begin < end)
+  {
+    // The mapping is shared: the pages (rewritten or not) stay in the page cache, only this process lets them go
+    madvise(const_cast<uint8_t *>(getChunkColumn(begin, IMAGES_T)), (end - begin) * header_->chunk_bytes,
+            MADV_DONTNEED);
+  }
+}
+
+void ReplayFile::gather(const size_t *indices, size_t count, uint8_t *images_t, int32_t *actions, float *rewards,
+                        uint8_t *images_t1, uint8_t *dones, float *positions) const
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    size_t index = indices[i];
+    memcpy(images_t + i * observation_size_, getImageT(index), observation_size_);
+    actions[i] = getAction(index);
+    rewards[i] = getReward(index);
+    memcpy(images_t1 + i * observation_size_, getImageT1(index), observation_size_);
+    dones[i] = getDone(index);
+    if (positions != NULL)
+    {
+      memcpy(positions + 3 * i, getPosition(index), 3 * sizeof(float));
+    }
+  }
+}
+
+bool ReplayFile::sample(size_t batch_size, uint8_t *images_t, int32_t *actions, float *rewards, uint8_t *images_t1,
+                        uint8_t *dones, float *positions)
+{
+  if (batch_size > count_)
+  {
+    return false;
+  }
+  std::vector<size_t> indices(batch_size);
+  sampleDistinct(generator_, count_, batch_size, indices.data(), scratch_);
+  gather(indices.data(), batch_size, images_t, actions, rewards, images_t1, dones, positions);
+  return true;
+}
+
+void ReplayFile::seed(uint64_t seed)
+{
+  generator_.seed(seed);
+}
+
+size_t ReplayFile::getSize() const
+{
+  return count_;
+}
+
+size_t ReplayFile::getChunkSize() const
+{
+  return header_ == NULL ? 0 : header_->chunk_size;
+}
+
+size_t ReplayFile::getNumChunks() const
+{
+  return header_ == NULL ? 0 : (count_ + header_->chunk_size - 1) / header_->chunk_size;
+}
+
+size_t ReplayFile::getObservationSize() const
+{
+  return observation_size_;
+}
+
+int ReplayFile::getHeight() const
+{
+  return header_ == NULL ? 0 : header_->height;
+}
+
+int ReplayFile::getWidth() const
+{
+  return header_ == NULL ? 0 : header_->width;
+}
+
+int ReplayFile::getDepth() const
+{
+  return header_ == NULL ? 0 : header_->depth;
+}
+
+uint32_t ReplayFile::getUserFlags() const
+{
+  return header_ == NULL ? 0 : header_->user_flags;
+}
+
+// ReplayFileWriter
+
+ReplayFileWriter::ReplayFileWriter()
+{
+  fd_ = -1;
+  header_ = NULL;
+  chunk_ = NULL;
+  chunk_base_ = NULL;
+  chunk_mapped_ = 0;
+  chunk_index_ = 0;
+  count_ = 0;
+  observation_size_ = 0;
+}
+
+ReplayFileWriter::~ReplayFileWriter()
+{
+  close();
+}
+
+bool ReplayFileWriter::open(const std::string &path, int height, int width, int depth, uint32_t chunk_size,
+                            bool truncate)
+{
+  close();
+  if (height <= 0 || width <= 0 || depth <= 0 || chunk_size == 0)
+  {
+    return false;
+  }
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+  if (fd_ < 0)
+  {
+    return false;
+  }
+  struct stat status;
+  if (fstat(fd_, &status) != 0)
+  {
+    close();
+    return false;
+  }
+  const bool empty = status.st_size == 0;
+  if ((empty == false && (uint64_t)status.st_size < ReplayFile::HEADER_SIZE) ||
+      (empty && ftruncate(fd_, ReplayFile::HEADER_SIZE) != 0))
+  {
+    close();
+    return false;
+  }
+  void *memory = mmap(NULL, ReplayFile::HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (memory == MAP_FAILED)
+  {
+    close();
+    return false;
+  }
+  header_ = static_cast<ReplayFile::Header *>(memory);
+  observation_size_ = (size_t)height * width * depth;
+
+  if (empty)
+  {
+    memset(header_, 0, sizeof(ReplayFile::Header));
+    header_->version = ReplayFile::VERSION;
+    header_->height = height;
+    header_->width = width;
+    header_->depth = depth;
+    header_->chunk_size = chunk_size;
+    header_->chunk_bytes = ReplayFile::layout(observation_size_, chunk_size, header_->column_offsets);
+    header_->count = 0;
+    // The magic is written last, a file interrupted before this point is not a replay file
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(header_->magic, MAGIC, sizeof(MAGIC));
+  }
+  else if (memcmp(header_->magic, MAGIC, sizeof(MAGIC)) != 0 || header_->version != ReplayFile::VERSION ||
+           header_->height != (uint32_t)height || header_->width != (uint32_t)width ||
+           header_->depth != (uint32_t)depth)
+  {
+    // Not ours to commit to
+    munmap(header_, ReplayFile::HEADER_SIZE);
+    header_ = NULL;
+    close();
+    return false;
+  }
+  // Whatever follows the last commit of an existing file is overwritten
+  count_ = header_->count;
+  return true;
+}
+
+void ReplayFileWriter::close()
+{
+  if (header_ != NULL)
+  {
+    commit(true);
+  }
+  unmapChunk();
+  if (header_ != NULL)
+  {
+    munmap(header_, ReplayFile::HEADER_SIZE);
+    header_ = NULL;
+  }
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  count_ = 0;
+  observation_size_ = 0;
+}
+
+bool ReplayFileWriter::isOpen() const
+{
+  return header_ != NULL;
+}
+
+bool ReplayFileWriter::mapChunk(size_t chunk)
+{
+  unmapChunk();
+  const uint64_t offset = ReplayFile::HEADER_SIZE + chunk * header_->chunk_bytes;
+  // Reserve the blocks of the whole chunk, a full disk fails here instead of faulting on the mapping
+  if (posix_fallocate(fd_, offset, header_->chunk_bytes) != 0)
+  {
+    return false;
+  }
+  chunk_ = mapRange(fd_, offset, header_->chunk_bytes, PROT_READ | PROT_WRITE, &chunk_base_, &chunk_mapped_);
+  if (chunk_ == NULL)
+  {
+    return false;
+  }
+  chunk_index_ = chunk;
+  return true;
+}
+
+void ReplayFileWriter::unmapChunk()
+{
+  if (chunk_base_ != NULL)
+  {
+    munmap(chunk_base_, chunk_mapped_);
+  }
+  chunk_ = NULL;
+  chunk_base_ = NULL;
+  chunk_mapped_ = 0;
+}
+
+bool ReplayFileWriter::append(const uint8_t *image_t, int32_t action, float reward, const uint8_t *image_t1, bool done,
+                              const float *position)
+{
+  const size_t chunk = count_ / header_->chunk_size;
+  const size_t row = count_ % header_->chunk_size;
+  if ((chunk_ == NULL || chunk != chunk_index_) && mapChunk(chunk) == false)
+  {
+    return false;
+  }
+
+  const uint64_t *offsets = header_->column_offsets;
+  memcpy(chunk_ + offsets[ReplayFile::IMAGES_T] + row * observation_size_, image_t, observation_size_);
+  memcpy(chunk_ + offsets[ReplayFile::IMAGES_T1] + row * observation_size_, image_t1, observation_size_);
+  memcpy(chunk_ + offsets[ReplayFile::ACTIONS] + row * sizeof(int32_t), &action, sizeof(int32_t));
+  memcpy(chunk_ + offsets[ReplayFile::REWARDS] + row * sizeof(float), &reward, sizeof(float));
+  chunk_[offsets[ReplayFile::DONES] + row] = done;
+  const float unknown[3] = { std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN(),
+                             std::numeric_limits<float>::quiet_NaN() };
+  memcpy(chunk_ + offsets[ReplayFile::POSITIONS] + row * 3 * sizeof(float), position != NULL ? position : unknown,
+         3 * sizeof(float));
+
+  count_++;
+  if (row + 1 == header_->chunk_size)
+  {
+    commit();
+  }
+  return true;
+}
+
+bool ReplayFileWriter::appendBatch(const uint8_t *images_t, const int32_t *actions, const float *rewards,
+                                   const uint8_t *images_t1, const uint8_t *dones, const float *positions, size_t count)
+{
+  size_t done = 0;
+  while (done < count)
+  {
+    const size_t chunk = count_ / header_->chunk_size;
+    const size_t row = count_ % header_->chunk_size;
+    if ((chunk_ == NULL || chunk != chunk_index_) && mapChunk(chunk) == false)
+    {
+      return false;
+    }
+
+    // Rows of a column are consecutive in a chunk: one copy per column up to the end of the chunk
+    const size_t n = std::min<size_t>(count - done, header_->chunk_size - row);
+    const uint64_t *offsets = header_->column_offsets;
+    memcpy(chunk_ + offsets[ReplayFile::IMAGES_T] + row * observation_size_, images_t + done * observation_size_,
+           n * observation_size_);
+    memcpy(chunk_ + offsets[ReplayFile::IMAGES_T1] + row * observation_size_, images_t1 + done * observation_size_,
+           n * observation_size_);
+    memcpy(chunk_ + offsets[ReplayFile::ACTIONS] + row * sizeof(int32_t), actions + done, n * sizeof(int32_t));
+    memcpy(chunk_ + offsets[ReplayFile::REWARDS] + row * sizeof(float), rewards + done, n * sizeof(float));
+    uint8_t *chunk_dones = chunk_ + offsets[ReplayFile::DONES] + row;
+    for (size_t i = 0; i < n; i++)
+    {
+      chunk_dones[i] = dones[done + i] != 0;
+    }
+    float *chunk_positions = reinterpret_cast<float *>(chunk_ + offsets[ReplayFile::POSITIONS]) + 3 * row;
+    if (positions != NULL)
+    {
+      memcpy(chunk_positions, positions + 3 * done, n * 3 * sizeof(float));
+    }
+    else
+    {
+      std::fill(chunk_positions, chunk_positions + 3 * n, std::numeric_limits<float>::quiet_NaN());
+    }
+
+    count_ += n;
+    done += n;
+    if (row + n == header_->chunk_size)
+    {
+      commit();
+    }
+  }
+  return true;
+}
+
+void ReplayFileWriter::commit(bool sync)
+{
+  if (header_ == NULL)
+  {
+    return;
+  }
+  if (sync && chunk_base_ != NULL)
+  {
+    msync(chunk_base_, chunk_mapped_, MS_SYNC);
+  }
+  // Readers mapping the file see the count only after the transitions it covers
+  __atomic_store_n(&header_->count, count_, __ATOMIC_RELEASE);
+  if (sync)
+  {
+    msync(header_, ReplayFile::HEADER_SIZE, MS_SYNC);
+  }
+}
+
+void ReplayFileWriter::setUserFlags(uint32_t user_flags)
+{
+  if (header_ != NULL)
+  {
+    header_->user_flags = user_flags;
+  }
+}
+
+uint32_t ReplayFileWriter::getUserFlags() const
+{
+  return header_ == NULL ? 0 : header_->user_flags;
+}
+
+size_t ReplayFileWriter::getSize() const
+{
+  return count_;
+}
+
+size_t ReplayFileWriter::getObservationSize() const
+{
+  return observation_size_;
+}
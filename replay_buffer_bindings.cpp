@@ -0,0 +1,686 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Python module drl_replay exposing the native replay buffers to the training scripts (see native_replay_buffer.py
+  for the drop-in replacement of ExperienceReplayBuffer) and the replay files they are saved to.
+*/
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "../include/frameReplayBuffer.h"
+#include "../include/prioritizedReplayBuffer.h"
+#include "../include/replayBuffer.h"
+#include "../include/replayFile.h"
+#include "../include/stratifiedReplayBuffer.h"
+
+namespace py = pybind11;
+
+namespace
+{
+typedef py::array_t<uint8_t, py::array::c_style | py::array::forcecast> ByteArray;
+// Output arrays are never converted, the caller's memory is written in place
+typedef py::array_t<uint8_t, py::array::c_style> OutByteArray;
+typedef py::array_t<int32_t, py::array::c_style> OutIntArray;
+typedef py::array_t<float, py::array::c_style> OutFloatArray;
+typedef py::array_t<bool, py::array::c_style> OutBoolArray;
+typedef py::array_t<uint64_t, py::array::c_style | py::array::forcecast> SlotArray;
+typedef py::array_t<float, py::array::c_style | py::array::forcecast> FloatArray;
+
+/*
+  Check that an array holds count elements of the given size
+*/
+template <typename Array>
+void checkSize(const Array &array, size_t count, size_t element_size, const char *name)
+{
+  if ((size_t)array.size() != count * element_size)
+  {
+    throw py::value_error(std::string(name) + " has " + std::to_string(array.size()) + " elements, expected " +
+                          std::to_string(count * element_size));
+  }
+}
+
+template <typename Array>
+const typename Array::value_type *inputData(const Array &array, size_t count, size_t element_size, const char *name)
+{
+  checkSize(array, count, element_size, name);
+  return array.data();
+}
+
+template <typename Array>
+typename Array::value_type *outputData(Array &array, size_t count, size_t element_size, const char *name)
+{
+  checkSize(array, count, element_size, name);
+  return array.mutable_data();
+}
+
+template <typename Buffer>
+py::array_t<uint8_t> observations(size_t count, const Buffer &buffer)
+{
+  return py::array_t<uint8_t>(std::vector<ssize_t>{ (ssize_t)count, buffer.getHeight(), buffer.getWidth(),
+                                                         buffer.getDepth() });
+}
+
+/*
+  Methods shared by the buffers: sampling, access by position and sizes
+*/
+template <typename Buffer>
+void bindSampling(py::class_<Buffer> &buffer)
+{
+  buffer
+      .def("sample",
+           [](Buffer &self, size_t batch_size) {
+             py::array_t<uint8_t> images_t = observations(batch_size, self);
+             py::array_t<int32_t> actions(batch_size);
+             py::array_t<float> rewards(batch_size);
+             py::array_t<uint8_t> images_t1 = observations(batch_size, self);
+             py::array_t<bool> dones(batch_size);
+             uint8_t *images_t_data = images_t.mutable_data();
+             int32_t *actions_data = actions.mutable_data();
+             float *rewards_data = rewards.mutable_data();
+             uint8_t *images_t1_data = images_t1.mutable_data();
+             uint8_t *dones_data = reinterpret_cast<uint8_t *>(dones.mutable_data());
+             bool sampled;
+             {
+               py::gil_scoped_release release;
+               sampled = self.sample(batch_size, images_t_data, actions_data, rewards_data, images_t1_data, dones_data);
+             }
+             if (sampled == false)
+             {
+               throw py::value_error("a batch of experience can be returned only if n < buffer_size");
+             }
+             return py::make_tuple(images_t, actions, rewards, images_t1, dones);
+           },
+           py::arg("batch_size"), "Uniform sampling without replacement, returns (images_t, actions, rewards, "
+                                  "images_t1, dones) arrays")
+      .def("sample_into",
+           [](Buffer &self, OutByteArray images_t, OutIntArray actions, OutFloatArray rewards,
+              OutByteArray images_t1, OutBoolArray dones) {
+             const size_t batch_size = actions.size();
+             int32_t *actions_data = actions.mutable_data();
+             const size_t size = self.getObservationSize();
+             uint8_t *images_t_data = outputData(images_t, batch_size, size, "images_t");
+             float *rewards_data = outputData(rewards, batch_size, 1, "rewards");
+             uint8_t *images_t1_data = outputData(images_t1, batch_size, size, "images_t1");
+             uint8_t *dones_data = reinterpret_cast<uint8_t *>(outputData(dones, batch_size, 1, "dones"));
+             py::gil_scoped_release release;
+             return self.sample(batch_size, images_t_data, actions_data, rewards_data, images_t1_data,
+                                dones_data);
+           },
+           py::arg("images_t").noconvert(), py::arg("actions").noconvert(), py::arg("rewards").noconvert(),
+           py::arg("images_t1").noconvert(), py::arg("dones").noconvert(),
+           "Uniform sampling into preallocated C-contiguous arrays (uint8, int32, float32, uint8, bool), the batch "
+           "size is the length of actions")
+      .def("get",
+           [](const Buffer &self, size_t position) {
+             if (position >= self.getSize())
+             {
+               throw py::index_error("position out of range");
+             }
+             py::array_t<uint8_t> image_t(std::vector<ssize_t>{ self.getHeight(), self.getWidth(), self.getDepth() });
+             py::array_t<uint8_t> image_t1(std::vector<ssize_t>{ self.getHeight(), self.getWidth(), self.getDepth() });
+             int32_t action;
+             float reward;
+             uint8_t done;
+             self.gather(&position, 1, image_t.mutable_data(), &action, &reward, image_t1.mutable_data(), &done);
+             return py::make_tuple(image_t, action, reward, image_t1, done != 0);
+           },
+           py::arg("position"), "Transition at the given position, 0 is the oldest")
+      .def("seed", &Buffer::seed)
+      .def("clear", &Buffer::clear)
+      .def("__len__", &Buffer::getSize)
+      .def_property_readonly("capacity", &Buffer::getCapacity)
+      .def_property_readonly("shape", [](const Buffer &self) {
+        return py::make_tuple(self.getHeight(), self.getWidth(), self.getDepth());
+      })
+      .def_property_readonly("nbytes", &Buffer::getByteSize);
+}
+
+/*
+  Storage holding the transitions of a buffer, where the shape is read
+*/
+template <typename Buffer>
+const Buffer &storageOf(const Buffer &buffer)
+{
+  return buffer;
+}
+
+template <typename Storage>
+const Storage &storageOf(const PrioritizedReplayBuffer<Storage> &buffer)
+{
+  return buffer.getStorage();
+}
+
+/*
+  Copy the transition at a position of a buffer, 0 is the oldest
+*/
+template <typename Buffer>
+void transitionAt(const Buffer &buffer, size_t position, uint8_t *image_t, int32_t *action, float *reward,
+                  uint8_t *image_t1, uint8_t *done)
+{
+  buffer.gather(&position, 1, image_t, action, reward, image_t1, done);
+}
+
+void transitionAt(const StratifiedReplayBuffer &buffer, size_t position, uint8_t *image_t, int32_t *action,
+                  float *reward, uint8_t *image_t1, uint8_t *done)
+{
+  size_t slot = buffer.getSlot(position);
+  buffer.gather(&slot, 1, image_t, action, reward, image_t1, done);
+}
+
+template <typename Storage>
+void transitionAt(const PrioritizedReplayBuffer<Storage> &buffer, size_t position, uint8_t *image_t, int32_t *action,
+                  float *reward, uint8_t *image_t1, uint8_t *done)
+{
+  transitionAt(buffer.getStorage(), position, image_t, action, reward, image_t1, done);
+}
+
+/*
+  Loading from and saving to replay files, the transitions are copied without going through Python
+*/
+template <typename Buffer>
+void bindFiles(py::class_<Buffer> &buffer)
+{
+  buffer
+      .def("extend",
+           [](Buffer &self, const ReplayFile &file) {
+             const auto &storage = storageOf(self);
+             if (file.getHeight() != storage.getHeight() || file.getWidth() != storage.getWidth() ||
+                 file.getDepth() != storage.getDepth())
+             {
+               throw py::value_error("the observations of the replay file have a different shape");
+             }
+             size_t rejected = 0;
+             {
+               py::gil_scoped_release release;
+               for (size_t i = 0; i < file.getSize(); i++)
+               {
+                 if (self.add(file.getImageT(i), file.getAction(i), file.getReward(i), file.getImageT1(i),
+                              file.getDone(i)) == false)
+                 {
+                   rejected++;
+                 }
+               }
+             }
+             if (rejected > 0)
+             {
+               throw py::value_error(std::to_string(rejected) + " transitions have image_t1 that is not image_t "
+                                                                "shifted by one frame");
+             }
+           },
+           py::arg("replay_file"), "Add every transition of a ReplayFile, oldest first")
+      .def("save",
+           [](const Buffer &self, const std::string &path, uint32_t user_flags, uint32_t chunk_size) {
+             const auto &storage = storageOf(self);
+             ReplayFileWriter writer;
+             if (writer.open(path, storage.getHeight(), storage.getWidth(), storage.getDepth(), chunk_size, true) ==
+                 false)
+             {
+               throw py::value_error("cannot create the replay file " + path);
+             }
+             writer.setUserFlags(user_flags);
+             std::vector<uint8_t> image_t(storage.getObservationSize()), image_t1(storage.getObservationSize());
+             bool written = true;
+             {
+               py::gil_scoped_release release;
+               for (size_t i = 0; i < storage.getSize() && written; i++)
+               {
+                 int32_t action;
+                 float reward;
+                 uint8_t done;
+                 transitionAt(self, i, image_t.data(), &action, &reward, image_t1.data(), &done);
+                 written = writer.append(image_t.data(), action, reward, image_t1.data(), done != 0);
+               }
+               writer.close();
+             }
+             if (written == false)
+             {
+               throw py::value_error("cannot write the replay file " + path);
+             }
+           },
+           py::arg("path"), py::arg("user_flags") = 0, py::arg("chunk_size") = 1024,
+           "Write the transitions to a replay file, oldest first");
+}
+
+/*
+  Read-only array over memory of a ReplayFile, the file is kept open while the array is alive
+*/
+py::array fileView(const py::object &owner, py::dtype dtype, std::vector<ssize_t> shape, const uint8_t *data)
+{
+  py::array view(dtype, shape, std::vector<ssize_t>(), data, owner);
+  view.attr("setflags")(py::arg("write") = false);
+  return view;
+}
+
+/*
+  Prioritised replay over one of the storages
+*/
+template <typename Storage>
+void bindPrioritized(py::module &m, const char *name)
+{
+  typedef PrioritizedReplayBuffer<Storage> Buffer;
+  py::class_<Buffer> buffer(m, name);
+  buffer
+      .def(py::init<size_t, int, int, int, double, double, uint64_t>(), py::arg("capacity"), py::arg("height") = 84,
+           py::arg("width") = 84, py::arg("depth") = 4, py::arg("alpha") = 0.6, py::arg("epsilon") = 1e-6,
+           py::arg("seed") = 0)
+      .def("add",
+           [](Buffer &self, ByteArray image_t, int32_t action, float reward, ByteArray image_t1, bool done) {
+             const size_t size = self.getStorage().getObservationSize();
+             if (self.add(inputData(image_t, 1, size, "image_t"), action, reward,
+                          inputData(image_t1, 1, size, "image_t1"), done) == false)
+             {
+               throw py::value_error("image_t1 is not image_t shifted by one frame");
+             }
+           },
+           py::arg("image_t"), py::arg("action"), py::arg("reward"), py::arg("image_t1"), py::arg("done"),
+           "Add a transition with the largest priority seen so far")
+      .def("sample",
+           [](Buffer &self, size_t batch_size, double beta) {
+             const Storage &storage = self.getStorage();
+             py::array_t<uint8_t> images_t = observations(batch_size, storage);
+             py::array_t<int32_t> actions(batch_size);
+             py::array_t<float> rewards(batch_size);
+             py::array_t<uint8_t> images_t1 = observations(batch_size, storage);
+             py::array_t<bool> dones(batch_size);
+             py::array_t<float> weights(batch_size);
+             // Slot and write count of each sample
+             py::array_t<uint64_t> slots(std::vector<ssize_t>{ (ssize_t)batch_size, 2 });
+             uint8_t *images_t_data = images_t.mutable_data();
+             int32_t *actions_data = actions.mutable_data();
+             float *rewards_data = rewards.mutable_data();
+             uint8_t *images_t1_data = images_t1.mutable_data();
+             uint8_t *dones_data = reinterpret_cast<uint8_t *>(dones.mutable_data());
+             float *weights_data = weights.mutable_data();
+             std::vector<size_t> sampled_slots(batch_size);
+             std::vector<uint64_t> writes(batch_size);
+             bool sampled;
+             {
+               py::gil_scoped_release release;
+               sampled = self.sample(batch_size, beta, images_t_data, actions_data, rewards_data, images_t1_data,
+                                     dones_data, weights_data, sampled_slots.data(), writes.data());
+             }
+             if (sampled == false)
+             {
+               throw py::value_error("the buffer is empty");
+             }
+             uint64_t *slots_data = slots.mutable_data();
+             for (size_t i = 0; i < batch_size; i++)
+             {
+               slots_data[2 * i] = sampled_slots[i];
+               slots_data[2 * i + 1] = writes[i];
+             }
+             return py::make_tuple(images_t, actions, rewards, images_t1, dones, weights, slots);
+           },
+           py::arg("batch_size"), py::arg("beta") = 0.4,
+           "Proportional sampling, returns (images_t, actions, rewards, images_t1, dones, weights, slots), slots "
+           "holding the slot and the write count of each sample")
+      .def("update_priorities",
+           [](Buffer &self, SlotArray slots, FloatArray td_errors) {
+             const size_t count = td_errors.size();
+             const uint64_t *slots_data = inputData(slots, count, 2, "slots");
+             const float *td_errors_data = inputData(td_errors, count, 1, "td_errors");
+             std::vector<size_t> converted(count);
+             std::vector<uint64_t> writes(count);
+             for (size_t i = 0; i < count; i++)
+             {
+               converted[i] = slots_data[2 * i];
+               writes[i] = slots_data[2 * i + 1];
+             }
+             self.updatePriorities(converted.data(), td_errors_data, count, writes.data());
+           },
+           py::arg("slots"), py::arg("td_errors"),
+           "Set the priorities of the sampled slots from their TD errors, except those written since the sampling")
+      .def("get",
+           [](const Buffer &self, size_t position) {
+             const Storage &storage = self.getStorage();
+             if (position >= storage.getSize())
+             {
+               throw py::index_error("position out of range");
+             }
+             py::array_t<uint8_t> image_t(std::vector<ssize_t>{ storage.getHeight(), storage.getWidth(), storage.getDepth() });
+             py::array_t<uint8_t> image_t1(std::vector<ssize_t>{ storage.getHeight(), storage.getWidth(), storage.getDepth() });
+             int32_t action;
+             float reward;
+             uint8_t done;
+             storage.gather(&position, 1, image_t.mutable_data(), &action, &reward, image_t1.mutable_data(), &done);
+             return py::make_tuple(image_t, action, reward, image_t1, done != 0);
+           },
+           py::arg("position"), "Transition at the given position, 0 is the oldest")
+      .def("seed", &Buffer::seed)
+      .def("clear", &Buffer::clear)
+      .def("__len__", [](const Buffer &self) { return self.getStorage().getSize(); })
+      .def_property_readonly("capacity", [](const Buffer &self) { return self.getStorage().getCapacity(); })
+      .def_property_readonly("shape",
+                             [](const Buffer &self) {
+                               const Storage &storage = self.getStorage();
+                               return py::make_tuple(storage.getHeight(), storage.getWidth(), storage.getDepth());
+                             })
+      .def_property_readonly("nbytes", &Buffer::getByteSize);  bindFiles(buffer);
+}
+}
+
+PYBIND11_MODULE(drl_replay, m)
+{
+  m.doc() = "Native experience replay buffers for deep reinforced landing";
+
+  py::class_<ReplayBuffer> replay_buffer(m, "ReplayBuffer");
+  replay_buffer
+      .def(py::init<size_t, int, int, int, uint64_t>(), py::arg("capacity"), py::arg("height") = 84,
+           py::arg("width") = 84, py::arg("depth") = 4, py::arg("seed") = 0)
+      .def("add",
+           [](ReplayBuffer &self, ByteArray image_t, int32_t action, float reward, ByteArray image_t1, bool done) {
+             const size_t size = self.getObservationSize();
+             self.add(inputData(image_t, 1, size, "image_t"), action, reward, inputData(image_t1, 1, size, "image_t1"),
+                      done);
+           },
+           py::arg("image_t"), py::arg("action"), py::arg("reward"), py::arg("image_t1"), py::arg("done"));
+  bindSampling(replay_buffer);
+  bindFiles(replay_buffer);
+
+  py::enum_<FrameCodec>(m, "FrameCodec")
+      .value("RAW", FRAME_RAW)
+      .value("LZ4", FRAME_LZ4)
+      .value("DELTA_LZ4", FRAME_DELTA_LZ4);
+
+  py::class_<FrameReplayBuffer> frame_replay_buffer(m, "FrameReplayBuffer");
+  frame_replay_buffer
+      .def(py::init<size_t, int, int, int, uint64_t, FrameCodec, size_t, int>(), py::arg("capacity"),
+           py::arg("height") = 84, py::arg("width") = 84, py::arg("depth") = 4, py::arg("seed") = 0,
+           py::arg("codec") = FRAME_RAW, py::arg("arena_bytes") = 0, py::arg("threads") = 0,
+           "With a codec the frames are compressed in arena_bytes of memory (0 for a quarter of the raw frames) and "
+           "decoded at sample time by threads workers (0 for one per core)")
+      .def("add",
+           [](FrameReplayBuffer &self, ByteArray image_t, int32_t action, float reward, ByteArray image_t1, bool done) {
+             const size_t size = self.getObservationSize();
+             if (self.add(inputData(image_t, 1, size, "image_t"), action, reward,
+                          inputData(image_t1, 1, size, "image_t1"), done) == false)
+             {
+               throw py::value_error("image_t1 is not image_t shifted by one frame");
+             }
+           },
+           py::arg("image_t"), py::arg("action"), py::arg("reward"), py::arg("image_t1"), py::arg("done"),
+           "Add a transition given as stacks, image_t1 must be image_t shifted by one frame")
+      .def("start_episode",
+           [](FrameReplayBuffer &self, ByteArray frame) {
+             self.startEpisode(inputData(frame, 1, self.getHeight() * self.getWidth(), "frame"));
+           },
+           py::arg("frame"), "Begin an episode with its first height x width frame")
+      .def("add_step",
+           [](FrameReplayBuffer &self, int32_t action, float reward, ByteArray frame_t1, bool done) {
+             if (self.addStep(action, reward, inputData(frame_t1, 1, self.getHeight() * self.getWidth(), "frame_t1"),
+                              done) == false)
+             {
+               throw py::value_error("no episode in progress, call start_episode first");
+             }
+           },
+           py::arg("action"), py::arg("reward"), py::arg("frame_t1"), py::arg("done"),
+           "Add the transition following the last frame of the current episode")
+      .def_property_readonly("codec", &FrameReplayBuffer::getCodec)
+      .def_property_readonly("frame_bytes", &FrameReplayBuffer::getFrameBytes,
+                             "Bytes taken by the frames available, compressed or not");
+  bindSampling(frame_replay_buffer);
+  bindFiles(frame_replay_buffer);
+
+  bindPrioritized<ReplayBuffer>(m, "PrioritizedReplayBuffer");
+  bindPrioritized<FrameReplayBuffer>(m, "PrioritizedFrameReplayBuffer");
+
+  py::class_<StratifiedReplayBuffer> stratified(m, "StratifiedReplayBuffer");
+  stratified.attr("POSITIVE") = (int)StratifiedReplayBuffer::POSITIVE;
+  stratified.attr("NEUTRAL") = (int)StratifiedReplayBuffer::NEUTRAL;
+  stratified.attr("NEGATIVE") = (int)StratifiedReplayBuffer::NEGATIVE;
+  stratified
+      .def(py::init([](py::tuple capacities, int height, int width, int depth, uint64_t seed) {
+             if (capacities.size() != StratifiedReplayBuffer::NUM_CLASSES)
+             {
+               throw py::value_error("capacities are (positive, neutral, negative)");
+             }
+             size_t values[StratifiedReplayBuffer::NUM_CLASSES];
+             for (int c = 0; c < StratifiedReplayBuffer::NUM_CLASSES; c++)
+             {
+               values[c] = capacities[c].cast<size_t>();
+             }
+             return new StratifiedReplayBuffer(values, height, width, depth, seed);
+           }),
+           py::arg("capacities"), py::arg("height") = 84, py::arg("width") = 84, py::arg("depth") = 4,
+           py::arg("seed") = 0, "capacities are the maximum numbers of (positive, neutral, negative) transitions")
+      .def("add",
+           [](StratifiedReplayBuffer &self, ByteArray image_t, int32_t action, float reward, ByteArray image_t1,
+              bool done) {
+             const size_t size = self.getObservationSize();
+             self.add(inputData(image_t, 1, size, "image_t"), action, reward, inputData(image_t1, 1, size, "image_t1"),
+                      done);
+           },
+           py::arg("image_t"), py::arg("action"), py::arg("reward"), py::arg("image_t1"), py::arg("done"),
+           "Add a transition to the class of its reward")
+      .def("sample",
+           [](StratifiedReplayBuffer &self, size_t batch_size, py::tuple mix) {
+             if (mix.size() != StratifiedReplayBuffer::NUM_CLASSES)
+             {
+               throw py::value_error("mix is (positive, neutral, negative)");
+             }
+             double proportions[StratifiedReplayBuffer::NUM_CLASSES];
+             for (int c = 0; c < StratifiedReplayBuffer::NUM_CLASSES; c++)
+             {
+               proportions[c] = mix[c].cast<double>();
+             }
+             py::array_t<uint8_t> images_t = observations(batch_size, self);
+             py::array_t<int32_t> actions(batch_size);
+             py::array_t<float> rewards(batch_size);
+             py::array_t<uint8_t> images_t1 = observations(batch_size, self);
+             py::array_t<bool> dones(batch_size);
+             uint8_t *images_t_data = images_t.mutable_data();
+             int32_t *actions_data = actions.mutable_data();
+             float *rewards_data = rewards.mutable_data();
+             uint8_t *images_t1_data = images_t1.mutable_data();
+             uint8_t *dones_data = reinterpret_cast<uint8_t *>(dones.mutable_data());
+             size_t counts[StratifiedReplayBuffer::NUM_CLASSES];
+             bool sampled;
+             {
+               py::gil_scoped_release release;
+               sampled = self.sample(batch_size, proportions, images_t_data, actions_data, rewards_data,
+                                     images_t1_data, dones_data, counts);
+             }
+             if (sampled == false)
+             {
+               throw py::value_error("the buffer is empty");
+             }
+             return py::make_tuple(images_t, actions, rewards, images_t1, dones,
+                                   py::make_tuple(counts[0], counts[1], counts[2]));
+           },
+           py::arg("batch_size"), py::arg("mix") = py::make_tuple(0.25, 0.5, 0.25),
+           "Sample (positive, neutral, negative) transitions in the given proportions, returns (images_t, actions, "
+           "rewards, images_t1, dones, counts) ordered by class")
+      .def("get",
+           [](const StratifiedReplayBuffer &self, size_t position) {
+             if (position >= self.getSize())
+             {
+               throw py::index_error("position out of range");
+             }
+             py::array_t<uint8_t> image_t(std::vector<ssize_t>{ self.getHeight(), self.getWidth(), self.getDepth() });
+             py::array_t<uint8_t> image_t1(std::vector<ssize_t>{ self.getHeight(), self.getWidth(), self.getDepth() });
+             int32_t action;
+             float reward;
+             uint8_t done;
+             size_t slot = self.getSlot(position);
+             self.gather(&slot, 1, image_t.mutable_data(), &action, &reward, image_t1.mutable_data(), &done);
+             return py::make_tuple(image_t, action, reward, image_t1, done != 0);
+           },
+           py::arg("position"), "Transition at the given position: positives, neutrals and then negatives")
+      .def("count",
+           [](const StratifiedReplayBuffer &self, int reward_class) {
+             if (reward_class < 0 || reward_class >= StratifiedReplayBuffer::NUM_CLASSES)
+             {
+               throw py::index_error("reward class out of range");
+             }
+             return self.getCount((StratifiedReplayBuffer::RewardClass)reward_class);
+           },
+           py::arg("reward_class"), "Number of transitions of a class, O(1)")
+      .def_static("classify", [](float reward) { return (int)StratifiedReplayBuffer::classify(reward); })
+      .def("seed", &StratifiedReplayBuffer::seed)
+      .def("clear", &StratifiedReplayBuffer::clear)
+      .def("__len__", &StratifiedReplayBuffer::getSize)
+      .def_property_readonly("capacity", &StratifiedReplayBuffer::getCapacity)
+      .def_property_readonly("shape", [](const StratifiedReplayBuffer &self) {
+        return py::make_tuple(self.getHeight(), self.getWidth(), self.getDepth());
+      })
+      .def_property_readonly("nbytes", &StratifiedReplayBuffer::getByteSize);
+  bindFiles(stratified);
+
+  py::class_<ReplayFile> replay_file(m, "ReplayFile");
+  replay_file.attr("CHUNK_COLUMNS") = py::make_tuple("images_t", "images_t1", "actions", "rewards", "dones",
+                                                     "positions");
+  replay_file
+      .def(py::init([](const std::string &path, uint64_t seed) {
+             ReplayFile *file = new ReplayFile();
+             if (file->open(path, seed) == false)
+             {
+               delete file;
+               throw py::value_error(path + " cannot be opened or it is not a replay file");
+             }
+             return file;
+           }),
+           py::arg("path"), py::arg("seed") = 0, "Map a replay file, the transitions committed when it is opened "
+                                                 "are available")
+      .def("sample",
+           [](ReplayFile &self, size_t batch_size) {
+             py::array_t<uint8_t> images_t = observations(batch_size, self);
+             py::array_t<int32_t> actions(batch_size);
+             py::array_t<float> rewards(batch_size);
+             py::array_t<uint8_t> images_t1 = observations(batch_size, self);
+             py::array_t<bool> dones(batch_size);
+             uint8_t *images_t_data = images_t.mutable_data();
+             int32_t *actions_data = actions.mutable_data();
+             float *rewards_data = rewards.mutable_data();
+             uint8_t *images_t1_data = images_t1.mutable_data();
+             uint8_t *dones_data = reinterpret_cast<uint8_t *>(dones.mutable_data());
+             bool sampled;
+             {
+               py::gil_scoped_release release;
+               sampled = self.sample(batch_size, images_t_data, actions_data, rewards_data, images_t1_data, dones_data);
+             }
+             if (sampled == false)
+             {
+               throw py::value_error("a batch of experience can be returned only if n < buffer_size");
+             }
+             return py::make_tuple(images_t, actions, rewards, images_t1, dones);
+           },
+           py::arg("batch_size"), "Uniform sampling without replacement, returns (images_t, actions, rewards, "
+                                  "images_t1, dones) arrays")
+      .def("get",
+           [](const ReplayFile &self, size_t index) {
+             if (index >= self.getSize())
+             {
+               throw py::index_error("index out of range");
+             }
+             py::array_t<uint8_t> image_t(std::vector<ssize_t>{ self.getHeight(), self.getWidth(), self.getDepth() });
+             py::array_t<uint8_t> image_t1(std::vector<ssize_t>{ self.getHeight(), self.getWidth(), self.getDepth() });
+             std::copy(self.getImageT(index), self.getImageT(index) + self.getObservationSize(),
+                       image_t.mutable_data());
+             std::copy(self.getImageT1(index), self.getImageT1(index) + self.getObservationSize(),
+                       image_t1.mutable_data());
+             return py::make_tuple(image_t, self.getAction(index), self.getReward(index), image_t1,
+                                   self.getDone(index));
+           },
+           py::arg("index"), "Transition at the given index, 0 is the oldest")
+      .def("position",
+           [](const ReplayFile &self, size_t index) {
+             if (index >= self.getSize())
+             {
+               throw py::index_error("index out of range");
+             }
+             const float *position = self.getPosition(index);
+             return py::make_tuple(position[0], position[1], position[2]);
+           },
+           py::arg("index"), "Position (x, y, z) of the UAV wrt the marker at t1, NaN when unknown")
+      .def("chunk",
+           [](py::object owner, size_t chunk) {
+             const ReplayFile &self = owner.cast<const ReplayFile &>();
+             if (chunk >= self.getNumChunks())
+             {
+               throw py::index_error("chunk out of range");
+             }
+             const ssize_t rows = std::min(self.getChunkSize(), self.getSize() - chunk * self.getChunkSize());
+             const std::vector<ssize_t> image_shape{ rows, self.getHeight(), self.getWidth(), self.getDepth() };
+             return py::make_tuple(
+                 fileView(owner, py::dtype::of<uint8_t>(), image_shape,
+                          self.getChunkColumn(chunk, ReplayFile::IMAGES_T)),
+                 fileView(owner, py::dtype::of<uint8_t>(), image_shape,
+                          self.getChunkColumn(chunk, ReplayFile::IMAGES_T1)),
+                 fileView(owner, py::dtype::of<int32_t>(), { rows }, self.getChunkColumn(chunk, ReplayFile::ACTIONS)),
+                 fileView(owner, py::dtype::of<float>(), { rows }, self.getChunkColumn(chunk, ReplayFile::REWARDS)),
+                 fileView(owner, py::dtype::of<bool>(), { rows }, self.getChunkColumn(chunk, ReplayFile::DONES)),
+                 fileView(owner, py::dtype::of<float>(), { rows, 3 },
+                          self.getChunkColumn(chunk, ReplayFile::POSITIONS)));
+           },
+           py::arg("chunk"), "Read-only arrays over the columns of a chunk, in the order of CHUNK_COLUMNS (no copy)")
+      .def("seed", &ReplayFile::seed)
+      .def("close", &ReplayFile::close)
+      .def("__len__", &ReplayFile::getSize)
+      .def_property_readonly("num_chunks", &ReplayFile::getNumChunks)
+      .def_property_readonly("chunk_size", &ReplayFile::getChunkSize)
+      .def_property_readonly("user_flags", &ReplayFile::getUserFlags)
+      .def_property_readonly("shape", [](const ReplayFile &self) {
+        return py::make_tuple(self.getHeight(), self.getWidth(), self.getDepth());
+      });
+
+  py::class_<ReplayFileWriter>(m, "ReplayFileWriter")
+      .def(py::init([](const std::string &path, int height, int width, int depth, uint32_t chunk_size,
+                       bool truncate) {
+             ReplayFileWriter *writer = new ReplayFileWriter();
+             if (writer->open(path, height, width, depth, chunk_size, truncate) == false)
+             {
+               delete writer;
+               throw py::value_error(path + " cannot be created or it holds observations of a different shape");
+             }
+             return writer;
+           }),
+           py::arg("path"), py::arg("height") = 84, py::arg("width") = 84, py::arg("depth") = 4,
+           py::arg("chunk_size") = 1024, py::arg("truncate") = false,
+           "Create a replay file or continue an existing one with the same shape")
+      .def("append",
+           [](ReplayFileWriter &self, ByteArray image_t, int32_t action, float reward, ByteArray image_t1, bool done,
+              py::object position) {
+             if (self.isOpen() == false)
+             {
+               throw py::value_error("the replay file is closed");
+             }
+             const size_t size = self.getObservationSize();
+             float xyz[3];
+             if (position.is_none() == false)
+             {
+               py::sequence values = position.cast<py::sequence>();
+               if (values.size() != 3)
+               {
+                 throw py::value_error("position is (x, y, z)");
+               }
+               for (int i = 0; i < 3; i++)
+               {
+                 xyz[i] = values[i].cast<float>();
+               }
+             }
+             if (self.append(inputData(image_t, 1, size, "image_t"), action, reward,
+                             inputData(image_t1, 1, size, "image_t1"), done,
+                             position.is_none() ? NULL : xyz) == false)
+             {
+               throw py::value_error("the replay file cannot grow");
+             }
+           },
+           py::arg("image_t"), py::arg("action"), py::arg("reward"), py::arg("image_t1"), py::arg("done"),
+           py::arg("position") = py::none(), "Append a transition, position is (x, y, z) of the UAV wrt the marker")
+      .def("commit", &ReplayFileWriter::commit, py::arg("sync") = false,
+           "Make the transitions appended so far visible to the readers")
+      .def("close", &ReplayFileWriter::close)
+      .def("__len__", &ReplayFileWriter::getSize)
+      .def("__enter__", [](py::object self) { return self; })
+      .def("__exit__", [](ReplayFileWriter &self, py::args) { self.close(); })
+      .def_property("user_flags", &ReplayFileWriter::getUserFlags, &ReplayFileWriter::setUserFlags);
+}
@@ -0,0 +1,236 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Episode reset without spawning or deleting models.
+*/
+
+#include "../include/resetManager.h"
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include "gazebo_msgs/GetWorldProperties.h"
+#include "gazebo_msgs/SetModelState.h"
+#include "gazebo_msgs/SpawnModel.h"
+
+ResetManager::ResetManager()
+{
+  current_ = -1;
+  park_z_ = -100.0;
+  last_latency_ = total_latency_ = max_latency_ = 0.0;
+  resets_ = 0;
+}
+
+std::string ResetManager::modelName(const std::string &ground)
+{
+  // Same names as the models spawned by test_buffer_architecture.py
+  return ground + "_plane";
+}
+
+gazebo_msgs::ModelState ResetManager::groundState(int ground, bool in_view) const
+{
+  gazebo_msgs::ModelState state;
+  state.model_name = modelName(grounds_[ground]);
+  state.reference_frame = "world";
+  state.pose.position.z = in_view ? 0.0 : park_z_;
+  state.pose.orientation.w = 1.0;
+  return state;
+}
+
+bool ResetManager::init(ros::NodeHandle &nh, const std::vector<std::string> &grounds, const std::string &model_path,
+                        double park_depth, uint64_t seed)
+{
+  set_state_client_ = nh.serviceClient<gazebo_msgs::SetModelState>("/gazebo/set_model_state", true);
+  park_z_ = -fabs(park_depth);
+  // A stream of its own, not the one of the spawns drawn from the same seed
+  generator_.seed(seed ^ 0x9e3779b97f4a7c15ULL);
+  grounds_.clear();
+  current_ = -1;
+  if (grounds.empty())
+  {
+    return true;
+  }
+
+  gazebo_msgs::GetWorldProperties world;
+  if (!ros::service::waitForService("/gazebo/get_world_properties", ros::Duration(10.0)) ||
+      !ros::service::call("/gazebo/get_world_properties", world))
+  {
+    ROS_ERROR("[RESET] Unable to read the models of the world, the ground is never changed");
+    return false;
+  }
+  const std::set<std::string> models(world.response.model_names.begin(), world.response.model_names.end());
+
+  std::string path = model_path;
+  if (path.size() > 0 && path[0] == '~')
+  {
+    const char *home = getenv("HOME");
+    path = std::string(home != NULL ? home : "") + path.substr(1);
+  }
+
+  // The grounds which are not in the world yet are spawned once, already out of view
+  bool preloaded = true;
+  for (size_t i = 0; i < grounds.size(); i++)
+  {
+    grounds_.push_back(grounds[i]);
+    if (models.count(modelName(grounds[i])) > 0)
+    {
+      continue;
+    }
+    std::ifstream file((path + "/" + grounds[i] + "/model.sdf").c_str());
+    std::stringstream sdf;
+    sdf << file.rdbuf();
+    gazebo_msgs::SpawnModel spawn;
+    spawn.request.model_name = modelName(grounds[i]);
+    spawn.request.model_xml = sdf.str();
+    spawn.request.initial_pose = groundState(grounds_.size() - 1, false).pose;
+    spawn.request.reference_frame = "world";
+    if (!file || !ros::service::call("/gazebo/spawn_sdf_model", spawn) || !spawn.response.success)
+    {
+      ROS_ERROR("[RESET] Unable to spawn the ground %s from %s", grounds[i].c_str(), path.c_str());
+      grounds_.pop_back();
+      preloaded = false;
+    }
+  }
+  if (grounds_.empty())
+  {
+    return false;
+  }
+
+  // Those already in the world may be anywhere: park all of them but one
+  const int ground = std::uniform_int_distribution<int>(0, grounds_.size() - 1)(generator_);
+  std::vector<gazebo_msgs::ModelState> states(1, groundState(ground, true));
+  for (size_t i = 0; i < grounds_.size(); i++)
+  {
+    if ((int)i != ground)
+    {
+      states.push_back(groundState(i, false));
+    }
+  }
+  if (apply(states) < states.size())
+  {
+    return false;
+  }
+  current_ = ground;
+  ROS_INFO("[RESET] %zu grounds preloaded, %s in view", grounds_.size(), grounds_[current_].c_str());
+  return preloaded;
+}
+
+size_t ResetManager::apply(const std::vector<gazebo_msgs::ModelState> &states)
+{
+  gazebo_msgs::SetModelState srv;
+  for (size_t i = 0; i < states.size(); i++)
+  {
+    // A persistent client drops the connection when the call fails, reopen it once
+    if (!set_state_client_.isValid())
+    {
+      ros::NodeHandle nh;
+      set_state_client_ = nh.serviceClient<gazebo_msgs::SetModelState>("/gazebo/set_model_state", true);
+    }
+    srv.request.model_state = states[i];
+    if (!set_state_client_.call(srv) || !srv.response.success)
+    {
+      ROS_ERROR("[RESET] Unable to set the state of %s", states[i].model_name.c_str());
+      return i;
+    }
+  }
+  return states.size();
+}
+
+bool ResetManager::reset(const gazebo_msgs::ModelState &quadrotor, int ground)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  ros::WallTime start = ros::WallTime::now();
+
+  if (ground == GROUND_KEEP || grounds_.empty())
+  {
+    ground = current_;
+  }
+  else if (ground == GROUND_RANDOM)
+  {
+    ground = std::uniform_int_distribution<int>(0, grounds_.size() - 1)(generator_);
+  }
+  else if (ground < 0 || ground >= (int)grounds_.size())
+  {
+    ROS_ERROR("[RESET] Ground %d out of the %zu available", ground, grounds_.size());
+    return false;
+  }
+
+  // The new ground comes in first, so that the UAV never flies over the void
+  std::vector<gazebo_msgs::ModelState> states;
+  if (ground != current_)
+  {
+    states.push_back(groundState(ground, true));
+    if (current_ >= 0)
+    {
+      states.push_back(groundState(current_, false));
+    }
+  }
+  states.push_back(quadrotor);
+  const size_t applied = apply(states);
+  const bool success = applied == states.size();
+  if (ground != current_ && applied == 1 && current_ >= 0)
+  {
+    // The new ground is in view but the old one could not be parked: park the new one again, so that only the
+    // ground of current_ stays in view
+    if (apply(std::vector<gazebo_msgs::ModelState>(1, groundState(ground, false))) == 0)
+    {
+      ROS_ERROR("[RESET] %s and %s are both in view", grounds_[ground].c_str(), grounds_[current_].c_str());
+      current_ = ground;
+    }
+  }
+  else if (applied > 0)
+  {
+    // The grounds have been swapped, even if the UAV could not be placed
+    current_ = ground;
+  }
+
+  last_latency_ = (ros::WallTime::now() - start).toSec();
+  total_latency_ += last_latency_;
+  max_latency_ = std::max(max_latency_, last_latency_);
+  resets_++;
+  return success;
+}
+
+std::string ResetManager::getGround()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return current_ >= 0 ? grounds_[current_] : std::string();
+}
+
+size_t ResetManager::getNumGrounds()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return grounds_.size();
+}
+
+double ResetManager::getLastLatency()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_latency_;
+}
+
+double ResetManager::getMeanLatency()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return resets_ > 0 ? total_latency_ / resets_ : 0.0;
+}
+
+double ResetManager::getMaxLatency()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_latency_;
+}
+
+unsigned long ResetManager::getResets()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return resets_;
+}
@@ -0,0 +1,265 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Reward and done of the UAV, selected at run time among the policies of the training scripts.
+*/
+
+#include "../include/rewardEngine.h"
+#include "../include/actions.h"
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+namespace
+{
+const char *const POLICY_NAMES[NUM_REWARD_POLICIES] = { "flight_box", "landing_box", "landing_altitude",
+                                                         "land_action" };
+
+// Wrong altitudes (exclusive bounds) indexed by the integer part of the altitude, the thresholds of the chain of
+// conditions of the former Utilities::assignRewardWithoutFlightBB
+const int NUM_ALTITUDE_BANDS = 16;
+const double WRONG_ALTITUDE_BANDS[NUM_ALTITUDE_BANDS][2] = {
+  { 0.0, 0.0 },   { 0.0, 0.0 },   { 2.3, 2.8 },   { 3.3, 3.8 },   { 4.3, 4.8 },   { 5.3, 5.8 },
+  { 6.3, 6.8 },   { 7.3, 7.8 },   { 8.3, 8.8 },   { 9.3, 9.8 },   { 10.3, 10.8 }, { 11.3, 11.8 },
+  { 12.3, 12.8 }, { 13.3, 13.8 }, { 14.3, 14.8 }, { 15.3, std::numeric_limits<double>::infinity() }
+};
+
+// Transitions relabelled at a time, the columns of a block stay in the L1 cache
+const size_t BLOCK_SIZE = 256;
+
+inline bool inside(const RewardBox &box, double x, double y, double z)
+{
+  return x >= box.min_x && x <= box.max_x && y >= box.min_y && y <= box.max_y && z >= box.min_z && z <= box.max_z;
+}
+
+RewardBox boxAround(double x, double y, double z, double half_size, double height)
+{
+  RewardBox box = { x - half_size, x + half_size, y - half_size, y + half_size, z, z + height };
+  return box;
+}
+
+void evaluateFlightBox(const RewardEngine &engine, double x, double y, double z, int32_t,
+                       RewardOutcome *outcome)
+{
+  const RewardConfig &config = engine.getConfig();
+  outcome->wrong_altitude = false;
+  if (inside(engine.getFlightBox(), x, y, z) == false)
+  {
+    outcome->reward = config.failure_reward;
+    outcome->done = true;
+    return;
+  }
+  outcome->done = inside(engine.getLandingBox(), x, y, z);
+  outcome->reward = outcome->done ? config.success_reward : config.step_reward;
+}
+
+void evaluateLandingBox(const RewardEngine &engine, double x, double y, double z, int32_t,
+                        RewardOutcome *outcome)
+{
+  const RewardConfig &config = engine.getConfig();
+  outcome->wrong_altitude = false;
+  outcome->done = inside(engine.getLandingBox(), x, y, z);
+  outcome->reward = outcome->done ? config.success_reward : config.step_reward;
+}
+
+void evaluateLandingAltitude(const RewardEngine &engine, double x, double y, double z, int32_t,
+                             RewardOutcome *outcome)
+{
+  const RewardConfig &config = engine.getConfig();
+  const RewardBox &box = engine.getLandingBox();
+  outcome->wrong_altitude = RewardEngine::isWrongAltitude(z);
+  outcome->done = z >= box.min_z && z <= box.max_z;
+  if (outcome->done == false)
+  {
+    outcome->reward = config.step_reward;
+    return;
+  }
+  outcome->reward = inside(box, x, y, z) ? config.success_reward : config.failure_reward;
+}
+
+void evaluateLandAction(const RewardEngine &engine, double x, double y, double z, int32_t action,
+                        RewardOutcome *outcome)
+{
+  const RewardConfig &config = engine.getConfig();
+  outcome->wrong_altitude = false;
+  outcome->reward = config.step_reward;
+  outcome->done = false;
+  if (action == ACTION_LAND)
+  {
+    outcome->reward = inside(engine.getLandingBox(), x, y, z) ? config.success_reward : config.failure_reward;
+    outcome->done = true;
+  }
+  // Too low above the marker (the bottom of the landing box), the episode is over
+  if (z - engine.getLandingBox().min_z <= config.min_altitude)
+  {
+    outcome->reward = config.failure_reward;
+    outcome->done = true;
+  }
+}
+
+const RewardEngine::Evaluator EVALUATORS[NUM_REWARD_POLICIES] = { evaluateFlightBox, evaluateLandingBox,
+                                                                  evaluateLandingAltitude, evaluateLandAction };
+}
+
+RewardConfig::RewardConfig()
+{
+  policy = REWARD_LAND_ACTION;
+  landing_half_size = 1.5;
+  landing_height = 3.0;
+  flight_half_size = 6.5;
+  flight_height = 20.0;
+  step_reward = -0.01f;
+  success_reward = 1.0f;
+  failure_reward = -1.0f;
+  min_altitude = 0.3;
+}
+
+RewardEngine::RewardEngine(const RewardConfig &config)
+{
+  config_ = config;
+  evaluator_ = EVALUATORS[config.policy];
+  setMarker(0.0, 0.0, 0.0);
+}
+
+void RewardEngine::setMarker(double x, double y, double z)
+{
+  landing_ = boxAround(x, y, z, config_.landing_half_size, config_.landing_height);
+  flight_ = boxAround(x, y, z, config_.flight_half_size, config_.flight_height);
+}
+
+bool RewardEngine::isWrongAltitude(double z)
+{
+  if (!(z >= 0.0))
+  {
+    return false;
+  }
+  const double *band = WRONG_ALTITUDE_BANDS[z < NUM_ALTITUDE_BANDS ? (int)z : NUM_ALTITUDE_BANDS - 1];
+  return z > band[0] && z < band[1];
+}
+
+size_t RewardEngine::relabel(const float *positions, const int32_t *actions, size_t count, float *rewards,
+                             uint8_t *dones) const
+{
+  const RewardBox l = boxAround(0.0, 0.0, 0.0, config_.landing_half_size, config_.landing_height);
+  const RewardBox f = boxAround(0.0, 0.0, 0.0, config_.flight_half_size, config_.flight_height);
+  const float l_min_x = l.min_x, l_max_x = l.max_x, l_min_y = l.min_y, l_max_y = l.max_y, l_min_z = l.min_z,
+              l_max_z = l.max_z;
+  const float f_min_x = f.min_x, f_max_x = f.max_x, f_min_y = f.min_y, f_max_y = f.max_y, f_min_z = f.min_z,
+              f_max_z = f.max_z;
+  const float step = config_.step_reward, success = config_.success_reward, failure = config_.failure_reward;
+  const float min_altitude = config_.min_altitude;
+
+  float x[BLOCK_SIZE], y[BLOCK_SIZE], z[BLOCK_SIZE], reward[BLOCK_SIZE];
+  int32_t in_landing_xy[BLOCK_SIZE], in_landing_z[BLOCK_SIZE], in_flight[BLOCK_SIZE], known[BLOCK_SIZE];
+  int32_t done[BLOCK_SIZE];
+  size_t relabelled = 0;
+  for (size_t first = 0; first < count; first += BLOCK_SIZE)
+  {
+    const size_t n = std::min(BLOCK_SIZE, count - first);
+    const float *p = positions + 3 * first;
+    for (size_t i = 0; i < n; i++)
+    {
+      x[i] = p[3 * i];
+      y[i] = p[3 * i + 1];
+      z[i] = p[3 * i + 2];
+    }
+
+    // Box containment as masks, every comparison with NaN is false
+    for (size_t i = 0; i < n; i++)
+    {
+      in_landing_xy[i] = (x[i] >= l_min_x) & (x[i] <= l_max_x) & (y[i] >= l_min_y) & (y[i] <= l_max_y);
+      in_landing_z[i] = (z[i] >= l_min_z) & (z[i] <= l_max_z);
+      in_flight[i] = (x[i] >= f_min_x) & (x[i] <= f_max_x) & (y[i] >= f_min_y) & (y[i] <= f_max_y) &
+                     (z[i] >= f_min_z) & (z[i] <= f_max_z);
+      known[i] = (x[i] == x[i]) & (y[i] == y[i]) & (z[i] == z[i]);
+    }
+
+    switch (config_.policy)
+    {
+      case REWARD_FLIGHT_BOX:
+        for (size_t i = 0; i < n; i++)
+        {
+          const int32_t in_landing = in_landing_xy[i] & in_landing_z[i];
+          reward[i] = in_flight[i] ? (in_landing ? success : step) : failure;
+          done[i] = (in_flight[i] ^ 1) | in_landing;
+        }
+        break;
+      case REWARD_LANDING_BOX:
+        for (size_t i = 0; i < n; i++)
+        {
+          const int32_t in_landing = in_landing_xy[i] & in_landing_z[i];
+          reward[i] = in_landing ? success : step;
+          done[i] = in_landing;
+        }
+        break;
+      case REWARD_LANDING_ALTITUDE:
+        for (size_t i = 0; i < n; i++)
+        {
+          reward[i] = in_landing_z[i] ? (in_landing_xy[i] ? success : failure) : step;
+          done[i] = in_landing_z[i];
+        }
+        break;
+      default:
+      {
+        const int32_t *a = actions + first;
+        for (size_t i = 0; i < n; i++)
+        {
+          const int32_t land = a[i] == ACTION_LAND, low = z[i] <= min_altitude;
+          const int32_t in_landing = in_landing_xy[i] & in_landing_z[i];
+          reward[i] = low ? failure : land ? (in_landing ? success : failure) : step;
+          done[i] = land | low;
+        }
+        break;
+      }
+    }
+
+    float *r = rewards + first;
+    uint8_t *d = dones + first;
+    for (size_t i = 0; i < n; i++)
+    {
+      r[i] = known[i] ? reward[i] : r[i];
+      d[i] = known[i] ? (uint8_t)done[i] : d[i];
+      relabelled += known[i];
+    }
+  }
+  return relabelled;
+}
+
+const RewardConfig &RewardEngine::getConfig() const
+{
+  return config_;
+}
+
+const RewardBox &RewardEngine::getLandingBox() const
+{
+  return landing_;
+}
+
+const RewardBox &RewardEngine::getFlightBox() const
+{
+  return flight_;
+}
+
+bool parseRewardPolicy(const std::string &name, RewardPolicy *policy)
+{
+  for (int p = 0; p < NUM_REWARD_POLICIES; p++)
+  {
+    if (name == POLICY_NAMES[p])
+    {
+      *policy = static_cast<RewardPolicy>(p);
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *rewardPolicyName(RewardPolicy policy)
+{
+  return policy >= 0 && policy < NUM_REWARD_POLICIES ? POLICY_NAMES[policy] : "";
+}
@@ -0,0 +1,136 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  POSIX shared-memory ring publishing the observation of every tick to readers on the same host.
+*/
+
+#include "../include/sharedMemoryChannel.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(SharedMemoryChannel::Header) == 64, "the header layout is shared with the readers");
+static_assert(sizeof(SharedMemoryChannel::Slot) == 128, "the slot layout is shared with the readers");
+
+SharedMemoryChannel::SharedMemoryChannel()
+{
+  fd_ = -1;
+  memory_ = NULL;
+  size_ = 0;
+  header_ = NULL;
+  frame_size_ = 0;
+  writing_ = NULL;
+}
+
+SharedMemoryChannel::~SharedMemoryChannel()
+{
+  close();
+}
+
+bool SharedMemoryChannel::open(const std::string &name, int height, int width, int depth, int slots)
+{
+  close();
+  if (height <= 0 || width <= 0 || depth <= 0 || slots < 2)
+  {
+    return false;
+  }
+
+  frame_size_ = height * width * depth;
+  uint32_t slot_size = (sizeof(Slot) + frame_size_ + 63) / 64 * 64;
+  size_ = sizeof(Header) + (size_t)slot_size * slots;
+
+  // Replace a stale object left by a previous run, readers still mapping it keep their copy
+  shm_unlink(name.c_str());
+  fd_ = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd_ < 0)
+  {
+    return false;
+  }
+  name_ = name;
+  if (ftruncate(fd_, size_) != 0)
+  {
+    close();
+    return false;
+  }
+  memory_ = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (memory_ == MAP_FAILED)
+  {
+    memory_ = NULL;
+    close();
+    return false;
+  }
+
+  // The object is zero-filled: every slot starts with sequence 0 and nothing is published yet
+  header_ = static_cast<Header *>(memory_);
+  header_->version = VERSION;
+  header_->slots = slots;
+  header_->height = height;
+  header_->width = width;
+  header_->depth = depth;
+  header_->slot_size = slot_size;
+  // The magic is written last, readers wait for it before trusting the header
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(header_->magic, "DRLSHM1", 8);
+  return true;
+}
+
+void SharedMemoryChannel::close()
+{
+  if (memory_ != NULL)
+  {
+    munmap(memory_, size_);
+    memory_ = NULL;
+  }
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+    shm_unlink(name_.c_str());
+    fd_ = -1;
+  }
+  header_ = NULL;
+  writing_ = NULL;
+}
+
+bool SharedMemoryChannel::isOpen() const
+{
+  return header_ != NULL;
+}
+
+SharedMemoryChannel::Slot *SharedMemoryChannel::slot(uint64_t index)
+{
+  uint8_t *base = static_cast<uint8_t *>(memory_) + sizeof(Header);
+  return reinterpret_cast<Slot *>(base + (index % header_->slots) * header_->slot_size);
+}
+
+uint8_t *SharedMemoryChannel::beginWrite()
+{
+  uint64_t index = header_->published;
+  writing_ = slot(index);
+  // Odd sequence: the slot is being written
+  __atomic_store_n(&writing_->sequence, 2 * index + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  return reinterpret_cast<uint8_t *>(writing_ + 1);
+}
+
+void SharedMemoryChannel::endWrite(uint64_t tick, double stamp, float reward, bool done, bool wrong_altitude,
+                                   const double pose[7])
+{
+  uint64_t index = header_->published;
+  writing_->tick = tick;
+  writing_->stamp = stamp;
+  writing_->reward = reward;
+  writing_->done = done;
+  writing_->wrong_altitude = wrong_altitude;
+  memcpy(writing_->pose, pose, sizeof(writing_->pose));
+  __atomic_store_n(&writing_->sequence, 2 * index + 2, __ATOMIC_RELEASE);
+  __atomic_store_n(&header_->published, index + 1, __ATOMIC_RELEASE);
+  writing_ = NULL;
+}
@@ -0,0 +1,135 @@
+#!/usr/bin/env python
+
+# The MIT License (MIT)
+# Copyright (c) 2017 Riccardo Polvara
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+# INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+# FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+# OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+#
+# Reader of the shared-memory ring published by drl_services_node when the parameter
+# /drl_node/shared_memory_name is set (see include/sharedMemoryChannel.h for the layout).
+# The frame stack and the pose are returned as numpy views over the mapped memory: no copy
+# and no ROS serialization. A view stays valid until the node has published slots - 1 further
+# observations, call is_valid() after using it (or use copy=True).
+#
+# Example:
+#   reader = SharedMemoryReader('/drl_observation')
+#   observation = reader.wait_next()
+#   q_values = sess.run(q, feed_dict={x: observation.image[np.newaxis]})
+#   if not reader.is_valid(observation): ...
+
+import collections
+import mmap
+import os
+import time
+import numpy as np
+
+Observation = collections.namedtuple('Observation', ['index', 'sequence', 'tick', 'stamp', 'reward',
+                                                     'done', 'wrong_altitude', 'pose', 'image'])
+
+
+class SharedMemoryReader(object):
+    """Class SharedMemoryReader
+
+    Map the observation ring of the services node and read the latest
+    observation through the per-slot sequence numbers (seqlock).
+    """
+
+    HEADER_SIZE = 64
+    SLOT_HEADER_SIZE = 128
+
+    def __init__(self, name='/drl_observation', timeout=10.0):
+        """Map the ring, waiting for the node to create it.
+
+        @param name the POSIX name given to /drl_node/shared_memory_name
+        @param timeout seconds to wait for the node
+        """
+        path = '/dev/shm/' + name.lstrip('/')
+        deadline = time.time() + timeout
+        while True:
+            try:
+                with open(path, 'rb') as f:
+                    self.memory = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+                if self.memory[0:8] == b'DRLSHM1\0':
+                    break
+                self.memory.close()
+            except (IOError, OSError, ValueError):
+                pass
+            if time.time() > deadline:
+                raise IOError("[SHARED MEMORY READER][ERROR] " + path + " not available")
+            time.sleep(0.01)
+
+        header = np.frombuffer(self.memory, dtype='<u4', count=6, offset=8)
+        if header[0] != 1:
+            raise IOError("[SHARED MEMORY READER][ERROR] unsupported version " + str(header[0]))
+        self.slots = int(header[1])
+        self.shape = (int(header[2]), int(header[3]), int(header[4]))
+        slot_size = int(header[5])
+        self.published = np.frombuffer(self.memory, dtype='<u8', count=1, offset=32)
+
+        slot_dtype = np.dtype({'names': ['sequence', 'tick', 'stamp', 'reward', 'done', 'wrong_altitude',
+                                         'pose', 'image'],
+                               'formats': ['<u8', '<u8', '<f8', '<f4', 'u1', 'u1', ('<f8', (7,)),
+                                           ('u1', self.shape)],
+                               'offsets': [0, 8, 16, 24, 28, 29, 32, self.SLOT_HEADER_SIZE],
+                               'itemsize': slot_size})
+        self.ring = np.ndarray((self.slots,), dtype=slot_dtype, buffer=self.memory, offset=self.HEADER_SIZE)
+        self.sequence = self.ring['sequence']
+
+    def latest(self, copy=False):
+        """Return the latest observation.
+
+        @param copy when True the image and the pose are copied (and checked) before returning
+        @return an Observation, None if nothing has been published yet
+        """
+        while True:
+            published = int(self.published[0])
+            if published == 0:
+                return None
+            index = (published - 1) % self.slots
+            sequence = int(self.sequence[index])
+            if sequence != 2 * published:
+                # The writer is already reusing the slot, look again at the latest one
+                continue
+            slot = self.ring[index]
+            pose = slot['pose']
+            image = slot['image']
+            if copy:
+                pose = pose.copy()
+                image = image.copy()
+            observation = Observation(index, sequence, int(slot['tick']), float(slot['stamp']),
+                                      float(slot['reward']), bool(slot['done']), bool(slot['wrong_altitude']),
+                                      pose, image)
+            if self.is_valid(observation):
+                return observation
+
+    def wait_next(self, observation=None, timeout=1.0, copy=False):
+        """Return the first observation published after the given one.
+
+        @param observation the last observation used, None to wait for any observation
+        @param timeout seconds to wait
+        @return an Observation, None on timeout
+        """
+        last = 0 if observation is None else observation.sequence // 2
+        deadline = time.time() + timeout
+        while int(self.published[0]) <= last:
+            if time.time() > deadline:
+                return None
+            time.sleep(0.0002)
+        return self.latest(copy)
+
+    def is_valid(self, observation):
+        """Check that the slot of an observation has not been overwritten.
+
+        @param observation returned by latest() or wait_next()
+        @return True if the views of the observation still hold its data
+        """
+        return int(self.sequence[observation.index]) == observation.sequence
+
+    def close(self):
+        self.ring = self.sequence = self.published = None
+        self.memory.close()
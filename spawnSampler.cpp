@@ -0,0 +1,178 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Poses at which the UAV is respawned, drawn from a long-lived xoshiro256** stream.
+*/
+
+#include "../include/spawnSampler.h"
+#include <algorithm>
+#include <math.h>
+#include <sstream>
+
+void Xoshiro256::seed(uint64_t seed)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    seed += 0x9e3779b97f4a7c15ULL;
+    uint64_t z = seed;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    state_[i] = z ^ (z >> 31);
+  }
+}
+
+void Xoshiro256::jump()
+{
+  static const uint64_t JUMP[4] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL,
+                                    0x39abdc4529b1661cULL };
+  uint64_t state[4] = { 0, 0, 0, 0 };
+  for (int i = 0; i < 4; i++)
+  {
+    for (int b = 0; b < 64; b++)
+    {
+      if (JUMP[i] & (1ULL << b))
+      {
+        for (int k = 0; k < 4; k++)
+        {
+          state[k] ^= state_[k];
+        }
+      }
+      (*this)();
+    }
+  }
+  std::copy(state, state + 4, state_);
+}
+
+SpawnConfig::SpawnConfig()
+{
+  xy_gaussian = false;
+  xy_mean = 0.0;
+  xy_stdev = 1.0;
+  xy_half_size = 1.5;
+  z_bands = 1;
+  z_from = z_to = 20.0;
+  z_from_2 = z_to_2 = 20.0;
+}
+
+bool SpawnConfig::validate(std::string *error) const
+{
+  std::ostringstream reason;
+  if (z_bands != 1 && z_bands != 2)
+  {
+    reason << z_bands << " altitude bands, 1 or 2 expected";
+  }
+  else if (xy_gaussian && !(xy_stdev > 0.0))
+  {
+    reason << "xy stdev " << xy_stdev << ", a positive value expected";
+  }
+  else if (!xy_gaussian && !(xy_half_size >= 0.0))
+  {
+    reason << "xy half size " << xy_half_size << ", a non-negative value expected";
+  }
+  else if (!(z_from <= z_to))
+  {
+    reason << "altitude band [" << z_from << ", " << z_to << "] is empty";
+  }
+  else if (z_bands == 2 && !(z_from_2 <= z_to_2))
+  {
+    reason << "second altitude band [" << z_from_2 << ", " << z_to_2 << "] is empty";
+  }
+  if (reason.str().empty())
+  {
+    return true;
+  }
+  if (error != NULL)
+  {
+    *error = reason.str();
+  }
+  return false;
+}
+
+SpawnSampler::SpawnSampler(const SpawnConfig &config, uint64_t seed, uint64_t stream, size_t batch_size)
+  : config_(config)
+  , xy_gaussian_(config.xy_mean, config.xy_stdev)
+  , xy_uniform_(-config.xy_half_size, config.xy_half_size)
+  , z_uniform_(config.z_from, config.z_to)
+  , z_uniform_2_(config.z_from_2, config.z_to_2)
+  , yaw_uniform_(-M_PI, M_PI)
+  , second_band_(0.5)
+  , batch_(batch_size)
+  , next_(batch_size)
+  , batch_size_(batch_size)
+{
+  this->seed(seed, stream);
+}
+
+void SpawnSampler::seed(uint64_t seed, uint64_t stream)
+{
+  generator_.seed(seed);
+  for (uint64_t s = 0; s < stream; s++)
+  {
+    generator_.jump();
+  }
+  // The gaussian keeps the second value of every pair it draws
+  xy_gaussian_.reset();
+  next_ = batch_size_;
+}
+
+void SpawnSampler::setConfig(const SpawnConfig &config)
+{
+  config_ = config;
+  xy_gaussian_ = std::normal_distribution<double>(config.xy_mean, config.xy_stdev);
+  xy_uniform_ = std::uniform_real_distribution<double>(-config.xy_half_size, config.xy_half_size);
+  z_uniform_ = std::uniform_real_distribution<double>(config.z_from, config.z_to);
+  z_uniform_2_ = std::uniform_real_distribution<double>(config.z_from_2, config.z_to_2);
+  next_ = batch_size_;
+}
+
+Spawn SpawnSampler::next()
+{
+  if (batch_size_ == 0)
+  {
+    Spawn spawn;
+    sample(&spawn, 1);
+    return spawn;
+  }
+  if (next_ == batch_size_)
+  {
+    sample(&batch_[0], batch_size_);
+    next_ = 0;
+  }
+  return batch_[next_++];
+}
+
+void SpawnSampler::sample(Spawn *spawns, size_t count)
+{
+  // Spawns already drawn ahead come first
+  for (; count > 0 && next_ < batch_size_; count--)
+  {
+    *spawns++ = batch_[next_++];
+  }
+  for (size_t i = 0; i < count; i++)
+  {
+    Spawn &spawn = spawns[i];
+    if (config_.xy_gaussian)
+    {
+      spawn.x = xy_gaussian_(generator_);
+      spawn.y = xy_gaussian_(generator_);
+    }
+    else
+    {
+      spawn.x = xy_uniform_(generator_);
+      spawn.y = xy_uniform_(generator_);
+    }
+    spawn.z = config_.z_bands == 2 && second_band_(generator_) ? z_uniform_2_(generator_) : z_uniform_(generator_);
+    spawn.yaw = yaw_uniform_(generator_);
+  }
+}
+
+const SpawnConfig &SpawnSampler::getConfig() const
+{
+  return config_;
+}
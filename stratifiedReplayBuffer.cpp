@@ -0,0 +1,257 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Experience replay buffer partitioned by reward class over a single allocation.
+*/
+
+#include "../include/stratifiedReplayBuffer.h"
+#include "../include/replayBuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+StratifiedReplayBuffer::StratifiedReplayBuffer(const size_t capacities[NUM_CLASSES], int height, int width, int depth,
+                                               uint64_t seed)
+{
+  height_ = height;
+  width_ = width;
+  depth_ = depth;
+  observation_size_ = (size_t)height * width * depth;
+
+  size_t total = 0;
+  for (int c = 0; c < NUM_CLASSES; c++)
+  {
+    capacity_[c] = capacities[c];
+    offset_[c] = total;
+    total += capacities[c];
+  }
+  images_t_.resize(total * observation_size_);
+  actions_.resize(total);
+  rewards_.resize(total);
+  images_t1_.resize(total * observation_size_);
+  dones_.resize(total);
+
+  generator_.seed(seed);
+  clear();
+}
+
+StratifiedReplayBuffer::~StratifiedReplayBuffer()
+{
+}
+
+StratifiedReplayBuffer::RewardClass StratifiedReplayBuffer::classify(float reward)
+{
+  if (reward > 0.0f)
+  {
+    return POSITIVE;
+  }
+  if (reward <= -1.0f)
+  {
+    return NEGATIVE;
+  }
+  return NEUTRAL;
+}
+
+bool StratifiedReplayBuffer::add(const uint8_t *image_t, int32_t action, float reward, const uint8_t *image_t1,
+                                 bool done)
+{
+  const int c = classify(reward);
+  if (capacity_[c] == 0)
+  {
+    return true;
+  }
+  const size_t s = offset_[c] + next_[c];
+  memcpy(&images_t_[s * observation_size_], image_t, observation_size_);
+  actions_[s] = action;
+  rewards_[s] = reward;
+  memcpy(&images_t1_[s * observation_size_], image_t1, observation_size_);
+  dones_[s] = done;
+
+  next_[c] = (next_[c] + 1) % capacity_[c];
+  if (count_[c] < capacity_[c])
+  {
+    count_[c]++;
+  }
+  return true;
+}
+
+bool StratifiedReplayBuffer::sample(size_t batch_size, const double mix[NUM_CLASSES], uint8_t *images_t,
+                                    int32_t *actions, float *rewards, uint8_t *images_t1, uint8_t *dones,
+                                    size_t *counts)
+{
+  // Proportions of the classes holding transitions
+  double weights[NUM_CLASSES];
+  double total = 0.0;
+  for (int c = 0; c < NUM_CLASSES; c++)
+  {
+    weights[c] = count_[c] > 0 ? std::max(mix[c], 0.0) : 0.0;
+    total += weights[c];
+  }
+  if (total <= 0.0)
+  {
+    // Only classes excluded by the mix are available: sample them uniformly
+    for (int c = 0; c < NUM_CLASSES; c++)
+    {
+      weights[c] = (double)count_[c];
+      total += weights[c];
+    }
+    if (total <= 0.0)
+    {
+      return false;
+    }
+  }
+
+  // Largest remainder apportionment of the batch
+  size_t quota[NUM_CLASSES];
+  double remainder[NUM_CLASSES];
+  size_t assigned = 0;
+  for (int c = 0; c < NUM_CLASSES; c++)
+  {
+    double exact = batch_size * weights[c] / total;
+    quota[c] = (size_t)std::floor(exact);
+    remainder[c] = exact - quota[c];
+    assigned += quota[c];
+  }
+  while (assigned < batch_size)
+  {
+    int best = 0;
+    for (int c = 1; c < NUM_CLASSES; c++)
+    {
+      if (remainder[c] > remainder[best])
+      {
+        best = c;
+      }
+    }
+    quota[best]++;
+    remainder[best] = -1.0;
+    assigned++;
+  }
+
+  std::vector<size_t> slots(batch_size);
+  size_t filled = 0;
+  for (int c = 0; c < NUM_CLASSES; c++)
+  {
+    if (counts != NULL)
+    {
+      counts[c] = quota[c];
+    }
+    if (quota[c] == 0)
+    {
+      continue;
+    }
+    // Positions within the class are offsets from its oldest transition
+    const size_t oldest = (next_[c] + capacity_[c] - count_[c]) % capacity_[c];
+    if (quota[c] <= count_[c])
+    {
+      sampleDistinct(generator_, count_[c], quota[c], &slots[filled], scratch_);
+    }
+    else
+    {
+      std::uniform_int_distribution<size_t> distribution(0, count_[c] - 1);
+      for (size_t i = 0; i < quota[c]; i++)
+      {
+        slots[filled + i] = distribution(generator_);
+      }
+    }
+    for (size_t i = 0; i < quota[c]; i++)
+    {
+      slots[filled + i] = offset_[c] + (oldest + slots[filled + i]) % capacity_[c];
+    }
+    filled += quota[c];
+  }
+
+  gather(slots.data(), batch_size, images_t, actions, rewards, images_t1, dones);
+  return true;
+}
+
+size_t StratifiedReplayBuffer::getSlot(size_t position) const
+{
+  int c = 0;
+  while (c < NUM_CLASSES - 1 && position >= count_[c])
+  {
+    position -= count_[c];
+    c++;
+  }
+  const size_t oldest = (next_[c] + capacity_[c] - count_[c]) % capacity_[c];
+  return offset_[c] + (oldest + position) % capacity_[c];
+}
+
+void StratifiedReplayBuffer::gather(const size_t *slots, size_t count, uint8_t *images_t, int32_t *actions,
+                                    float *rewards, uint8_t *images_t1, uint8_t *dones) const
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    size_t s = slots[i];
+    memcpy(images_t + i * observation_size_, &images_t_[s * observation_size_], observation_size_);
+    actions[i] = actions_[s];
+    rewards[i] = rewards_[s];
+    memcpy(images_t1 + i * observation_size_, &images_t1_[s * observation_size_], observation_size_);
+    dones[i] = dones_[s];
+  }
+}
+
+void StratifiedReplayBuffer::seed(uint64_t seed)
+{
+  generator_.seed(seed);
+}
+
+void StratifiedReplayBuffer::clear()
+{
+  for (int c = 0; c < NUM_CLASSES; c++)
+  {
+    next_[c] = 0;
+    count_[c] = 0;
+  }
+}
+
+size_t StratifiedReplayBuffer::getCount(RewardClass reward_class) const
+{
+  return count_[reward_class];
+}
+
+size_t StratifiedReplayBuffer::getClassCapacity(RewardClass reward_class) const
+{
+  return capacity_[reward_class];
+}
+
+size_t StratifiedReplayBuffer::getSize() const
+{
+  return count_[POSITIVE] + count_[NEUTRAL] + count_[NEGATIVE];
+}
+
+size_t StratifiedReplayBuffer::getCapacity() const
+{
+  return capacity_[POSITIVE] + capacity_[NEUTRAL] + capacity_[NEGATIVE];
+}
+
+size_t StratifiedReplayBuffer::getObservationSize() const
+{
+  return observation_size_;
+}
+
+int StratifiedReplayBuffer::getHeight() const
+{
+  return height_;
+}
+
+int StratifiedReplayBuffer::getWidth() const
+{
+  return width_;
+}
+
+int StratifiedReplayBuffer::getDepth() const
+{
+  return depth_;
+}
+
+size_t StratifiedReplayBuffer::getByteSize() const
+{
+  return images_t_.size() + images_t1_.size() + actions_.size() * sizeof(int32_t) +
+         rewards_.size() * sizeof(float) + dones_.size();
+}
@@ -23,7 +23,8 @@ import os
 from ardrone_autonomy.msg import Navdata
 # Rename to avoid confusion with Image lib
 from sensor_msgs.msg import Image as ROSImage
-from experience_replay_buffer import ExperienceReplayBuffer
+import drl_replay
+from native_replay_buffer import StratifiedExperienceReplayBuffer
 from deep_reinforced_landing.srv import NewCameraService, GetDoneAndReward, SendCommand, ResetPosition
 from gazebo_msgs.srv import DeleteModel
 from geometry_msgs.msg import Pose
@@ -266,44 +267,28 @@ def main():
     rospy.loginfo("----- Replay Buffer Filler -----")
 
     replay_memory_size = 20000
-    replay_buffer_path = "./replay_buffer_shared.pickle"
-    replay_buffer_path_neutral = "./replay_buffer_neutral.pickle"
-    replay_buffer_path_positive = "./replay_buffer_positive.pickle"
-    replay_buffer_path_negative = "./replay_buffer_negative.pickle"
-    replay_buffer = ExperienceReplayBuffer(capacity=replay_memory_size)
-    replay_buffer_neutral = ExperienceReplayBuffer(capacity=replay_memory_size)
-    replay_buffer_positive = ExperienceReplayBuffer(
-        capacity=replay_memory_size)
-    replay_buffer_negative = ExperienceReplayBuffer(
-        capacity=replay_memory_size)
+    replay_buffer_path = "./replay_buffer_stratified.drl"
+    # Buffers saved by the previous version of this script, one per reward class
+    legacy_buffer_paths = ["./replay_buffer_positive.pickle",
+                           "./replay_buffer_neutral.pickle",
+                           "./replay_buffer_negative.pickle"]
+    # Positive, neutral and negative experiences share a single buffer
+    replay_buffer = StratifiedExperienceReplayBuffer(capacity_positive=replay_memory_size,
+                                                     capacity_neutral=replay_memory_size,
+                                                     capacity_negative=replay_memory_size)
     # Load the Replay buffer from file or accumulate experiences
     if(os.path.isfile(replay_buffer_path) == True):
         print("Replay buffer loading from file: " +
               str(replay_buffer_path))
         replay_buffer.load(replay_buffer_path)
     else:
-        print('No buffer_1 found')
-
-    if(os.path.isfile(replay_buffer_path_neutral) == True):
-        print("Replay buffer loading from file: " +
-              str(replay_buffer_path_neutral))
-        replay_buffer_neutral.load(replay_buffer_path_neutral)
-    else:
-        print('No buffer_2 found')
-
-    if(os.path.isfile(replay_buffer_path_positive) == True):
-        print("Replay buffer loading from file: " +
-              str(replay_buffer_path_positive))
-        replay_buffer_positive.load(replay_buffer_path_positive)
-    else:
-        print('No buffer_2 found')
-
-    if(os.path.isfile(replay_buffer_path_negative) == True):
-        print("Replay buffer loading from file: " +
-              str(replay_buffer_path_negative))
-        replay_buffer_negative.load(replay_buffer_path_negative)
-    else:
-        print('No buffer_2 found')
+        for legacy_buffer_path in legacy_buffer_paths:
+            if(os.path.isfile(legacy_buffer_path) == True):
+                print("Replay buffer loading from file: " +
+                      str(legacy_buffer_path))
+                replay_buffer.load(legacy_buffer_path, clear=False)
+            else:
+                print('No buffer found in ' + legacy_buffer_path)
 
     # Create a subscriber fot the greyscale image
     rospy.Subscriber(
@@ -380,32 +365,25 @@ def main():
             image_t1 = np.expand_dims(image_t1, 2)
             # stack the images
             image_t1 = np.append(image_t[:, :, 1:], image_t1, axis=2)
-            # Store the experience in the replay buffer
+            # Store the experience in the replay buffer, which sorts it by reward class
             if reward > 0:
                 if action == "descend":
-                    replay_buffer_positive.add_experience(
+                    replay_buffer.add_experience(
                         image_t, action, reward, image_t1, done)
                     is_buffer_saved = False
-                    # pass
                 else:
                     rospy.logerr(
                         "[POSITIVE]Wrong action for positive reward: %s", action)
             elif reward == -1.0:
                 if action == "descend":
-                    replay_buffer_negative.add_experience(
+                    replay_buffer.add_experience(
                         image_t, action, reward, image_t1, done)
-                    # pass
                 else:
                     rospy.logerr(
                         "[NEGATIVE]Wrong action for negative reward: %s", action)
             else:
-                # pass
-                replay_buffer_neutral.add_experience(
+                replay_buffer.add_experience(
                     image_t, action, reward, image_t1, done)
-            # Add all the experiences without distinction into the shared
-            # buffer
-            replay_buffer.add_experience(
-                image_t, action, reward, image_t1, done)
 
             frame_preliminary += 1  # To call every time a frame is obtained
             total_experience_counter += 1
@@ -431,34 +409,6 @@ def main():
                 print "Time episode: " + str(timer_stop - timer_start) + " seconds"
                 print "Time episode: " + str((timer_stop - timer_start) / 60) + " minutes"
                 print("Done!")
-                timer_start = time.time()
-                print("")
-                print("Saving the replay buffer in: " +
-                      replay_buffer_path_neutral)
-                print("Sit back and relax, it may take a while...")
-                replay_buffer_neutral.save(replay_buffer_path_neutral)
-                timer_stop = time.time()
-                print "Time episode: " + str(timer_stop - timer_start) + " seconds"
-                print "Time episode: " + str((timer_stop - timer_start) / 60) + " minutes"
-                print("Done!")
-                print("")
-                print("Saving the replay buffer in: " +
-                      replay_buffer_path_positive)
-                print("Sit back and relax, it may take a while...")
-                replay_buffer_positive.save(replay_buffer_path_positive)
-                timer_stop = time.time()
-                print "Time episode: " + str(timer_stop - timer_start) + " seconds"
-                print "Time episode: " + str((timer_stop - timer_start) / 60) + " minutes"
-                print("Done!")
-                print("")
-                print("Saving the replay buffer in: " +
-                      replay_buffer_path_negative)
-                print("Sit back and relax, it may take a while...")
-                replay_buffer_negative.save(replay_buffer_path_negative)
-                timer_stop = time.time()
-                print "Time episode: " + str(timer_stop - timer_start) + " seconds"
-                print "Time episode: " + str((timer_stop - timer_start) / 60) + " minutes"
-                print("Done!")
                 print("")
                 is_buffer_saved = True
             if done:
@@ -467,10 +417,10 @@ def main():
                 actual_time = rospy.get_rostime()
                 rospy_stop_time = actual_time.secs + actual_time.nsecs / 1000000000.0
                 rospy_time_elapsed = rospy_stop_time - rospy_start_time
-                print "Replay Buffer Size: " + str(replay_buffer.return_size()) + " out of " + str(replay_memory_size)
-                print "Replay Buffer Neutral Size: " + str(replay_buffer_neutral.return_size()) + " out of " + str(replay_memory_size)
-                print "Replay Buffer Positive Size: " + str(replay_buffer_positive.return_size()) + " out of " + str(replay_memory_size)
-                print "Replay Buffer Negative Size: " + str(replay_buffer_negative.return_size()) + " out of " + str(replay_memory_size)
+                print "Replay Buffer Size: " + str(replay_buffer.return_size()) + " out of " + str(3 * replay_memory_size)
+                print "Replay Buffer Neutral Size: " + str(replay_buffer.return_size(drl_replay.StratifiedReplayBuffer.NEUTRAL)) + " out of " + str(replay_memory_size)
+                print "Replay Buffer Positive Size: " + str(replay_buffer.return_size(drl_replay.StratifiedReplayBuffer.POSITIVE)) + " out of " + str(replay_memory_size)
+                print "Replay Buffer Negative Size: " + str(replay_buffer.return_size(drl_replay.StratifiedReplayBuffer.NEGATIVE)) + " out of " + str(replay_memory_size)
                 print "Frame counter: " + str(frame_preliminary)
                 print "Time episode: " + str(timer_stop - timer_start) + " seconds"
                 print("Ros time episode: " +
@@ -0,0 +1,252 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Unit tests of the compressed frames: LZ4 and delta+LZ4 round trips of CompressedFrameStore, also when the arena
+  drops the oldest frames, and FrameReplayBuffer giving the same batches with every codec.
+*/
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "../include/compressedFrameStore.h"
+#include "../include/frameReplayBuffer.h"
+
+namespace
+{
+const int SIZE = 24;
+const size_t FRAME_SIZE = SIZE * SIZE;
+const int DEPTH = 4;
+const FrameCodec CODECS[] = { FRAME_LZ4, FRAME_DELTA_LZ4 };
+
+/*
+  Frame of an episode: a smooth ground shifted by step pixels, or random bytes (incompressible) when noisy
+*/
+std::vector<uint8_t> makeFrame(int episode, int step, bool noisy, std::mt19937 &generator)
+{
+  std::vector<uint8_t> frame(FRAME_SIZE);
+  for (int r = 0; r < SIZE; r++)
+  {
+    for (int c = 0; c < SIZE; c++)
+    {
+      frame[r * SIZE + c] = noisy ? generator() & 255 : (uint8_t)(100 + episode * 7 + ((r + c + step) / 5) % 4);
+    }
+  }
+  return frame;
+}
+
+/*
+  Commit the frames of episodes of the given length, every fifth frame is noisy
+*/
+void commitEpisodes(CompressedFrameStore &store, int episodes, int length,
+                    std::vector<std::vector<uint8_t> > &frames, std::vector<uint64_t> &episode_starts)
+{
+  std::mt19937 generator(17);
+  for (int e = 0; e < episodes; e++)
+  {
+    for (int s = 0; s < length; s++)
+    {
+      frames.push_back(makeFrame(e, s, frames.size() % 5 == 4, generator));
+      episode_starts.push_back(frames.size() - 1 - s);
+      std::copy(frames.back().begin(), frames.back().end(), store.stage());
+      store.commit(s == 0);
+    }
+  }
+}
+
+/*
+  Check that every frame still available decodes to the frame committed
+*/
+void expectDecoded(const CompressedFrameStore &store, const std::vector<std::vector<uint8_t> > &frames,
+                   const std::vector<uint64_t> &episode_starts)
+{
+  std::vector<uint8_t> scratch;
+  for (uint64_t f = store.getFirstValid(); f < frames.size(); f++)
+  {
+    const uint64_t keyframe = store.getKeyframe(f);
+    ASSERT_LE(keyframe, f);
+    ASSERT_GE(keyframe, episode_starts[f]);
+    if (keyframe < store.getFirstValid())
+    {
+      // Its keyframe has been dropped, so has the frame for the replay buffer
+      continue;
+    }
+    // A single frame and a window of the episode ending at it
+    const uint8_t *decoded = store.decode(f, f, scratch);
+    ASSERT_TRUE(std::equal(frames[f].begin(), frames[f].end(), decoded)) << "frame " << f;
+    const uint64_t first = std::max(keyframe, f >= 3 ? f - 3 : 0);
+    decoded = store.decode(first, f, scratch);
+    for (uint64_t g = first; g <= f; g++)
+    {
+      ASSERT_TRUE(std::equal(frames[g].begin(), frames[g].end(), decoded + (g - first) * FRAME_SIZE))
+          << "frame " << g << " of the window ending at " << f;
+    }
+  }
+}
+
+void addEpisodes(FrameReplayBuffer &buffer, int episodes, int length)
+{
+  std::mt19937 generator(23);
+  for (int e = 0; e < episodes; e++)
+  {
+    std::vector<uint8_t> frame = makeFrame(e, 0, false, generator);
+    buffer.startEpisode(&frame[0]);
+    for (int s = 1; s <= length; s++)
+    {
+      frame = makeFrame(e, s, s % 5 == 0, generator);
+      buffer.addStep(s % 14, (float)(e * 1000 + s), &frame[0], s == length);
+    }
+  }
+}
+}
+
+TEST(CompressedFrameStore, RoundTripsEveryCodec)
+{
+  for (size_t c = 0; c < sizeof(CODECS) / sizeof(CODECS[0]); c++)
+  {
+    // Arena and table large enough for every frame
+    CompressedFrameStore store(CODECS[c], FRAME_SIZE, 200, 200 * FRAME_SIZE * 2);
+    std::vector<std::vector<uint8_t> > frames;
+    std::vector<uint64_t> episode_starts;
+    commitEpisodes(store, 6, 30, frames, episode_starts);
+    EXPECT_EQ(0u, store.getFirstValid());
+    expectDecoded(store, frames, episode_starts);
+
+    for (uint64_t f = 0; f < frames.size(); f++)
+    {
+      if (CODECS[c] == FRAME_LZ4)
+      {
+        EXPECT_EQ(f, store.getKeyframe(f));
+      }
+      else
+      {
+        // A keyframe at least every KEYFRAME_INTERVAL frames and at every episode start
+        EXPECT_LT(f - store.getKeyframe(f), (uint64_t)CompressedFrameStore::KEYFRAME_INTERVAL);
+        if (episode_starts[f] == f)
+        {
+          EXPECT_EQ(f, store.getKeyframe(f));
+        }
+      }
+    }
+  }
+}
+
+TEST(CompressedFrameStore, DropsTheOldestFramesWhenTheArenaIsFull)
+{
+  for (size_t c = 0; c < sizeof(CODECS) / sizeof(CODECS[0]); c++)
+  {
+    // The smallest arena: far fewer frames than committed fit in it
+    CompressedFrameStore store(CODECS[c], FRAME_SIZE, 1000, 0);
+    std::vector<std::vector<uint8_t> > frames;
+    std::vector<uint64_t> episode_starts;
+    commitEpisodes(store, 20, 40, frames, episode_starts);
+    EXPECT_GT(store.getFirstValid(), 0u);
+    EXPECT_LT(store.getFirstValid(), frames.size());
+    EXPECT_LE(store.getStoredBytes(), store.getByteSize());
+    expectDecoded(store, frames, episode_starts);
+  }
+
+  // The table of frames is full before the arena
+  CompressedFrameStore store(FRAME_DELTA_LZ4, FRAME_SIZE, 50, 1000 * FRAME_SIZE);
+  std::vector<std::vector<uint8_t> > frames;
+  std::vector<uint64_t> episode_starts;
+  commitEpisodes(store, 4, 30, frames, episode_starts);
+  EXPECT_EQ(70u, store.getFirstValid());
+  expectDecoded(store, frames, episode_starts);
+}
+
+TEST(CompressedFrameStore, ClearStartsAgain)
+{
+  CompressedFrameStore store(FRAME_DELTA_LZ4, FRAME_SIZE, 100, 0);
+  std::vector<std::vector<uint8_t> > frames;
+  std::vector<uint64_t> episode_starts;
+  commitEpisodes(store, 2, 10, frames, episode_starts);
+  store.clear();
+  EXPECT_EQ(0u, store.getFirstValid());
+  EXPECT_EQ(0u, store.getStoredBytes());
+  frames.clear();
+  episode_starts.clear();
+  commitEpisodes(store, 1, 10, frames, episode_starts);
+  expectDecoded(store, frames, episode_starts);
+}
+
+TEST(CompressedFrameStore, ReplayBufferGivesTheSameBatchesWithEveryCodec)
+{
+  FrameReplayBuffer raw(300, SIZE, SIZE, DEPTH);
+  addEpisodes(raw, 10, 25);
+  ASSERT_EQ(250u, raw.getSize());
+  const size_t observation_size = raw.getObservationSize();
+  std::vector<size_t> positions(raw.getSize());
+  for (size_t p = 0; p < positions.size(); p++)
+  {
+    positions[p] = p;
+  }
+  const size_t count = positions.size();
+  std::vector<uint8_t> raw_t(count * observation_size), raw_t1(count * observation_size), raw_dones(count);
+  std::vector<int32_t> raw_actions(count);
+  std::vector<float> raw_rewards(count);
+  raw.gather(&positions[0], count, &raw_t[0], &raw_actions[0], &raw_rewards[0], &raw_t1[0], &raw_dones[0]);
+
+  for (size_t c = 0; c < sizeof(CODECS) / sizeof(CODECS[0]); c++)
+  {
+    // Decoded by several threads, the arena holds every frame
+    FrameReplayBuffer compressed(300, SIZE, SIZE, DEPTH, 0, CODECS[c], 300 * FRAME_SIZE * 2, 3);
+    addEpisodes(compressed, 10, 25);
+    ASSERT_EQ(250u, compressed.getSize());
+    std::vector<uint8_t> images_t(count * observation_size), images_t1(count * observation_size), dones(count);
+    std::vector<int32_t> actions(count);
+    std::vector<float> rewards(count);
+    compressed.gather(&positions[0], count, &images_t[0], &actions[0], &rewards[0], &images_t1[0], &dones[0]);
+    EXPECT_TRUE(images_t == raw_t);
+    EXPECT_TRUE(images_t1 == raw_t1);
+    EXPECT_TRUE(actions == raw_actions);
+    EXPECT_TRUE(rewards == raw_rewards);
+    EXPECT_TRUE(dones == raw_dones);
+  }
+}
+
+TEST(CompressedFrameStore, ReplayBufferEvictsWithTheArena)
+{
+  for (size_t c = 0; c < sizeof(CODECS) / sizeof(CODECS[0]); c++)
+  {
+    // The arena holds fewer frames than the transitions: the oldest transitions go with their frames
+    FrameReplayBuffer compressed(1000, SIZE, SIZE, DEPTH, 0, CODECS[c], 1, 2);
+    FrameReplayBuffer raw(1000, SIZE, SIZE, DEPTH);
+    addEpisodes(compressed, 30, 25);
+    addEpisodes(raw, 30, 25);
+    const size_t count = compressed.getSize();
+    ASSERT_GT(count, 0u);
+    ASSERT_LT(count, raw.getSize());
+
+    // The transitions kept are the newest ones, equal to those of the raw buffer
+    const size_t observation_size = raw.getObservationSize();
+    std::vector<size_t> positions(count), raw_positions(count);
+    for (size_t p = 0; p < count; p++)
+    {
+      positions[p] = p;
+      raw_positions[p] = raw.getSize() - count + p;
+    }
+    std::vector<uint8_t> images_t(count * observation_size), images_t1(count * observation_size), dones(count);
+    std::vector<uint8_t> raw_t(count * observation_size), raw_t1(count * observation_size), raw_dones(count);
+    std::vector<int32_t> actions(count), raw_actions(count);
+    std::vector<float> rewards(count), raw_rewards(count);
+    compressed.gather(&positions[0], count, &images_t[0], &actions[0], &rewards[0], &images_t1[0], &dones[0]);
+    raw.gather(&raw_positions[0], count, &raw_t[0], &raw_actions[0], &raw_rewards[0], &raw_t1[0], &raw_dones[0]);
+    EXPECT_TRUE(images_t == raw_t);
+    EXPECT_TRUE(images_t1 == raw_t1);
+    EXPECT_TRUE(rewards == raw_rewards);
+    EXPECT_LE(compressed.getFrameBytes(), compressed.getByteSize());
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
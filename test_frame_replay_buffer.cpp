@@ -0,0 +1,226 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Unit tests of FrameReplayBuffer (raw frames): the stacks rebuilt at sample time are equal to the stacks added, also
+  after the oldest transitions and frames have been evicted.
+*/
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+#include "../include/frameReplayBuffer.h"
+
+namespace
+{
+const int HEIGHT = 7;
+const int WIDTH = 9;
+const int DEPTH = 4;
+const size_t FRAME_SIZE = HEIGHT * WIDTH;
+const size_t OBSERVATION_SIZE = FRAME_SIZE * DEPTH;
+
+struct Transition
+{
+  std::vector<uint8_t> image_t, image_t1;
+  int32_t action;
+  float reward;
+  bool done;
+};
+
+/*
+  Episodes of random frames, stacked as the training scripts do: the first frame is repeated DEPTH times
+*/
+class EpisodeGenerator
+{
+private:
+  std::mt19937 generator_;
+  std::vector<uint8_t> stack_;
+  int step_;
+
+public:
+  explicit EpisodeGenerator(uint32_t seed) : generator_(seed), stack_(OBSERVATION_SIZE), step_(0)
+  {
+  }
+
+  std::vector<uint8_t> frame()
+  {
+    std::vector<uint8_t> frame(FRAME_SIZE);
+    for (size_t p = 0; p < FRAME_SIZE; p++)
+    {
+      frame[p] = generator_() & 255;
+    }
+    return frame;
+  }
+
+  void start(const std::vector<uint8_t> &first)
+  {
+    for (size_t p = 0; p < FRAME_SIZE; p++)
+    {
+      for (int k = 0; k < DEPTH; k++)
+      {
+        stack_[p * DEPTH + k] = first[p];
+      }
+    }
+  }
+
+  Transition next(const std::vector<uint8_t> &frame_t1, bool done)
+  {
+    Transition transition;
+    transition.image_t = stack_;
+    for (size_t p = 0; p < FRAME_SIZE; p++)
+    {
+      for (int k = 0; k + 1 < DEPTH; k++)
+      {
+        stack_[p * DEPTH + k] = stack_[p * DEPTH + k + 1];
+      }
+      stack_[p * DEPTH + DEPTH - 1] = frame_t1[p];
+    }
+    transition.image_t1 = stack_;
+    transition.action = step_ % 14;
+    transition.reward = 0.25f * step_;
+    transition.done = done;
+    step_++;
+    return transition;
+  }
+};
+
+/*
+  Check that the buffer holds the newest transitions of the reference, in order
+*/
+void expectNewest(const FrameReplayBuffer &buffer, const std::deque<Transition> &reference)
+{
+  const size_t count = buffer.getSize();
+  ASSERT_LE(count, reference.size());
+  std::vector<size_t> positions(count);
+  for (size_t p = 0; p < count; p++)
+  {
+    positions[p] = p;
+  }
+  std::vector<uint8_t> images_t(count * OBSERVATION_SIZE), images_t1(count * OBSERVATION_SIZE), dones(count);
+  std::vector<int32_t> actions(count);
+  std::vector<float> rewards(count);
+  buffer.gather(&positions[0], count, &images_t[0], &actions[0], &rewards[0], &images_t1[0], &dones[0]);
+
+  for (size_t p = 0; p < count; p++)
+  {
+    const Transition &expected = reference[reference.size() - count + p];
+    ASSERT_TRUE(std::equal(expected.image_t.begin(), expected.image_t.end(), &images_t[p * OBSERVATION_SIZE]))
+        << "image_t of position " << p;
+    ASSERT_TRUE(std::equal(expected.image_t1.begin(), expected.image_t1.end(), &images_t1[p * OBSERVATION_SIZE]))
+        << "image_t1 of position " << p;
+    EXPECT_EQ(expected.action, actions[p]);
+    EXPECT_EQ(expected.reward, rewards[p]);
+    EXPECT_EQ(expected.done, dones[p] != 0);
+  }
+}
+
+/*
+  Add episodes of the given lengths through add(), keeping a copy of the transitions
+*/
+void addEpisodes(FrameReplayBuffer &buffer, EpisodeGenerator &episodes, const std::vector<int> &lengths,
+                 std::deque<Transition> &reference)
+{
+  for (size_t e = 0; e < lengths.size(); e++)
+  {
+    episodes.start(episodes.frame());
+    for (int s = 0; s < lengths[e]; s++)
+    {
+      Transition transition = episodes.next(episodes.frame(), s + 1 == lengths[e]);
+      ASSERT_TRUE(buffer.add(&transition.image_t[0], transition.action, transition.reward, &transition.image_t1[0],
+                             transition.done));
+      reference.push_back(transition);
+    }
+  }
+}
+}
+
+TEST(FrameReplayBuffer, RebuildsTheStacksAdded)
+{
+  FrameReplayBuffer buffer(100, HEIGHT, WIDTH, DEPTH);
+  EpisodeGenerator episodes(1);
+  std::deque<Transition> reference;
+  // Episodes shorter and longer than the stack
+  addEpisodes(buffer, episodes, std::vector<int>{ 1, 2, 3, 9, 20, 4 }, reference);
+  ASSERT_EQ(reference.size(), buffer.getSize());
+  expectNewest(buffer, reference);
+}
+
+TEST(FrameReplayBuffer, AddStepEqualsAdd)
+{
+  FrameReplayBuffer stacks(50, HEIGHT, WIDTH, DEPTH), steps(50, HEIGHT, WIDTH, DEPTH);
+  EpisodeGenerator episodes(2);
+  std::deque<Transition> reference;
+  for (int e = 0; e < 3; e++)
+  {
+    const std::vector<uint8_t> first = episodes.frame();
+    episodes.start(first);
+    steps.startEpisode(&first[0]);
+    for (int s = 0; s < 6; s++)
+    {
+      const std::vector<uint8_t> frame_t1 = episodes.frame();
+      Transition transition = episodes.next(frame_t1, s == 5);
+      ASSERT_TRUE(stacks.add(&transition.image_t[0], transition.action, transition.reward, &transition.image_t1[0],
+                             transition.done));
+      ASSERT_TRUE(steps.addStep(transition.action, transition.reward, &frame_t1[0], transition.done));
+      reference.push_back(transition);
+    }
+    // The episode is over
+    EXPECT_FALSE(steps.addStep(0, 0.0f, &first[0], false));
+  }
+  expectNewest(stacks, reference);
+  expectNewest(steps, reference);
+}
+
+TEST(FrameReplayBuffer, RejectsStacksNotShiftedByOneFrame)
+{
+  FrameReplayBuffer buffer(10, HEIGHT, WIDTH, DEPTH);
+  EpisodeGenerator episodes(3);
+  episodes.start(episodes.frame());
+  Transition transition = episodes.next(episodes.frame(), false);
+  transition.image_t1[0]++;
+  EXPECT_FALSE(buffer.add(&transition.image_t[0], 0, 0.0f, &transition.image_t1[0], false));
+  EXPECT_EQ(0u, buffer.getSize());
+
+  std::vector<uint8_t> frame(FRAME_SIZE);
+  EXPECT_FALSE(buffer.addStep(0, 0.0f, &frame[0], false));
+}
+
+TEST(FrameReplayBuffer, EvictsTheOldestTransitions)
+{
+  FrameReplayBuffer buffer(32, HEIGHT, WIDTH, DEPTH);
+  EpisodeGenerator episodes(4);
+  std::deque<Transition> reference;
+  addEpisodes(buffer, episodes, std::vector<int>{ 25, 30, 17, 40 }, reference);
+  EXPECT_EQ(32u, buffer.getSize());
+  expectNewest(buffer, reference);
+}
+
+TEST(FrameReplayBuffer, EvictsTransitionsWhoseFramesAreOverwritten)
+{
+  // Episodes of one step take two frames each: the frames run out before the transitions
+  FrameReplayBuffer buffer(64, HEIGHT, WIDTH, DEPTH);
+  EpisodeGenerator episodes(5);
+  std::deque<Transition> reference;
+  addEpisodes(buffer, episodes, std::vector<int>(200, 1), reference);
+  EXPECT_LT(buffer.getSize(), 64u);
+  EXPECT_GT(buffer.getSize(), 0u);
+  expectNewest(buffer, reference);
+
+  // Longer episodes fill it again
+  addEpisodes(buffer, episodes, std::vector<int>{ 50, 50 }, reference);
+  EXPECT_EQ(64u, buffer.getSize());
+  expectNewest(buffer, reference);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
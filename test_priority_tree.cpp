@@ -0,0 +1,231 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Unit tests of PriorityTree against a brute-force scan of the priorities, and of the proportional sampling of
+  PrioritizedReplayBuffer.
+*/
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include "../include/priorityTree.h"
+#include "../include/prioritizedReplayBuffer.h"
+#include "../include/replayBuffer.h"
+
+namespace
+{
+/*
+  Slot whose range [prefix sum before it, prefix sum after it) contains prefix, skipping empty slots
+*/
+size_t bruteForceFind(const std::vector<double> &priorities, double prefix)
+{
+  double sum = 0.0;
+  size_t last = 0;
+  for (size_t i = 0; i < priorities.size(); i++)
+  {
+    if (priorities[i] <= 0.0)
+    {
+      continue;
+    }
+    last = i;
+    sum += priorities[i];
+    if (prefix < sum)
+    {
+      return i;
+    }
+  }
+  return last;
+}
+
+/*
+  Add transitions whose reward is their number
+*/
+template <typename Buffer>
+void addTransitions(Buffer &buffer, int first, int count)
+{
+  std::vector<uint8_t> image(2 * 2 * 4);
+  for (int i = first; i < first + count; i++)
+  {
+    buffer.add(&image[0], 0, (float)i, &image[0], false);
+  }
+}
+}
+
+TEST(PriorityTree, MatchesABruteForceScan)
+{
+  // Sizes that are and are not powers of two
+  const size_t sizes[] = { 1, 2, 7, 64, 100 };
+  std::mt19937_64 generator(3);
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+  {
+    PriorityTree tree(sizes[s]);
+    std::vector<double> priorities(sizes[s], 0.0);
+    EXPECT_EQ(0.0, tree.getTotal());
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), tree.getMin());
+
+    std::uniform_int_distribution<size_t> slot(0, sizes[s] - 1);
+    std::uniform_real_distribution<double> priority(0.0, 10.0);
+    for (int update = 0; update < 500; update++)
+    {
+      // Some slots go back to 0
+      const size_t index = slot(generator);
+      priorities[index] = update % 7 == 0 ? 0.0 : priority(generator);
+      tree.set(index, priorities[index]);
+
+      double total = 0.0, min = std::numeric_limits<double>::infinity();
+      for (size_t i = 0; i < priorities.size(); i++)
+      {
+        total += priorities[i];
+        if (priorities[i] > 0.0)
+        {
+          min = std::min(min, priorities[i]);
+        }
+      }
+      ASSERT_NEAR(total, tree.getTotal(), 1e-9 * (1.0 + total));
+      ASSERT_EQ(min, tree.getMin());
+      ASSERT_EQ(priorities[index], tree.get(index));
+      if (total <= 0.0)
+      {
+        continue;
+      }
+      for (int probe = 0; probe < 8; probe++)
+      {
+        const double prefix = std::uniform_real_distribution<double>(0.0, total)(generator);
+        const size_t found = tree.find(prefix);
+        // Rounding may move a prefix at the edge of a range to the next slot
+        if (found != bruteForceFind(priorities, prefix))
+        {
+          ASSERT_TRUE(found == bruteForceFind(priorities, prefix * (1 + 1e-12)) ||
+                      found == bruteForceFind(priorities, prefix * (1 - 1e-12)));
+        }
+        ASSERT_GT(priorities[found], 0.0);
+      }
+    }
+  }
+}
+
+TEST(PriorityTree, ClearResetsEveryPriority)
+{
+  PriorityTree tree(10);
+  tree.set(3, 2.0);
+  tree.clear();
+  EXPECT_EQ(0.0, tree.getTotal());
+  EXPECT_EQ(0.0, tree.get(3));
+}
+
+TEST(PrioritizedReplayBuffer, SamplesProportionallyToThePriorities)
+{
+  PrioritizedReplayBuffer<ReplayBuffer> buffer(4, 2, 2, 4, 1.0, 0.0, 11);
+  addTransitions(buffer, 0, 4);
+  // Priorities 1, 2, 3 and 4 (alpha = 1, epsilon = 0)
+  const size_t slots[] = { 0, 1, 2, 3 };
+  const float errors[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+  buffer.updatePriorities(slots, errors, 4);
+
+  const size_t batch = 1000;
+  std::vector<uint8_t> images(batch * 16), dones(batch);
+  std::vector<int32_t> actions(batch);
+  std::vector<float> rewards(batch), weights(batch);
+  std::vector<size_t> sampled(batch);
+  std::vector<double> counts(4, 0.0);
+  for (int round = 0; round < 20; round++)
+  {
+    ASSERT_TRUE(buffer.sample(batch, 0.5, &images[0], &actions[0], &rewards[0], &images[0], &dones[0], &weights[0],
+                              &sampled[0]));
+    for (size_t i = 0; i < batch; i++)
+    {
+      // The slot and the transition gathered agree, the weights are normalised
+      ASSERT_EQ(sampled[i], (size_t)rewards[i]);
+      ASSERT_LE(weights[i], 1.0f + 1e-6f);
+      ASSERT_NEAR(std::pow(4 * (sampled[i] + 1) / 10.0, -0.5) / std::pow(4 * 1 / 10.0, -0.5), weights[i], 1e-5);
+      counts[sampled[i]]++;
+    }
+  }
+  for (size_t i = 0; i < 4; i++)
+  {
+    EXPECT_NEAR((i + 1) / 10.0, counts[i] / (20.0 * batch), 0.01);
+  }
+}
+
+TEST(PrioritizedReplayBuffer, EvictedTransitionsLeaveTheDistribution)
+{
+  PrioritizedReplayBuffer<ReplayBuffer> buffer(8, 2, 2, 4, 1.0, 0.0, 5);
+  addTransitions(buffer, 0, 8);
+  const size_t slots[] = { 0, 1 };
+  const float errors[] = { 100.0f, 100.0f };
+  buffer.updatePriorities(slots, errors, 2);
+  // Transitions 8 and 9 overwrite 0 and 1 and get the largest priority seen so far
+  addTransitions(buffer, 8, 2);
+
+  std::vector<uint8_t> images(64 * 16), dones(64);
+  std::vector<int32_t> actions(64);
+  std::vector<float> rewards(64), weights(64);
+  std::vector<size_t> sampled(64);
+  ASSERT_TRUE(buffer.sample(64, 1.0, &images[0], &actions[0], &rewards[0], &images[0], &dones[0], &weights[0],
+                            &sampled[0]));
+  int newest = 0;
+  for (size_t i = 0; i < 64; i++)
+  {
+    ASSERT_GE(rewards[i], 2.0f);
+    newest += rewards[i] >= 8.0f;
+  }
+  // 200 of the total priority of 206 belongs to the newest transitions
+  EXPECT_GT(newest, 56);
+
+  // Cleared, nothing can be sampled
+  buffer.clear();
+  EXPECT_FALSE(buffer.sample(1, 1.0, &images[0], &actions[0], &rewards[0], &images[0], &dones[0], &weights[0],
+                             &sampled[0]));
+}
+
+TEST(PrioritizedReplayBuffer, SkipsSlotsWrittenSinceTheSampling)
+{
+  PrioritizedReplayBuffer<ReplayBuffer> buffer(4, 2, 2, 4, 1.0, 0.0, 7);
+  addTransitions(buffer, 0, 4);
+  std::vector<uint8_t> images(4 * 16), dones(4);
+  std::vector<int32_t> actions(4);
+  std::vector<float> rewards(4), weights(4);
+  std::vector<size_t> sampled(4);
+  std::vector<uint64_t> writes(4);
+  // Equal priorities: one sample in each slot
+  ASSERT_TRUE(buffer.sample(4, 1.0, &images[0], &actions[0], &rewards[0], &images[0], &dones[0], &weights[0],
+                            &sampled[0], &writes[0]));
+  for (size_t i = 0; i < 4; i++)
+  {
+    ASSERT_EQ(i, sampled[i]);
+  }
+
+  // Transitions 4 and 5 overwrite the slots of 0 and 1 before the learner step is over
+  addTransitions(buffer, 4, 2);
+  const float errors[] = { 0.5f, 0.5f, 0.5f, 0.5f };
+  buffer.updatePriorities(&sampled[0], errors, 4, &writes[0]);
+
+  // The new transitions keep the largest priority, 2 of the total 3 (1 + 1 + 0.5 + 0.5)
+  std::vector<uint8_t> batch_images(1000 * 16), batch_dones(1000);
+  std::vector<int32_t> batch_actions(1000);
+  std::vector<float> batch_rewards(1000), batch_weights(1000);
+  std::vector<size_t> batch_slots(1000);
+  ASSERT_TRUE(buffer.sample(1000, 1.0, &batch_images[0], &batch_actions[0], &batch_rewards[0], &batch_images[0],
+                            &batch_dones[0], &batch_weights[0], &batch_slots[0]));
+  int newest = 0;
+  for (size_t i = 0; i < 1000; i++)
+  {
+    newest += batch_rewards[i] >= 4.0f;
+  }
+  EXPECT_NEAR(667, newest, 40);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Unit tests of ReplayBuffer: FIFO order of the columns, overwriting of the oldest transitions and sampling without
+  replacement.
+*/
+
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+#include "../include/replayBuffer.h"
+
+namespace
+{
+const int HEIGHT = 6;
+const int WIDTH = 5;
+const int DEPTH = 4;
+
+/*
+  Add transition i: every byte of image_t is i, every byte of image_t1 is i + 1
+*/
+void addTransition(ReplayBuffer &buffer, int i)
+{
+  const size_t size = buffer.getObservationSize();
+  std::vector<uint8_t> image_t(size, i & 255), image_t1(size, (i + 1) & 255);
+  buffer.add(&image_t[0], i % 14, 0.5f * i, &image_t1[0], i % 5 == 0);
+}
+
+/*
+  Check that the transition at a position of the batch is transition i
+*/
+void expectTransition(const ReplayBuffer &buffer, int i, size_t k, const std::vector<uint8_t> &images_t,
+                      const std::vector<int32_t> &actions, const std::vector<float> &rewards,
+                      const std::vector<uint8_t> &images_t1, const std::vector<uint8_t> &dones)
+{
+  const size_t size = buffer.getObservationSize();
+  for (size_t b = 0; b < size; b++)
+  {
+    ASSERT_EQ(i & 255, images_t[k * size + b]);
+    ASSERT_EQ((i + 1) & 255, images_t1[k * size + b]);
+  }
+  EXPECT_EQ(i % 14, actions[k]);
+  EXPECT_EQ(0.5f * i, rewards[k]);
+  EXPECT_EQ(i % 5 == 0, dones[k] != 0);
+}
+}
+
+TEST(ReplayBuffer, GathersTheColumnsInFifoOrder)
+{
+  ReplayBuffer buffer(10, HEIGHT, WIDTH, DEPTH);
+  for (int i = 0; i < 7; i++)
+  {
+    addTransition(buffer, i);
+  }
+  ASSERT_EQ(7u, buffer.getSize());
+
+  std::vector<size_t> positions;
+  for (size_t p = 0; p < 7; p++)
+  {
+    positions.push_back(6 - p);
+  }
+  const size_t size = buffer.getObservationSize();
+  std::vector<uint8_t> images_t(7 * size), images_t1(7 * size), dones(7);
+  std::vector<int32_t> actions(7);
+  std::vector<float> rewards(7);
+  buffer.gather(&positions[0], 7, &images_t[0], &actions[0], &rewards[0], &images_t1[0], &dones[0]);
+  for (size_t k = 0; k < 7; k++)
+  {
+    expectTransition(buffer, 6 - k, k, images_t, actions, rewards, images_t1, dones);
+  }
+}
+
+TEST(ReplayBuffer, OverwritesTheOldestTransitions)
+{
+  ReplayBuffer buffer(8, HEIGHT, WIDTH, DEPTH);
+  for (int i = 0; i < 21; i++)
+  {
+    addTransition(buffer, i);
+  }
+  ASSERT_EQ(8u, buffer.getSize());
+
+  // Position 0 is transition 13, the slots keep going round
+  const size_t size = buffer.getObservationSize();
+  std::vector<uint8_t> images_t(8 * size), images_t1(8 * size), dones(8);
+  std::vector<int32_t> actions(8);
+  std::vector<float> rewards(8);
+  std::vector<size_t> positions;
+  for (size_t p = 0; p < 8; p++)
+  {
+    positions.push_back(p);
+    EXPECT_EQ((21 + p) % 8, buffer.getSlot(p));
+  }
+  buffer.gather(&positions[0], 8, &images_t[0], &actions[0], &rewards[0], &images_t1[0], &dones[0]);
+  for (size_t k = 0; k < 8; k++)
+  {
+    expectTransition(buffer, 13 + k, k, images_t, actions, rewards, images_t1, dones);
+  }
+}
+
+TEST(ReplayBuffer, SamplesDistinctTransitions)
+{
+  ReplayBuffer buffer(64, HEIGHT, WIDTH, DEPTH, 7);
+  for (int i = 0; i < 40; i++)
+  {
+    addTransition(buffer, i);
+  }
+
+  // Small batches and batches as large as the buffer
+  const size_t batches[] = { 1, 5, 32, 40 };
+  for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++)
+  {
+    std::vector<size_t> positions(batches[b]);
+    ASSERT_TRUE(buffer.sampleIndices(batches[b], &positions[0]));
+    std::set<size_t> distinct(positions.begin(), positions.end());
+    EXPECT_EQ(batches[b], distinct.size());
+    EXPECT_LT(*distinct.rbegin(), 40u);
+  }
+  std::vector<size_t> positions(41);
+  EXPECT_FALSE(buffer.sampleIndices(41, &positions[0]));
+
+  // The rewards identify the transitions of a sampled batch
+  const size_t size = buffer.getObservationSize();
+  std::vector<uint8_t> images_t(16 * size), images_t1(16 * size), dones(16);
+  std::vector<int32_t> actions(16);
+  std::vector<float> rewards(16);
+  ASSERT_TRUE(buffer.sample(16, &images_t[0], &actions[0], &rewards[0], &images_t1[0], &dones[0]));
+  for (size_t k = 0; k < 16; k++)
+  {
+    expectTransition(buffer, (int)(rewards[k] * 2), k, images_t, actions, rewards, images_t1, dones);
+  }
+}
+
+TEST(ReplayBuffer, SeedReproducesTheSamples)
+{
+  ReplayBuffer buffer(100, HEIGHT, WIDTH, DEPTH);
+  for (int i = 0; i < 100; i++)
+  {
+    addTransition(buffer, i);
+  }
+  std::vector<size_t> first(20), second(20);
+  buffer.seed(42);
+  buffer.sampleIndices(20, &first[0]);
+  buffer.seed(42);
+  buffer.sampleIndices(20, &second[0]);
+  EXPECT_EQ(first, second);
+}
+
+TEST(ReplayBuffer, ClearEmptiesTheBuffer)
+{
+  ReplayBuffer buffer(4, HEIGHT, WIDTH, DEPTH);
+  addTransition(buffer, 1);
+  buffer.clear();
+  EXPECT_EQ(0u, buffer.getSize());
+  size_t position;
+  EXPECT_FALSE(buffer.sampleIndices(1, &position));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
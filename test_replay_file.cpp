@@ -0,0 +1,263 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Unit tests of the replay files: round trip of every column, the committed count of a writer killed before closing
+  the file, and reopening a file to append.
+*/
+
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+#include "../include/replayFile.h"
+
+namespace
+{
+const int HEIGHT = 5;
+const int WIDTH = 4;
+const int DEPTH = 3;
+const size_t OBSERVATION_SIZE = HEIGHT * WIDTH * DEPTH;
+
+std::string tempPath(const std::string &name)
+{
+  const std::string path = testing::TempDir() + "test_replay_file_" + name + ".drl";
+  remove(path.c_str());
+  return path;
+}
+
+/*
+  Append transition i, tagged with generation so that rewritten transitions can be told apart. Odd transitions
+  have a position.
+*/
+bool appendTransition(ReplayFileWriter &writer, int i, int generation = 0)
+{
+  std::vector<uint8_t> image_t(OBSERVATION_SIZE), image_t1(OBSERVATION_SIZE);
+  for (size_t b = 0; b < OBSERVATION_SIZE; b++)
+  {
+    image_t[b] = (i + b) & 255;
+    image_t1[b] = (i + b + 1) & 255;
+  }
+  const float position[3] = { (float)i, -1.0f, 2.5f };
+  return writer.append(&image_t[0], i % 14 + 100 * generation, 0.5f * i, &image_t1[0], i % 6 == 0,
+                       i % 2 == 1 ? position : NULL);
+}
+
+void expectTransition(const ReplayFile &file, size_t index, int i, int generation = 0)
+{
+  const uint8_t *image_t = file.getImageT(index), *image_t1 = file.getImageT1(index);
+  for (size_t b = 0; b < OBSERVATION_SIZE; b++)
+  {
+    ASSERT_EQ((i + b) & 255, image_t[b]) << "transition " << index;
+    ASSERT_EQ((i + b + 1) & 255, image_t1[b]) << "transition " << index;
+  }
+  EXPECT_EQ(i % 14 + 100 * generation, file.getAction(index));
+  EXPECT_EQ(0.5f * i, file.getReward(index));
+  EXPECT_EQ(i % 6 == 0, file.getDone(index));
+  const float *position = file.getPosition(index);
+  if (i % 2 == 1)
+  {
+    EXPECT_EQ((float)i, position[0]);
+    EXPECT_EQ(-1.0f, position[1]);
+    EXPECT_EQ(2.5f, position[2]);
+  }
+  else
+  {
+    EXPECT_TRUE(std::isnan(position[0]) && std::isnan(position[1]) && std::isnan(position[2]));
+  }
+}
+}
+
+TEST(ReplayFile, RoundTripsEveryColumn)
+{
+  const std::string path = tempPath("round_trip");
+  ReplayFileWriter writer;
+  ASSERT_TRUE(writer.open(path, HEIGHT, WIDTH, DEPTH, 16));
+  writer.setUserFlags(5);
+  for (int i = 0; i < 50; i++)
+  {
+    ASSERT_TRUE(appendTransition(writer, i));
+  }
+  writer.close();
+
+  ReplayFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(50u, file.getSize());
+  EXPECT_EQ(16u, file.getChunkSize());
+  EXPECT_EQ(4u, file.getNumChunks());
+  EXPECT_EQ(5u, file.getUserFlags());
+  EXPECT_EQ(HEIGHT, file.getHeight());
+  EXPECT_EQ(WIDTH, file.getWidth());
+  EXPECT_EQ(DEPTH, file.getDepth());
+  for (int i = 0; i < 50; i++)
+  {
+    expectTransition(file, i, i);
+  }
+
+  // The columns of a chunk have a fixed stride
+  const int32_t *actions = reinterpret_cast<const int32_t *>(file.getChunkColumn(2, ReplayFile::ACTIONS));
+  ASSERT_TRUE(actions != NULL);
+  EXPECT_EQ(32 % 14, actions[0]);
+  EXPECT_EQ(47 % 14, actions[15]);
+  EXPECT_TRUE(file.getChunkColumn(4, ReplayFile::ACTIONS) == NULL);
+
+  // Samples are distinct and gathered whole
+  std::vector<uint8_t> images_t(20 * OBSERVATION_SIZE), images_t1(20 * OBSERVATION_SIZE), dones(20);
+  std::vector<int32_t> sampled_actions(20);
+  std::vector<float> rewards(20), positions(60);
+  ASSERT_TRUE(file.sample(20, &images_t[0], &sampled_actions[0], &rewards[0], &images_t1[0], &dones[0],
+                          &positions[0]));
+  std::set<float> distinct(rewards.begin(), rewards.end());
+  EXPECT_EQ(20u, distinct.size());
+  for (size_t k = 0; k < 20; k++)
+  {
+    const int i = (int)(rewards[k] * 2);
+    EXPECT_EQ(i % 14, sampled_actions[k]);
+    EXPECT_EQ(i & 255, images_t[k * OBSERVATION_SIZE]);
+  }
+  EXPECT_FALSE(file.sample(51, &images_t[0], &sampled_actions[0], &rewards[0], &images_t1[0], &dones[0]));
+  remove(path.c_str());
+}
+
+TEST(ReplayFile, KeepsTheCommittedTransitionsOfAKilledWriter)
+{
+  const std::string path = tempPath("killed");
+  const pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0)
+  {
+    // A full chunk is committed by itself, 4 more by commit() and the last 7 never are
+    ReplayFileWriter writer;
+    bool appended = writer.open(path, HEIGHT, WIDTH, DEPTH, 16);
+    for (int i = 0; i < 20; i++)
+    {
+      appended = appended && appendTransition(writer, i);
+    }
+    writer.commit();
+    for (int i = 20; i < 27; i++)
+    {
+      appended = appended && appendTransition(writer, i);
+    }
+    // No destructor runs, as when the process is killed
+    _exit(appended ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(child, waitpid(child, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+  ReplayFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(20u, file.getSize());
+  for (int i = 0; i < 20; i++)
+  {
+    expectTransition(file, i, i);
+  }
+  file.close();
+
+  // Reopened, the writer goes on from the committed count and overwrites what was not committed
+  ReplayFileWriter writer;
+  ASSERT_TRUE(writer.open(path, HEIGHT, WIDTH, DEPTH));
+  EXPECT_EQ(20u, writer.getSize());
+  for (int i = 20; i < 40; i++)
+  {
+    ASSERT_TRUE(appendTransition(writer, i, 1));
+  }
+  writer.close();
+
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(40u, file.getSize());
+  for (int i = 0; i < 40; i++)
+  {
+    expectTransition(file, i, i, i < 20 ? 0 : 1);
+  }
+  remove(path.c_str());
+}
+
+TEST(ReplayFile, ReaderSeesOnlyCommittedTransitions)
+{
+  const std::string path = tempPath("uncommitted");
+  ReplayFileWriter writer;
+  ASSERT_TRUE(writer.open(path, HEIGHT, WIDTH, DEPTH, 8));
+  for (int i = 0; i < 11; i++)
+  {
+    ASSERT_TRUE(appendTransition(writer, i));
+  }
+  ReplayFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(8u, file.getSize());
+  file.close();
+
+  writer.commit();
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(11u, file.getSize());
+  writer.close();
+  remove(path.c_str());
+}
+
+TEST(ReplayFile, RejectsOtherShapesAndFiles)
+{
+  const std::string path = tempPath("shape");
+  ReplayFileWriter writer;
+  ASSERT_TRUE(writer.open(path, HEIGHT, WIDTH, DEPTH));
+  ASSERT_TRUE(appendTransition(writer, 0));
+  writer.close();
+  EXPECT_FALSE(writer.open(path, HEIGHT, WIDTH, DEPTH + 1));
+
+  // Truncated, the file starts again
+  ASSERT_TRUE(writer.open(path, HEIGHT, WIDTH, DEPTH, 1024, true));
+  EXPECT_EQ(0u, writer.getSize());
+  writer.close();
+
+  const std::string text = tempPath("text");
+  FILE *stream = fopen(text.c_str(), "w");
+  ASSERT_TRUE(stream != NULL);
+  fputs("not a replay file\n", stream);
+  fclose(stream);
+  ReplayFile file;
+  EXPECT_FALSE(file.open(text));
+  EXPECT_FALSE(file.open(tempPath("missing")));
+  remove(path.c_str());
+  remove(text.c_str());
+}
+
+TEST(ReplayFile, RewritesChunksInPlace)
+{
+  const std::string path = tempPath("rewrite");
+  ReplayFileWriter writer;
+  ASSERT_TRUE(writer.open(path, HEIGHT, WIDTH, DEPTH, 8));
+  for (int i = 0; i < 12; i++)
+  {
+    ASSERT_TRUE(appendTransition(writer, i));
+  }
+  writer.close();
+
+  ReplayFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_TRUE(file.getMutableChunkColumn(0, ReplayFile::REWARDS) == NULL);
+  ASSERT_TRUE(file.open(path, 0, true));
+  float *rewards = reinterpret_cast<float *>(file.getMutableChunkColumn(1, ReplayFile::REWARDS));
+  ASSERT_TRUE(rewards != NULL);
+  rewards[3] = -7.0f;
+  ASSERT_TRUE(file.sync());
+  file.close();
+
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(-7.0f, file.getReward(11));
+  EXPECT_EQ(5.0f, file.getReward(10));
+  remove(path.c_str());
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,130 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Unit tests of RewardEngine: relabelling recorded positions gives the rewards and dones of the per-tick evaluator
+  with the same config, for every policy.
+*/
+
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <vector>
+#include "../include/actions.h"
+#include "../include/rewardEngine.h"
+
+namespace
+{
+// Marker above the ground of the world, so that the altitude wrt the marker and in the world differ
+const double MARKER[3] = { 3.0, -2.0, 1.25 };
+
+struct Recorded
+{
+  std::vector<float> positions;
+  std::vector<int32_t> actions;
+};
+
+/*
+  UAV positions wrt the marker as the nodes record them, on a grid of 1/64 m so that the float positions of the
+  replay files and the double positions of the node lie on the same side of every bound
+*/
+Recorded record(size_t count, uint32_t seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<int> xy(-9 * 64, 9 * 64), z(-64, 22 * 64), action(0, NUM_ACTIONS - 1);
+  Recorded recorded;
+  for (size_t i = 0; i < count; i++)
+  {
+    recorded.positions.push_back(xy(generator) / 64.0f);
+    recorded.positions.push_back(xy(generator) / 64.0f);
+    recorded.positions.push_back(z(generator) / 64.0f);
+    // Lands often enough to reach both outcomes of land_action
+    recorded.actions.push_back(i % 3 == 0 ? ACTION_LAND : action(generator));
+  }
+  return recorded;
+}
+}
+
+TEST(RewardEngine, RelabelMatchesTheEvaluator)
+{
+  const Recorded recorded = record(1000, 7);
+  const size_t count = recorded.actions.size();
+  for (int p = 0; p < NUM_REWARD_POLICIES; p++)
+  {
+    RewardConfig config;
+    config.policy = static_cast<RewardPolicy>(p);
+    RewardEngine engine(config);
+    engine.setMarker(MARKER[0], MARKER[1], MARKER[2]);
+
+    std::vector<float> rewards(count, 5.0f);
+    std::vector<uint8_t> dones(count, 2);
+    EXPECT_EQ(count, engine.relabel(&recorded.positions[0], &recorded.actions[0], count, &rewards[0], &dones[0]));
+    size_t done = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+      const float *position = &recorded.positions[3 * i];
+      RewardOutcome outcome;
+      engine.evaluate(MARKER[0] + position[0], MARKER[1] + position[1], MARKER[2] + position[2],
+                      recorded.actions[i], &outcome);
+      ASSERT_EQ(outcome.reward, rewards[i]) << rewardPolicyName(config.policy) << ", transition " << i;
+      ASSERT_EQ(outcome.done, dones[i] != 0) << rewardPolicyName(config.policy) << ", transition " << i;
+      done += outcome.done;
+    }
+    // Neither outcome is missing
+    EXPECT_GT(done, 0u) << rewardPolicyName(config.policy);
+    EXPECT_LT(done, count) << rewardPolicyName(config.policy);
+  }
+}
+
+TEST(RewardEngine, MinimumAltitudeIsWrtTheMarker)
+{
+  RewardConfig config;
+  config.policy = REWARD_LAND_ACTION;
+  RewardEngine engine(config);
+  engine.setMarker(MARKER[0], MARKER[1], MARKER[2]);
+  RewardOutcome outcome;
+
+  // High above the ground of the world but just above the marker
+  engine.evaluate(MARKER[0] + 4.0, MARKER[1], MARKER[2] + 0.25, ACTION_FORWARD, &outcome);
+  EXPECT_TRUE(outcome.done);
+  EXPECT_EQ(config.failure_reward, outcome.reward);
+  engine.evaluate(MARKER[0] + 4.0, MARKER[1], MARKER[2] + 0.5, ACTION_FORWARD, &outcome);
+  EXPECT_FALSE(outcome.done);
+  EXPECT_EQ(config.step_reward, outcome.reward);
+
+  const float positions[6] = { 4.0f, 0.0f, 0.25f, 4.0f, 0.0f, 0.5f };
+  const int32_t actions[2] = { ACTION_FORWARD, ACTION_FORWARD };
+  float rewards[2];
+  uint8_t dones[2];
+  engine.relabel(positions, actions, 2, rewards, dones);
+  EXPECT_EQ(config.failure_reward, rewards[0]);
+  EXPECT_EQ(1, dones[0]);
+  EXPECT_EQ(config.step_reward, rewards[1]);
+  EXPECT_EQ(0, dones[1]);
+}
+
+TEST(RewardEngine, RelabelKeepsUnknownPositions)
+{
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float positions[9] = { 0.0f, 0.0f, 1.0f, nan, nan, nan, 0.0f, 0.0f, 1.0f };
+  const int32_t actions[3] = { ACTION_LAND, ACTION_LAND, ACTION_LAND };
+  float rewards[3] = { 0.0f, 0.5f, 0.0f };
+  uint8_t dones[3] = { 0, 0, 0 };
+  RewardEngine engine;
+  EXPECT_EQ(2u, engine.relabel(positions, actions, 3, rewards, dones));
+  EXPECT_EQ(engine.getConfig().success_reward, rewards[0]);
+  EXPECT_EQ(0.5f, rewards[1]);
+  EXPECT_EQ(0, dones[1]);
+  EXPECT_EQ(1, dones[2]);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,164 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Unit tests of StratifiedReplayBuffer: one FIFO per reward class and the class mix of the sampled batches.
+*/
+
+#include <gtest/gtest.h>
+#include <set>
+#include <vector>
+#include "../include/stratifiedReplayBuffer.h"
+
+namespace
+{
+const int HEIGHT = 3;
+const int WIDTH = 3;
+const int DEPTH = 4;
+const size_t OBSERVATION_SIZE = HEIGHT * WIDTH * DEPTH;
+
+/*
+  Add a transition whose action is its number and whose images are filled with it
+*/
+void addTransition(StratifiedReplayBuffer &buffer, int i, float reward)
+{
+  std::vector<uint8_t> image_t(OBSERVATION_SIZE, i & 255), image_t1(OBSERVATION_SIZE, (i + 1) & 255);
+  buffer.add(&image_t[0], i, reward, &image_t1[0], reward != 0.0f);
+}
+
+struct Batch
+{
+  std::vector<uint8_t> images_t, images_t1, dones;
+  std::vector<int32_t> actions;
+  std::vector<float> rewards;
+  size_t counts[StratifiedReplayBuffer::NUM_CLASSES];
+
+  explicit Batch(size_t size)
+    : images_t(size * OBSERVATION_SIZE), images_t1(size * OBSERVATION_SIZE), dones(size), actions(size), rewards(size)
+  {
+  }
+
+  bool sample(StratifiedReplayBuffer &buffer, const double mix[StratifiedReplayBuffer::NUM_CLASSES])
+  {
+    return buffer.sample(actions.size(), mix, &images_t[0], &actions[0], &rewards[0], &images_t1[0], &dones[0],
+                         counts);
+  }
+};
+}
+
+TEST(StratifiedReplayBuffer, ClassifiesTheRewards)
+{
+  EXPECT_EQ(StratifiedReplayBuffer::POSITIVE, StratifiedReplayBuffer::classify(1.0f));
+  EXPECT_EQ(StratifiedReplayBuffer::POSITIVE, StratifiedReplayBuffer::classify(0.01f));
+  EXPECT_EQ(StratifiedReplayBuffer::NEUTRAL, StratifiedReplayBuffer::classify(0.0f));
+  EXPECT_EQ(StratifiedReplayBuffer::NEUTRAL, StratifiedReplayBuffer::classify(-0.01f));
+  EXPECT_EQ(StratifiedReplayBuffer::NEGATIVE, StratifiedReplayBuffer::classify(-1.0f));
+  EXPECT_EQ(StratifiedReplayBuffer::NEGATIVE, StratifiedReplayBuffer::classify(-5.0f));
+}
+
+TEST(StratifiedReplayBuffer, KeepsOneFifoPerClass)
+{
+  const size_t capacities[] = { 4, 10, 6 };
+  StratifiedReplayBuffer buffer(capacities, HEIGHT, WIDTH, DEPTH);
+  // 3 positives among many neutrals and negatives: the neutrals do not evict the positives
+  for (int i = 0; i < 100; i++)
+  {
+    addTransition(buffer, i, i % 33 == 5 ? 1.0f : i % 2 == 0 ? -1.0f : -0.01f);
+  }
+  EXPECT_EQ(3u, buffer.getCount(StratifiedReplayBuffer::POSITIVE));
+  EXPECT_EQ(10u, buffer.getCount(StratifiedReplayBuffer::NEUTRAL));
+  EXPECT_EQ(6u, buffer.getCount(StratifiedReplayBuffer::NEGATIVE));
+  EXPECT_EQ(19u, buffer.getSize());
+  EXPECT_EQ(20u, buffer.getCapacity());
+
+  // Positions go through the classes in order, each from its oldest transition
+  std::vector<int> expected = { 5, 38, 71 };
+  for (int i = 81; i < 100; i += 2)
+  {
+    expected.push_back(i);
+  }
+  for (int i = 88; i < 100; i += 2)
+  {
+    expected.push_back(i);
+  }
+  Batch batch(expected.size());
+  std::vector<size_t> slots;
+  for (size_t p = 0; p < expected.size(); p++)
+  {
+    slots.push_back(buffer.getSlot(p));
+  }
+  buffer.gather(&slots[0], slots.size(), &batch.images_t[0], &batch.actions[0], &batch.rewards[0],
+                &batch.images_t1[0], &batch.dones[0]);
+  for (size_t p = 0; p < expected.size(); p++)
+  {
+    EXPECT_EQ(expected[p], batch.actions[p]);
+    EXPECT_EQ(expected[p] & 255, batch.images_t[p * OBSERVATION_SIZE]);
+    EXPECT_EQ((expected[p] + 1) & 255, batch.images_t1[(p + 1) * OBSERVATION_SIZE - 1]);
+  }
+}
+
+TEST(StratifiedReplayBuffer, SamplesTheClassMix)
+{
+  const size_t capacities[] = { 50, 50, 50 };
+  StratifiedReplayBuffer buffer(capacities, HEIGHT, WIDTH, DEPTH, 9);
+  for (int i = 0; i < 150; i++)
+  {
+    addTransition(buffer, i, i % 3 == 0 ? 1.0f : i % 3 == 1 ? 0.0f : -1.0f);
+  }
+
+  const double mix[] = { 0.25, 0.5, 0.25 };
+  Batch batch(32);
+  ASSERT_TRUE(batch.sample(buffer, mix));
+  EXPECT_EQ(8u, batch.counts[0]);
+  EXPECT_EQ(16u, batch.counts[1]);
+  EXPECT_EQ(8u, batch.counts[2]);
+
+  // Ordered by class, distinct within each class
+  std::set<int> drawn;
+  for (size_t k = 0; k < 32; k++)
+  {
+    const int expected_class = k < 8 ? 0 : k < 24 ? 1 : 2;
+    EXPECT_EQ(expected_class, (int)StratifiedReplayBuffer::classify(batch.rewards[k]));
+    EXPECT_EQ(expected_class, batch.actions[k] % 3);
+    drawn.insert(batch.actions[k]);
+  }
+  EXPECT_EQ(32u, drawn.size());
+}
+
+TEST(StratifiedReplayBuffer, GivesTheShareOfAnEmptyClassToTheOthers)
+{
+  const size_t capacities[] = { 10, 10, 10 };
+  StratifiedReplayBuffer buffer(capacities, HEIGHT, WIDTH, DEPTH, 4);
+  Batch batch(10);
+  const double mix[] = { 0.5, 0.5, 0.0 };
+  EXPECT_FALSE(batch.sample(buffer, mix));
+
+  // Two positives and no neutrals: the batch takes the positives with replacement
+  addTransition(buffer, 1, 1.0f);
+  addTransition(buffer, 2, 1.0f);
+  addTransition(buffer, 3, -1.0f);
+  ASSERT_TRUE(batch.sample(buffer, mix));
+  EXPECT_EQ(10u, batch.counts[0]);
+  for (size_t k = 0; k < 10; k++)
+  {
+    EXPECT_TRUE(batch.actions[k] == 1 || batch.actions[k] == 2);
+  }
+
+  // Only a class excluded by the mix holds transitions
+  const double only_neutral[] = { 0.0, 1.0, 0.0 };
+  StratifiedReplayBuffer negatives(capacities, HEIGHT, WIDTH, DEPTH);
+  addTransition(negatives, 7, -1.0f);
+  ASSERT_TRUE(batch.sample(negatives, only_neutral));
+  EXPECT_EQ(10u, batch.counts[2]);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,211 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Timeline of the spans of a node written as Chrome trace events.
+*/
+
+#include "../include/traceRecorder.h"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+// Pause of the writer thread when the rings are empty, the file is flushed at every pause
+const std::chrono::milliseconds IDLE_PERIOD(50);
+
+// Every opening of a recorder has its own generation, so that the threads do not reuse the rings of another one
+std::atomic<uint64_t> next_generation(1);
+
+// Rings of the calling thread in the recorders it has used lately
+struct CachedRing
+{
+  uint64_t generation;
+  void *ring;
+};
+const int CACHED_RINGS = 4;
+thread_local CachedRing cached_rings[CACHED_RINGS];
+thread_local int next_cached_ring = 0;
+}
+
+TraceRecorder::TraceRecorder()
+  : file_(NULL), first_event_(true), origin_(0), ring_size_(0), generation_(0), enabled_(false), written_(0),
+    stop_(false)
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+  close();
+}
+
+bool TraceRecorder::open(const std::string &path, size_t ring_size)
+{
+  close();
+  file_ = fopen(path.c_str(), "w");
+  if (file_ == NULL)
+  {
+    return false;
+  }
+  fputs("{\"traceEvents\":[\n", file_);
+  first_event_ = true;
+
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    for (size_t r = 0; r < rings_.size(); r++)
+    {
+      retired_rings_.push_back(std::move(rings_[r]));
+    }
+    rings_.clear();
+  }
+  ring_size_.store(std::max<size_t>(ring_size, 1), std::memory_order_relaxed);
+  // The threads see the new ring size with the new generation
+  generation_.store(next_generation.fetch_add(1), std::memory_order_release);
+  origin_ = now();
+  written_.store(0);
+  stop_.store(false);
+  enabled_.store(true, std::memory_order_release);
+  thread_ = std::thread(&TraceRecorder::write, this);
+  return true;
+}
+
+void TraceRecorder::close()
+{
+  if (thread_.joinable() == false)
+  {
+    return;
+  }
+  enabled_.store(false, std::memory_order_release);
+  stop_.store(true, std::memory_order_release);
+  thread_.join();
+  fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file_);
+  fclose(file_);
+  file_ = NULL;
+}
+
+TraceRecorder::Ring *TraceRecorder::ring()
+{
+  const uint64_t generation = generation_.load(std::memory_order_acquire);
+  for (int i = 0; i < CACHED_RINGS; i++)
+  {
+    if (cached_rings[i].generation == generation)
+    {
+      return static_cast<Ring *>(cached_rings[i].ring);
+    }
+  }
+
+  // First event of the thread: its ring is created once
+  Ring *ring = new Ring();
+  ring->events.resize(ring_size_.load(std::memory_order_relaxed));
+  ring->tid = syscall(SYS_gettid);
+  ring->head.store(0);
+  ring->tail.store(0);
+  ring->dropped.store(0);
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings_.push_back(std::unique_ptr<Ring>(ring));
+  }
+  CachedRing &cached = cached_rings[next_cached_ring];
+  next_cached_ring = (next_cached_ring + 1) % CACHED_RINGS;
+  cached.generation = generation;
+  cached.ring = ring;
+  return ring;
+}
+
+void TraceRecorder::push(const char *name, int64_t begin, int64_t end, uint64_t arg)
+{
+  Ring *ring = this->ring();
+  const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+  if (tail - ring->head.load(std::memory_order_acquire) >= ring->events.size())
+  {
+    ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Event &event = ring->events[tail % ring->events.size()];
+  event.name = name;
+  event.begin = begin;
+  event.end = end;
+  event.arg = arg;
+  // The writer thread sees the event only after its content
+  ring->tail.store(tail + 1, std::memory_order_release);
+}
+
+bool TraceRecorder::drain()
+{
+  const int pid = getpid();
+  bool drained = false;
+  // The recording threads take the lock only to add their ring
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  for (size_t r = 0; r < rings_.size(); r++)
+  {
+    Ring &ring = *rings_[r];
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    const uint64_t tail = ring.tail.load(std::memory_order_acquire);
+    for (; head != tail; head++)
+    {
+      const Event &event = ring.events[head % ring.events.size()];
+      // Timestamps in microseconds
+      const double ts = (event.begin - origin_) * 1e-3;
+      fputs(first_event_ ? "" : ",\n", file_);
+      first_event_ = false;
+      if (event.end >= 0)
+      {
+        fprintf(file_, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%ld,"
+                       "\"args\":{\"arg\":%llu}}",
+                event.name, ts, (event.end - event.begin) * 1e-3, pid, ring.tid, (unsigned long long)event.arg);
+      }
+      else
+      {
+        fprintf(file_, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%ld,"
+                       "\"args\":{\"arg\":%llu}}",
+                event.name, ts, pid, ring.tid, (unsigned long long)event.arg);
+      }
+      written_.fetch_add(1, std::memory_order_relaxed);
+      // The slot can be reused by the recording thread
+      ring.head.store(head + 1, std::memory_order_release);
+      drained = true;
+    }
+  }
+  return drained;
+}
+
+void TraceRecorder::write()
+{
+  while (true)
+  {
+    const bool stop = stop_.load(std::memory_order_acquire);
+    const bool drained = drain();
+    if (stop)
+    {
+      break;
+    }
+    if (drained == false)
+    {
+      fflush(file_);
+      std::this_thread::sleep_for(IDLE_PERIOD);
+    }
+  }
+}
+
+uint64_t TraceRecorder::getWritten() const
+{
+  return written_.load(std::memory_order_relaxed);
+}
+
+uint64_t TraceRecorder::getDropped()
+{
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  uint64_t dropped = 0;
+  for (size_t r = 0; r < rings_.size(); r++)
+  {
+    dropped += rings_[r]->dropped.load(std::memory_order_relaxed);
+  }
+  return dropped;
+}
@@ -0,0 +1,178 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Records the transitions observed by a node in a replay file from a writer thread.
+*/
+
+#include "../include/transitionRecorder.h"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+// Pause of the writer thread when the ring is empty, the file is committed at every pause
+const std::chrono::milliseconds IDLE_PERIOD(5);
+}
+
+TransitionRecorder::TransitionRecorder()
+  : observation_size_(0), head_(0), written_(0), tail_(0), dropped_(0), stop_(false), open_(NULL)
+{
+}
+
+TransitionRecorder::~TransitionRecorder()
+{
+  close();
+}
+
+bool TransitionRecorder::open(const std::string &path, int height, int width, int depth, size_t slots,
+                              uint32_t user_flags)
+{
+  close();
+  if (writer_.open(path, height, width, depth) == false)
+  {
+    return false;
+  }
+  if (writer_.getSize() == 0)
+  {
+    writer_.setUserFlags(user_flags);
+  }
+  else if (writer_.getUserFlags() != user_flags)
+  {
+    writer_.close();
+    return false;
+  }
+
+  observation_size_ = writer_.getObservationSize();
+  slots = std::max<size_t>(slots, 1);
+  records_.assign(slots, Record());
+  images_.assign(slots * 2 * observation_size_, 0);
+  for (size_t i = 0; i < slots; i++)
+  {
+    records_[i].image_t = &images_[2 * i * observation_size_];
+    records_[i].image_t1 = &images_[(2 * i + 1) * observation_size_];
+  }
+  head_.store(0);
+  written_.store(0);
+  tail_.store(0);
+  dropped_.store(0);
+  stop_.store(false);
+  open_ = NULL;
+  thread_ = std::thread(&TransitionRecorder::write, this);
+  return true;
+}
+
+void TransitionRecorder::close()
+{
+  if (thread_.joinable() == false)
+  {
+    return;
+  }
+  open_ = NULL;
+  stop_.store(true, std::memory_order_release);
+  thread_.join();
+  writer_.close();
+  records_.clear();
+  std::vector<uint8_t>().swap(images_);
+}
+
+bool TransitionRecorder::isOpen() const
+{
+  return thread_.joinable();
+}
+
+TransitionRecorder::Record *TransitionRecorder::beginRecord()
+{
+  if (open_ != NULL || isOpen() == false)
+  {
+    return open_;
+  }
+  const uint64_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) >= records_.size())
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return NULL;
+  }
+  open_ = &records_[tail % records_.size()];
+  return open_;
+}
+
+void TransitionRecorder::endRecord()
+{
+  if (open_ == NULL)
+  {
+    return;
+  }
+  open_ = NULL;
+  // The writer thread sees the slot only after its content
+  tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void TransitionRecorder::cancelRecord()
+{
+  open_ = NULL;
+}
+
+void TransitionRecorder::write()
+{
+  bool pending = false;
+  while (true)
+  {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    const bool stop = stop_.load(std::memory_order_acquire);
+    const uint64_t tail = tail_.load(std::memory_order_acquire);
+    if (head == tail)
+    {
+      if (stop)
+      {
+        break;
+      }
+      // Make what has been written visible to the readers of the file while there is time
+      if (pending)
+      {
+        writer_.commit();
+        pending = false;
+      }
+      std::this_thread::sleep_for(IDLE_PERIOD);
+      continue;
+    }
+
+    for (; head != tail; head++)
+    {
+      const Record &record = records_[head % records_.size()];
+      if (writer_.append(record.image_t, record.action, record.reward, record.image_t1, record.done,
+                         record.position) == false)
+      {
+        // The file cannot grow (disk full): keep draining the ring, the producer must not stall
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+      }
+      else
+      {
+        written_.fetch_add(1, std::memory_order_relaxed);
+      }
+      // The slot can be reused by the producer
+      head_.store(head + 1, std::memory_order_release);
+    }
+    pending = true;
+  }
+}
+
+size_t TransitionRecorder::getObservationSize() const
+{
+  return observation_size_;
+}
+
+uint64_t TransitionRecorder::getRecorded() const
+{
+  return written_.load(std::memory_order_relaxed);
+}
+
+uint64_t TransitionRecorder::getDropped() const
+{
+  return dropped_.load(std::memory_order_relaxed);
+}
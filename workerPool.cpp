@@ -0,0 +1,116 @@
+/*
+  The MIT License (MIT)
+  Copyright (c) 2017 Riccardo Polvara
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+  #MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+  #CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+  #SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+  Persistent threads splitting a range of work items.
+*/
+
+#include "../include/workerPool.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(int workers)
+{
+  if (workers <= 0)
+  {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  job_ = NULL;
+  count_ = 0;
+  generation_ = 0;
+  pending_ = 0;
+  stop_ = false;
+  for (int w = 1; w < workers; w++)
+  {
+    threads_.push_back(std::thread(&WorkerPool::work, this, w));
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cond_.notify_all();
+  for (size_t i = 0; i < threads_.size(); i++)
+  {
+    threads_[i].join();
+  }
+}
+
+void WorkerPool::range(int worker, size_t *begin, size_t *end) const
+{
+  const size_t workers = threads_.size() + 1;
+  *begin = count_ * worker / workers;
+  *end = count_ * (worker + 1) / workers;
+}
+
+void WorkerPool::work(int worker)
+{
+  uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    start_cond_.wait(lock, [&] { return stop_ || generation_ != seen; });
+    if (stop_)
+    {
+      return;
+    }
+    seen = generation_;
+    size_t begin, end;
+    range(worker, &begin, &end);
+    const Job *job = job_;
+    lock.unlock();
+    if (begin < end)
+    {
+      (*job)(begin, end, worker);
+    }
+    lock.lock();
+    if (--pending_ == 0)
+    {
+      done_cond_.notify_one();
+    }
+  }
+}
+
+void WorkerPool::run(size_t count, const Job &job, size_t min_per_worker)
+{
+  if (threads_.empty() || count < 2 * std::max<size_t>(min_per_worker, 1))
+  {
+    // Not worth waking up the threads
+    if (count > 0)
+    {
+      job(0, count, 0);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  size_t begin, end;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = &job;
+    count_ = count;
+    pending_ = threads_.size();
+    generation_++;
+    range(0, &begin, &end);
+  }
+  start_cond_.notify_all();
+  if (begin < end)
+  {
+    job(begin, end, 0);
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cond_.wait(lock, [&] { return pending_ == 0; });
+  job_ = NULL;
+}
+
+int WorkerPool::getSize() const
+{
+  return threads_.size() + 1;
+}